@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "write.h"
+#include "read/read.h"
+
+#define BENCH_BINARY_RECORDS 20000
+#define BENCH_BINARY_ITERATIONS 10
+
+/// @brief Build the corpus shared by the text and binary benchmarks: an array of records
+/// mixing integers, floats, short strings, booleans and nested containers
+/// @return JSON text of the corpus
+static String *bench_binary_corpus(void)
+{
+    String *text = types_string_create_from_literal("[");
+    types_string_reserve(text, BENCH_BINARY_RECORDS * 160);
+    char record[256];
+    for (size_t i = 0; i < BENCH_BINARY_RECORDS; i++)
+    {
+        snprintf(record, sizeof(record),
+                 "%s{\"id\":%zu,\"name\":\"user %zu\",\"score\":%zu.%02zu,\"active\":%s,"
+                 "\"tags\":[\"alpha\",\"beta\"],\"position\":{\"x\":%zu,\"y\":-%zu}}",
+                 i == 0 ? "" : ",", i, i * 7919 % 100003, i % 1000, i % 100, i % 3 == 0 ? "true" : "false", i % 640, i % 480);
+        String *element = types_string_create_from_literal(record);
+        types_string_join_in_place(text, element);
+        types_string_free(element);
+        free(element);
+    }
+    String *end = types_string_create_from_literal("]");
+    types_string_join_in_place(text, end);
+    types_string_free(end);
+    free(end);
+    return text;
+}
+
+/// @brief Decode the corpus in one format several times, reporting the encoded size as bytes
+/// @param name Name of the benchmark
+/// @param format Format to decode
+static void bench_binary_read(const char *name, const Format format)
+{
+    String *text = bench_binary_corpus();
+    Node *node = read_from_string(text);
+    String *input = format == FORMAT_JSON ? text : (format == FORMAT_CBOR ? write_to_cbor(node) : write_to_msgpack(node));
+    node_destroy(node);
+
+    size_t bytes = 0;
+    const uint64_t start = bench_start();
+    for (size_t i = 0; i < BENCH_BINARY_ITERATIONS; i++)
+    {
+        Node *decoded = format == FORMAT_JSON ? read_from_string(input) : (format == FORMAT_CBOR ? read_from_cbor(input) : read_from_msgpack(input));
+        bytes += types_string_length(input);
+        node_destroy(decoded);
+    }
+    bench_report(name, BENCH_BINARY_ITERATIONS, bytes, bench_now() - start);
+    if (input != text)
+    {
+        types_string_free(input);
+        free(input);
+    }
+    types_string_free(text);
+    free(text);
+}
+
+/// @brief Encode the corpus in one format several times, reporting the output size as bytes
+/// @param name Name of the benchmark
+/// @param format Format to encode
+static void bench_binary_write(const char *name, const Format format)
+{
+    String *text = bench_binary_corpus();
+    Node *node = read_from_string(text);
+    size_t bytes = 0;
+    const uint64_t start = bench_start();
+    for (size_t i = 0; i < BENCH_BINARY_ITERATIONS; i++)
+    {
+        String *output = format == FORMAT_JSON ? write_to_string(node) : (format == FORMAT_CBOR ? write_to_cbor(node) : write_to_msgpack(node));
+        bytes += types_string_length(output);
+        types_string_free(output);
+        free(output);
+    }
+    bench_report(name, BENCH_BINARY_ITERATIONS, bytes, bench_now() - start);
+    node_destroy(node);
+    types_string_free(text);
+    free(text);
+}
+
+static void bench_binary_read_json(const char *name)
+{
+    bench_binary_read(name, FORMAT_JSON);
+}
+
+static void bench_binary_read_cbor(const char *name)
+{
+    bench_binary_read(name, FORMAT_CBOR);
+}
+
+static void bench_binary_read_msgpack(const char *name)
+{
+    bench_binary_read(name, FORMAT_MSGPACK);
+}
+
+static void bench_binary_write_json(const char *name)
+{
+    bench_binary_write(name, FORMAT_JSON);
+}
+
+static void bench_binary_write_cbor(const char *name)
+{
+    bench_binary_write(name, FORMAT_CBOR);
+}
+
+static void bench_binary_write_msgpack(const char *name)
+{
+    bench_binary_write(name, FORMAT_MSGPACK);
+}
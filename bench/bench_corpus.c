@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "types/types_string.h"
+
+/// @brief Approximate size in bytes of each generated corpus
+#define BENCH_CORPUS_SIZE (2 * 1024 * 1024)
+
+/// @brief Nesting of the chains of the deep corpus
+#define BENCH_CORPUS_DEPTH 32
+
+/// @brief Shapes of the generated corpora, each stressing a different part of reading and writing
+typedef enum BenchShape_e
+{
+    BENCH_SHAPE_WIDE,    // A single object with a great many keys
+    BENCH_SHAPE_RECORDS, // A long array of small records sharing their keys
+    BENCH_SHAPE_DEEP,    // An array of chains of objects and arrays nested deep
+    BENCH_SHAPE_NUMBERS, // A long array of integers, decimals and exponents
+    BENCH_SHAPE_STRINGS  // A long array of strings with escapes and multi-byte characters
+} BenchShape;
+
+/// @brief Next number of a xorshift64* generator. The generator starts from the same seed for
+/// every corpus, so the corpora are the same from one run and one machine to the next
+/// @param state State of the generator
+/// @return Pseudo-random number
+static uint64_t bench_corpus_random(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ull;
+}
+
+static void bench_corpus_append(String *text, const char *part)
+{
+    const size_t length = strlen(part);
+    types_string_join_in_place(text, &(String){(char *)part, length, length + 1});
+}
+
+static void bench_corpus_element(String *text, const BenchShape shape, const size_t index, uint64_t *state)
+{
+    static const char *words[] = {"alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta"};
+    static const char *pieces[] = {"plain text ", "say \\\"hi\\\" ", "line\\nbreak ", "tab\\there ", "caf\\u00e9 ",
+                                   "Espa\xc3\xb1" "a ", "\xe6\x97\xa5\xe6\x9c\xac ", "\xf0\x9f\x98\x80 "};
+    char buffer[256];
+    const uint64_t random = bench_corpus_random(state);
+    switch (shape)
+    {
+    case BENCH_SHAPE_WIDE:
+        snprintf(buffer, sizeof(buffer), "%s\"key_%06zu\":%s", index == 0 ? "" : ",", index,
+                 random % 3 == 0 ? "\"value\"" : (random % 3 == 1 ? "12345" : "[true,null]"));
+        bench_corpus_append(text, buffer);
+        break;
+    case BENCH_SHAPE_RECORDS:
+        snprintf(buffer, sizeof(buffer),
+                 "%s{\"id\":%zu,\"name\":\"%s %llu\",\"score\":%llu.%02llu,\"active\":%s,\"tags\":[\"%s\",\"%s\"]}",
+                 index == 0 ? "" : ",", index, words[random % 8], (unsigned long long)(random >> 40),
+                 (unsigned long long)(random >> 20) % 1000, (unsigned long long)(random >> 10) % 100,
+                 random % 2 == 0 ? "true" : "false", words[(random >> 3) % 8], words[(random >> 6) % 8]);
+        bench_corpus_append(text, buffer);
+        break;
+    case BENCH_SHAPE_DEEP:
+        bench_corpus_append(text, index == 0 ? "" : ",");
+        for (size_t depth = 0; depth < BENCH_CORPUS_DEPTH; depth++)
+        {
+            bench_corpus_append(text, depth % 2 == 0 ? "{\"next\":" : "[");
+        }
+        snprintf(buffer, sizeof(buffer), "{\"leaf\":%zu}", index);
+        bench_corpus_append(text, buffer);
+        for (size_t depth = BENCH_CORPUS_DEPTH; depth > 0; depth--)
+        {
+            bench_corpus_append(text, depth % 2 == 1 ? "}" : "]");
+        }
+        break;
+    case BENCH_SHAPE_NUMBERS:
+        if (random % 3 == 0)
+        {
+            snprintf(buffer, sizeof(buffer), "%s%lld", index == 0 ? "" : ",", (long long)(random >> 16) - (1ll << 47));
+        }
+        else if (random % 3 == 1)
+        {
+            snprintf(buffer, sizeof(buffer), "%s%.17g", index == 0 ? "" : ",", (double)(random >> 11) / (1ull << 30));
+        }
+        else
+        {
+            snprintf(buffer, sizeof(buffer), "%s%llue-%llu", index == 0 ? "" : ",", (unsigned long long)(random >> 44), (unsigned long long)(random % 300));
+        }
+        bench_corpus_append(text, buffer);
+        break;
+    case BENCH_SHAPE_STRINGS:
+        bench_corpus_append(text, index == 0 ? "\"" : ",\"");
+        for (size_t piece = 0, count = 2 + random % 6; piece < count; piece++)
+        {
+            bench_corpus_append(text, pieces[bench_corpus_random(state) % 8]);
+        }
+        bench_corpus_append(text, "\"");
+        break;
+    }
+}
+
+/// @brief Generate a corpus of a given shape, the same one every time
+/// @param shape Shape of the corpus
+/// @param size Size in bytes the corpus grows to, roughly
+/// @param elements Where the number of elements of the top array or object is returned
+/// @return JSON text of the corpus
+static String *bench_corpus(const BenchShape shape, const size_t size, size_t *elements)
+{
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    String *text = types_string_create_from_literal(shape == BENCH_SHAPE_WIDE ? "{" : "[");
+    types_string_reserve(text, size + 1024);
+    size_t index = 0;
+    while (types_string_length(text) < size)
+    {
+        bench_corpus_element(text, shape, index++, &state);
+    }
+    bench_corpus_append(text, shape == BENCH_SHAPE_WIDE ? "}" : "]");
+    *elements = index;
+    return text;
+}
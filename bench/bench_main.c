@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "types/types_memory.h"
+
+/// @brief Definition of a benchmark
+typedef struct Benchmark_st
+{
+    const char *name;
+    void (*function)(const char *name);
+} Benchmark;
+
+/// @brief Return the current time of a monotonic clock
+/// @return Time in nanoseconds
+static uint64_t bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/// @brief Allocations recorded when the benchmark being timed started
+static size_t bench_allocations;
+
+/// @brief Start timing a benchmark, and counting the allocations it makes
+/// @return Time in nanoseconds
+static uint64_t bench_start(void)
+{
+    bench_allocations = types_memory_total().allocations;
+    return bench_now();
+}
+
+/// @brief Print the result of a benchmark as a line of JSON, with the allocations made since
+/// bench_start by strings, vectors and nodes
+/// @param name Name of the benchmark
+/// @param iterations Number of operations performed
+/// @param bytes Number of bytes processed by all the operations, or zero if it does not apply
+/// @param elapsed Time taken by all the operations, in nanoseconds
+static void bench_report(const char *name, const size_t iterations, const size_t bytes, const uint64_t elapsed)
+{
+    const double seconds = elapsed / 1e9;
+    const size_t allocations = types_memory_total().allocations - bench_allocations;
+    printf("{\"name\":\"%s\",\"iterations\":%zu,\"bytes\":%zu,\"ns_per_op\":%.1f,\"mb_per_s\":%.1f,\"allocs_per_op\":%.1f}\n",
+           name, iterations, bytes, (double)elapsed / iterations,
+           bytes > 0 && seconds > 0 ? bytes / seconds / 1e6 : 0.0, (double)allocations / iterations);
+    fflush(stdout);
+}
+
+#include "bench_corpus.c"
+#include "bench_read.c"
+#include "bench_write.c"
+#include "bench_types.c"
+#include "bench_binary.c"
+#include "bench_path.c"
+
+int main(int argc, char **argv)
+{
+    const Benchmark benchmarks[] = {
+        // every stage of reading and writing, on generated corpora of different shapes
+        {"corpus_wide", bench_read_wide},
+        {"corpus_records", bench_read_records},
+        {"corpus_deep", bench_read_deep},
+        {"corpus_numbers", bench_read_numbers},
+        {"corpus_strings", bench_read_strings},
+        // containers, at sizes growing by powers of ten
+        {"types_vector_push", bench_types_vector_push_scale},
+        {"types_vector_insert", bench_types_vector_insert_scale},
+        {"types_vector_erase", bench_types_vector_erase_scale},
+        {"types_map_insert", bench_types_map_insert_scale},
+        {"types_map_find", bench_types_map_find_scale},
+        {"types_string_join_in_place", bench_types_string_join_scale},
+        {"types_iterator_find", bench_types_iterator_find_scale},
+        // write
+        {"write_escape_ascii", bench_write_escape_ascii},
+        {"write_escape_utf8", bench_write_escape_utf8},
+        {"write_escape_dense", bench_write_escape_dense},
+        // formats, on the same corpus
+        {"format_read_json", bench_binary_read_json},
+        {"format_read_cbor", bench_binary_read_cbor},
+        {"format_read_msgpack", bench_binary_read_msgpack},
+        {"format_write_json", bench_binary_write_json},
+        {"format_write_cbor", bench_binary_write_cbor},
+        {"format_write_msgpack", bench_binary_write_msgpack},
+        // paths sharing a deep prefix
+        {"path_each", bench_path_each},
+        {"path_trie", bench_path_trie},
+        {"path_descendant_scan", bench_path_descendant_scan},
+        {"path_descendant_index", bench_path_descendant_index},
+        {"path_filter", bench_path_filter},
+        {"path_filter_parallel", bench_path_filter_parallel},
+    };
+
+    // Run every benchmark, or only those whose name contains the argument
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        if (argc > 1 && strstr(benchmarks[i].name, argv[1]) == NULL)
+        {
+            continue;
+        }
+        benchmarks[i].function(benchmarks[i].name);
+    }
+    return 0;
+}
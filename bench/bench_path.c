@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "json_path.h"
+#include "document.h"
+#include "read/read.h"
+
+#define BENCH_PATH_ELEMENTS 4096
+#define BENCH_PATH_ITERATIONS 200
+
+/// @brief Build a document with a long array under a deep prefix, and a path that selects
+/// every element of the array through a union
+/// @param path Where the compiled path is returned
+/// @return Root of the document
+static Node *bench_path_setup(JsonPath **path)
+{
+    String *text = types_string_create_from_literal("{\"a\":{\"b\":{\"c\":{\"d\":{\"e\":{\"f\":{\"list\":[");
+    String *selector = types_string_create_from_literal("$.a.b.c.d.e.f.list[");
+    char element[32];
+    for (size_t i = 0; i < BENCH_PATH_ELEMENTS; i++)
+    {
+        snprintf(element, sizeof(element), "%s%zu", i == 0 ? "" : ",", i);
+        String *part = types_string_create_from_literal(element);
+        types_string_join_in_place(text, part);
+        types_string_join_in_place(selector, part);
+        types_string_free(part);
+        free(part);
+    }
+    String *end = types_string_create_from_literal("]}}}}}}}");
+    types_string_join_in_place(text, end);
+    types_string_free(end);
+    free(end);
+    end = types_string_create_from_literal("]");
+    types_string_join_in_place(selector, end);
+    types_string_free(end);
+    free(end);
+
+    Node *root = read_from_string(text);
+    *path = json_path_parse(selector);
+    types_string_free(selector);
+    free(selector);
+    types_string_free(text);
+    free(text);
+    return root;
+}
+
+static ResultCode bench_path_free_node(void *node)
+{
+    return CODE_OK;
+}
+
+/// @brief Find the end of every path one by one, walking the shared prefix each time
+/// @param name Name of the benchmark
+static void bench_path_each(const char *name)
+{
+    JsonPath *path;
+    Node *root = bench_path_setup(&path);
+    size_t found = 0;
+    const uint64_t start = bench_start();
+    for (size_t i = 0; i < BENCH_PATH_ITERATIONS; i++)
+    {
+        for (size_t j = 0, n = types_vector_size(path->paths); j < n; j++)
+        {
+            found += json_path_evaluate(root, types_vector_at(path->paths, j)) != NULL;
+        }
+    }
+    bench_report(name, BENCH_PATH_ITERATIONS, 0, bench_now() - start);
+    if (found != (size_t)BENCH_PATH_ITERATIONS * BENCH_PATH_ELEMENTS)
+    {
+        printf("{\"name\":\"%s\",\"error\":\"paths not found\"}\n", name);
+    }
+    json_path_free(path);
+    free(path);
+    node_destroy(root);
+}
+
+/// @brief Find the end of every path with a single walk of the trie of the paths
+/// @param name Name of the benchmark
+static void bench_path_trie(const char *name)
+{
+    JsonPath *path;
+    Node *root = bench_path_setup(&path);
+    Vector *nodes = types_vector_create(sizeof(Node *), bench_path_free_node);
+    size_t found = 0;
+    const uint64_t start = bench_start();
+    for (size_t i = 0; i < BENCH_PATH_ITERATIONS; i++)
+    {
+        PathTrie *trie = json_path_trie_create(path);
+        types_vector_clear(nodes);
+        if (json_path_trie_evaluate(root, trie, false, nodes) == CODE_OK)
+        {
+            found += types_vector_size(nodes);
+        }
+        json_path_trie_free(trie);
+        free(trie);
+    }
+    bench_report(name, BENCH_PATH_ITERATIONS, 0, bench_now() - start);
+    if (found != (size_t)BENCH_PATH_ITERATIONS * BENCH_PATH_ELEMENTS)
+    {
+        printf("{\"name\":\"%s\",\"error\":\"paths not found\"}\n", name);
+    }
+    types_vector_free(nodes);
+    free(nodes);
+    json_path_free(path);
+    free(path);
+    node_destroy(root);
+}
+
+/// @brief Find every node below the root with a key, repeatedly, on the shared corpus
+/// @param name Name of the benchmark
+/// @param indexed Indicates if the document has a key index
+static void bench_path_descendant(const char *name, const bool indexed)
+{
+    String *text = bench_binary_corpus();
+    Document *document = document_create(read_from_string(text), NULL);
+    if (indexed)
+    {
+        document_index(document);
+    }
+    String *selector = types_string_create_from_literal("$..y");
+    JsonPath *path = json_path_parse(selector);
+    PathTrie *trie = json_path_trie_create(path);
+    Vector *nodes = types_vector_create(sizeof(Node *), bench_path_free_node);
+    size_t found = 0;
+    const uint64_t start = bench_start();
+    for (size_t i = 0; i < BENCH_PATH_ITERATIONS; i++)
+    {
+        types_vector_clear(nodes);
+        if (json_path_trie_evaluate(document->root, trie, false, nodes) == CODE_OK)
+        {
+            found += types_vector_size(nodes);
+        }
+    }
+    bench_report(name, BENCH_PATH_ITERATIONS, 0, bench_now() - start);
+    if (found != (size_t)BENCH_PATH_ITERATIONS * BENCH_BINARY_RECORDS)
+    {
+        printf("{\"name\":\"%s\",\"error\":\"paths not found\"}\n", name);
+    }
+    types_vector_free(nodes);
+    free(nodes);
+    json_path_trie_free(trie);
+    free(trie);
+    json_path_free(path);
+    free(path);
+    types_string_free(selector);
+    free(selector);
+    document_free(document);
+    types_string_free(text);
+    free(text);
+}
+
+static void bench_path_descendant_scan(const char *name)
+{
+    bench_path_descendant(name, false);
+}
+
+static void bench_path_descendant_index(const char *name)
+{
+    bench_path_descendant(name, true);
+}
+
+/// @brief Filter the records of the shared corpus, repeatedly, with a compiled filter
+/// @param name Name of the benchmark
+/// @param threads Number of threads that evaluate the path
+static void bench_path_filter_threads(const char *name, const size_t threads)
+{
+    ThreadPool *pool = threads > 1 ? thread_pool_create(threads) : NULL;
+    String *text = bench_binary_corpus();
+    Document *document = document_create(read_from_string(text), NULL);
+    String *selector = types_string_create_from_literal("$[?(@.position.x > 320 && @.active == true)]");
+    JsonPath *path = json_path_parse(selector);
+    PathTrie *trie = json_path_trie_create(path);
+    Vector *nodes = types_vector_create(sizeof(Node *), bench_path_free_node);
+    size_t found = 0;
+    const uint64_t start = bench_start();
+    for (size_t i = 0; i < BENCH_PATH_ITERATIONS; i++)
+    {
+        types_vector_clear(nodes);
+        if (json_path_trie_evaluate_parallel(document->root, trie, false, pool, nodes) == CODE_OK)
+        {
+            found += types_vector_size(nodes);
+        }
+    }
+    bench_report(name, BENCH_PATH_ITERATIONS, 0, bench_now() - start);
+
+    // Records are active every third one, and x goes round from 0 to 639
+    size_t expected = 0;
+    for (size_t i = 0; i < BENCH_BINARY_RECORDS; i++)
+    {
+        expected += i % 3 == 0 && i % 640 > 320;
+    }
+    if (found != (size_t)BENCH_PATH_ITERATIONS * expected)
+    {
+        printf("{\"name\":\"%s\",\"error\":\"records not found\"}\n", name);
+    }
+    types_vector_free(nodes);
+    free(nodes);
+    json_path_trie_free(trie);
+    free(trie);
+    json_path_free(path);
+    free(path);
+    types_string_free(selector);
+    free(selector);
+    document_free(document);
+    types_string_free(text);
+    free(text);
+    thread_pool_free(pool);
+}
+
+static void bench_path_filter(const char *name)
+{
+    bench_path_filter_threads(name, 1);
+}
+
+static void bench_path_filter_parallel(const char *name)
+{
+    // One thread for each processor online
+    const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    bench_path_filter_threads(name, processors > 1 ? (size_t)processors : 2);
+}
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "read/read.h"
+#include "read/read_lex.h"
+#include "read/read_parse.h"
+#include "write.h"
+#include "json_path.h"
+
+#define BENCH_READ_ITERATIONS 10
+
+static ResultCode bench_read_free_node(void *node)
+{
+    return CODE_OK;
+}
+
+/// @brief Time every stage of reading and writing on a corpus: the lexer alone, the parser alone
+/// on the tokens of the lexer, both together, the writer, and a path over the tree. Each
+/// stage is reported under the name of the benchmark followed by the stage
+/// @param name Name of the benchmark
+/// @param shape Shape of the corpus
+/// @param selector Path evaluated over the tree
+static void bench_read_shape(const char *name, const BenchShape shape, const char *selector)
+{
+    size_t elements;
+    String *text = bench_corpus(shape, BENCH_CORPUS_SIZE, &elements);
+    const size_t length = types_string_length(text);
+    Vector *tokens = read_tokens_create();
+    char stage[128];
+
+    uint64_t start = bench_start();
+    for (size_t i = 0; i < BENCH_READ_ITERATIONS; i++)
+    {
+        read_lex(read_lex_default(), text, tokens);
+    }
+    snprintf(stage, sizeof(stage), "%s/lex", name);
+    bench_report(stage, BENCH_READ_ITERATIONS, length * BENCH_READ_ITERATIONS, bench_now() - start);
+
+    start = bench_start();
+    for (size_t i = 0; i < BENCH_READ_ITERATIONS; i++)
+    {
+        node_destroy(read_parse(text, tokens));
+    }
+    snprintf(stage, sizeof(stage), "%s/parse", name);
+    bench_report(stage, BENCH_READ_ITERATIONS, length * BENCH_READ_ITERATIONS, bench_now() - start);
+
+    start = bench_start();
+    for (size_t i = 0; i < BENCH_READ_ITERATIONS; i++)
+    {
+        node_destroy(read_from_string(text));
+    }
+    snprintf(stage, sizeof(stage), "%s/read", name);
+    bench_report(stage, BENCH_READ_ITERATIONS, length * BENCH_READ_ITERATIONS, bench_now() - start);
+
+    // The writer formats every node, as the tree was not read from a document
+    Node *root = read_from_string(text);
+    size_t written = 0;
+    start = bench_start();
+    for (size_t i = 0; i < BENCH_READ_ITERATIONS; i++)
+    {
+        String *output = write_to_string(root);
+        written += output != NULL ? types_string_length(output) : 0;
+        types_string_free(output);
+        free(output);
+    }
+    snprintf(stage, sizeof(stage), "%s/write", name);
+    bench_report(stage, BENCH_READ_ITERATIONS, written, bench_now() - start);
+
+    String *path_text = types_string_create_from_literal(selector);
+    JsonPath *path = json_path_parse(path_text);
+    Vector *nodes = types_vector_create(sizeof(Node *), bench_read_free_node);
+    size_t found = 0;
+    start = bench_start();
+    for (size_t i = 0; i < BENCH_READ_ITERATIONS; i++)
+    {
+        PathTrie *trie = json_path_trie_create(path);
+        types_vector_clear(nodes);
+        if (json_path_trie_evaluate(root, trie, false, nodes) == CODE_OK)
+        {
+            found += types_vector_size(nodes);
+        }
+        json_path_trie_free(trie);
+        free(trie);
+    }
+    snprintf(stage, sizeof(stage), "%s/path", name);
+    bench_report(stage, BENCH_READ_ITERATIONS, 0, bench_now() - start);
+    if (found != (size_t)BENCH_READ_ITERATIONS * elements)
+    {
+        printf("{\"name\":\"%s\",\"error\":\"paths not found\"}\n", stage);
+    }
+
+    types_vector_free(nodes);
+    free(nodes);
+    json_path_free(path);
+    free(path);
+    types_string_free(path_text);
+    free(path_text);
+    node_destroy(root);
+    types_vector_free(tokens);
+    free(tokens);
+    types_string_free(text);
+    free(text);
+}
+
+static void bench_read_wide(const char *name)
+{
+    bench_read_shape(name, BENCH_SHAPE_WIDE, "$.*");
+}
+
+static void bench_read_records(const char *name)
+{
+    bench_read_shape(name, BENCH_SHAPE_RECORDS, "$[*].name");
+}
+
+static void bench_read_deep(const char *name)
+{
+    bench_read_shape(name, BENCH_SHAPE_DEEP, "$..leaf");
+}
+
+static void bench_read_numbers(const char *name)
+{
+    bench_read_shape(name, BENCH_SHAPE_NUMBERS, "$[*]");
+}
+
+static void bench_read_strings(const char *name)
+{
+    bench_read_shape(name, BENCH_SHAPE_STRINGS, "$[*]");
+}
@@ -0,0 +1,251 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "types/types_vector.h"
+#include "types/types_map.h"
+#include "types/types_string.h"
+#include "types/types_iterator.h"
+
+/// @brief Smallest and largest number of elements a container is measured with, by powers of ten
+#define BENCH_TYPES_MIN_SIZE 10
+#define BENCH_TYPES_MAX_SIZE 10000000
+
+/// @brief Operations repeated at every size at least, so the small sizes take measurable time
+#define BENCH_TYPES_MIN_OPERATIONS 100000
+
+/// @brief Nanoseconds a size may take before the larger sizes are skipped, as a super-linear
+/// operation would take minutes at the largest ones
+#define BENCH_TYPES_BUDGET 500000000u
+
+/// @brief Smallest size used to fit the growth, below which fixed costs hide it
+#define BENCH_TYPES_FIT_SIZE 1000
+
+/// @brief Growth exponent above which an operation is flagged as super-linear
+#define BENCH_TYPES_SUPERLINEAR 1.25
+
+/// @brief Work of a given size on a container: the operations the benchmark measures, done
+/// as many times as there are elements, or a single pass over that many elements
+/// @param size Number of elements
+typedef void (*BenchTypesWork)(const size_t size);
+
+static ResultCode bench_types_free_nothing(void *element)
+{
+    return CODE_OK;
+}
+
+static ResultCode bench_types_free_pointer(void *element)
+{
+    free(element);
+    return CODE_OK;
+}
+
+static bool bench_types_compare(const void *key1, const void *key2)
+{
+    // Maps take equal keys to compare as zero
+    return *(const size_t *)key1 != *(const size_t *)key2;
+}
+
+static void *bench_types_copy(const void *key)
+{
+    size_t *copy = malloc(sizeof(size_t));
+    *copy = *(const size_t *)key;
+    return copy;
+}
+
+static size_t bench_types_hash(const void *key)
+{
+    return *(const size_t *)key * 0x9e3779b97f4a7c15ull;
+}
+
+static Map *bench_types_map(const size_t size)
+{
+    Map *map = types_map_create(sizeof(size_t), sizeof(size_t), bench_types_free_pointer, bench_types_free_pointer,
+                                bench_types_compare, bench_types_copy, bench_types_copy, bench_types_hash);
+    for (size_t i = 0; i < size; i++)
+    {
+        types_map_insert(map, &i, &i);
+    }
+    return map;
+}
+
+static Vector *bench_types_vector(const size_t size)
+{
+    Vector *vector = types_vector_create(sizeof(size_t), bench_types_free_nothing);
+    for (size_t i = 0; i < size; i++)
+    {
+        types_vector_push(vector, &i);
+    }
+    return vector;
+}
+
+static void bench_types_vector_free(Vector *vector)
+{
+    types_vector_free(vector);
+    free(vector);
+}
+
+static void bench_types_vector_push(const size_t size)
+{
+    bench_types_vector_free(bench_types_vector(size));
+}
+
+static void bench_types_vector_insert(const size_t size)
+{
+    // One element at a time, always at the end, so no element is ever moved
+    Vector *vector = types_vector_create(sizeof(size_t), bench_types_free_nothing);
+    for (size_t i = 0; i < size; i++)
+    {
+        Iterator element = types_iterator_create(&i, sizeof(size_t));
+        types_vector_insert(vector, element, types_iterator_increase(element, 1), types_vector_end(vector));
+    }
+    bench_types_vector_free(vector);
+}
+
+static void bench_types_vector_erase(const size_t size)
+{
+    // One element at a time from the end, so no element is ever moved either
+    Vector *vector = bench_types_vector(size);
+    for (size_t i = size; i > 0; i--)
+    {
+        Iterator end = types_vector_end(vector);
+        types_vector_erase(vector, types_iterator_decrease(end, 1), end);
+    }
+    bench_types_vector_free(vector);
+}
+
+static void bench_types_map_insert(const size_t size)
+{
+    Map *map = bench_types_map(size);
+    types_map_free(map);
+    free(map);
+}
+
+static void bench_types_map_find(const size_t size)
+{
+    // Every key once, in an order unrelated to the order of insertion
+    Map *map = bench_types_map(size);
+    size_t found = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        const size_t key = i * 7919 % size;
+        found += types_iterator_get(types_map_find(map, &key)) != NULL;
+    }
+    if (found != size)
+    {
+        printf("{\"name\":\"types_map_find\",\"error\":\"keys not found\"}\n");
+    }
+    types_map_free(map);
+    free(map);
+}
+
+static void bench_types_string_join(const size_t size)
+{
+    String *string = types_string_create();
+    const String piece = {"0123456789abcdef", 16, 17};
+    for (size_t i = 0; i < size; i++)
+    {
+        types_string_join_in_place(string, &piece);
+    }
+    types_string_free(string);
+    free(string);
+}
+
+/// @brief Elements searched by types_iterator_find, built once for all the sizes
+static Vector *bench_types_haystack;
+
+static void bench_types_iterator_find(const size_t size)
+{
+    // A single search through the first elements, for the last of them
+    const size_t last = size - 1;
+    Iterator first = types_vector_begin(bench_types_haystack);
+    if (*(size_t *)types_iterator_get(types_iterator_find(first, types_iterator_increase(first, size), &last)) != last)
+    {
+        printf("{\"name\":\"types_iterator_find\",\"error\":\"element not found\"}\n");
+    }
+}
+
+/// @brief Measure some work at sizes growing by powers of ten, report the time per element at
+/// each one, and fit the exponent of the growth of the time with the size. Linear work has an
+/// exponent close to one, quadratic work close to two
+/// @param name Name of the benchmark
+/// @param work Work measured
+static void bench_types_scale(const char *name, BenchTypesWork work)
+{
+    char label[128];
+    double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+    size_t points = 0;
+    size_t size = BENCH_TYPES_MIN_SIZE;
+    for (; size <= BENCH_TYPES_MAX_SIZE; size *= 10)
+    {
+        const size_t repetitions = size < BENCH_TYPES_MIN_OPERATIONS ? BENCH_TYPES_MIN_OPERATIONS / size : 1;
+        const uint64_t start = bench_start();
+        for (size_t i = 0; i < repetitions; i++)
+        {
+            work(size);
+        }
+        const uint64_t elapsed = bench_now() - start;
+        snprintf(label, sizeof(label), "%s/%zu", name, size);
+        bench_report(label, size * repetitions, 0, elapsed);
+
+        // The time of a single run of the work, on a logarithmic scale
+        if (size >= BENCH_TYPES_FIT_SIZE)
+        {
+            const double x = log((double)size);
+            const double y = log((double)elapsed / repetitions);
+            sum_x += x;
+            sum_y += y;
+            sum_xx += x * x;
+            sum_xy += x * y;
+            points += 1;
+        }
+        if (elapsed > BENCH_TYPES_BUDGET)
+        {
+            break;
+        }
+    }
+
+    // Least squares slope of the time against the size, both on a logarithmic scale
+    const double exponent = points > 1 ? (points * sum_xy - sum_x * sum_y) / (points * sum_xx - sum_x * sum_x) : 0.0;
+    printf("{\"name\":\"%s\",\"largest\":%zu,\"exponent\":%.2f,\"superlinear\":%s}\n", name,
+           size > BENCH_TYPES_MAX_SIZE ? BENCH_TYPES_MAX_SIZE : size, exponent,
+           exponent > BENCH_TYPES_SUPERLINEAR ? "true" : "false");
+    fflush(stdout);
+}
+
+static void bench_types_vector_push_scale(const char *name)
+{
+    bench_types_scale(name, bench_types_vector_push);
+}
+
+static void bench_types_vector_insert_scale(const char *name)
+{
+    bench_types_scale(name, bench_types_vector_insert);
+}
+
+static void bench_types_vector_erase_scale(const char *name)
+{
+    bench_types_scale(name, bench_types_vector_erase);
+}
+
+static void bench_types_map_insert_scale(const char *name)
+{
+    bench_types_scale(name, bench_types_map_insert);
+}
+
+static void bench_types_map_find_scale(const char *name)
+{
+    bench_types_scale(name, bench_types_map_find);
+}
+
+static void bench_types_string_join_scale(const char *name)
+{
+    bench_types_scale(name, bench_types_string_join);
+}
+
+static void bench_types_iterator_find_scale(const char *name)
+{
+    bench_types_haystack = bench_types_vector(BENCH_TYPES_MAX_SIZE);
+    bench_types_scale(name, bench_types_iterator_find);
+    bench_types_vector_free(bench_types_haystack);
+}
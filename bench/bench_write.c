@@ -0,0 +1,56 @@
+#include <stdlib.h>
+
+#include "write.h"
+#include "node.h"
+
+#define BENCH_WRITE_STRING_LENGTH (1 << 20)
+#define BENCH_WRITE_ITERATIONS 200
+
+static void bench_write_string(const char *name, const char *pattern, const size_t pattern_length)
+{
+    // Fill a long string by repeating the pattern
+    char *text = malloc(BENCH_WRITE_STRING_LENGTH + 1);
+    for (size_t i = 0; i < BENCH_WRITE_STRING_LENGTH; i++)
+    {
+        text[i] = pattern[i % pattern_length];
+    }
+    text[BENCH_WRITE_STRING_LENGTH] = '\0';
+    Node *node = node_create();
+    node->type = NODE_TYPE_STRING;
+    node->data = types_string_create_from_literal(text);
+    free(text);
+
+    // Serialize it several times
+    size_t bytes = 0;
+    const uint64_t start = bench_start();
+    for (size_t i = 0; i < BENCH_WRITE_ITERATIONS; i++)
+    {
+        String *output = write_to_string(node);
+        bytes += BENCH_WRITE_STRING_LENGTH;
+        types_string_free(output);
+        free(output);
+    }
+    bench_report(name, BENCH_WRITE_ITERATIONS, bytes, bench_now() - start);
+    node_destroy(node);
+}
+
+static void bench_write_escape_ascii(const char *name)
+{
+    // Plain text, nothing to escape
+    const char *pattern = "The quick brown fox jumps over the lazy dog. ";
+    bench_write_string(name, pattern, strlen(pattern));
+}
+
+static void bench_write_escape_utf8(const char *name)
+{
+    // Multi-byte characters, nothing to escape
+    const char *pattern = "Espa\xc3\xb1" "a, \xe2\x82\xac 10, \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e, \xf0\x9f\x98\x80. ";
+    bench_write_string(name, pattern, strlen(pattern));
+}
+
+static void bench_write_escape_dense(const char *name)
+{
+    // Lines of text with quotes, one escape every few characters
+    const char *pattern = "say \"hi\"\n";
+    bench_write_string(name, pattern, strlen(pattern));
+}
@@ -0,0 +1,49 @@
+#include "document.h"
+
+Document *document_create(Node *root, String *source)
+{
+    if (root == NULL)
+    {
+        return NULL;
+    }
+    Document *document = malloc(sizeof(Document));
+    if (document == NULL)
+    {
+        return NULL;
+    }
+    document->root = root;
+    document->source = source;
+    document->index = NULL;
+    return document;
+}
+
+ResultCode document_index(Document *document)
+{
+    if (document == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if (document->index != NULL)
+    {
+        return CODE_OK;
+    }
+    document->index = node_index_create(document->root);
+    return document->index != NULL ? CODE_OK : CODE_MEMORY_ERROR;
+}
+
+ResultCode document_free(Document *document)
+{
+    if (document == NULL)
+    {
+        return CODE_OK;
+    }
+    ResultCode result = node_destroy(document->root);
+    node_index_free(document->index);
+    if (document->source != NULL)
+    {
+        types_string_free(document->source);
+        free(document->source);
+    }
+    free(document);
+    return result;
+}
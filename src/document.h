@@ -0,0 +1,35 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include "node.h"
+#include "node_index.h"
+#include "utils.h"
+
+/// @brief A tree of nodes together with the text it was read from. Nodes that have
+/// not changed since they were read are written back by copying their span of the text
+typedef struct Document_st
+{
+    Node *root;       // Root of the tree
+    String *source;   // Text the tree was read from, NULL if the tree was built from scratch
+    NodeIndex *index; // Index of the keys of the tree, NULL until document_index is called
+} Document;
+
+/// @brief Create a document that takes ownership of a tree and of its source text
+/// @param root Root of the tree
+/// @param source Text the tree was read from, or NULL
+/// @retval Document
+/// @retval NULL if a problem was encountered
+Document *document_create(Node *root, String *source);
+
+/// @brief Index the keys of the tree, so queries by key anywhere in it take time proportional
+/// to the number of matches. The index is kept up to date as the tree changes
+/// @param document Document
+/// @return Result code
+ResultCode document_index(Document *document);
+
+/// @brief Free the tree, the source text and the document itself
+/// @param document Document
+/// @return Result code
+ResultCode document_free(Document *document);
+
+#endif
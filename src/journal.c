@@ -0,0 +1,261 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+
+static void journal_header(const String *base, unsigned char *header);
+static uint32_t journal_checksum(const char *buffer, const size_t length);
+static void journal_encode(unsigned char *buffer, uint64_t value, const size_t bytes);
+static uint64_t journal_decode(const unsigned char *buffer, const size_t bytes);
+static ResultCode journal_write(const int fd, const void *buffer, const size_t length);
+
+Journal *journal_open(const String *filename, const String *base)
+{
+    if (filename == NULL || base == NULL)
+    {
+        return NULL;
+    }
+    Journal *journal = malloc(sizeof(Journal));
+    if (journal == NULL)
+    {
+        return NULL;
+    }
+    journal->path = types_string_copy(filename);
+    const String suffix = {JOURNAL_SUFFIX, strlen(JOURNAL_SUFFIX), strlen(JOURNAL_SUFFIX) + 1};
+    if (journal->path == NULL || types_string_join_in_place(journal->path, &suffix) != CODE_OK)
+    {
+        if (journal->path != NULL)
+        {
+            types_string_free(journal->path);
+            free(journal->path);
+        }
+        free(journal);
+        return NULL;
+    }
+    journal->fd = open(types_string_c_str(journal->path), O_RDWR | O_CREAT, 0644);
+    journal->size = 0;
+    journal->stale = false;
+
+    // A journal that exists must have been started for this very text
+    unsigned char expected[JOURNAL_HEADER_SIZE];
+    unsigned char found[JOURNAL_HEADER_SIZE];
+    journal_header(base, expected);
+    struct stat journal_stat;
+    if (journal->fd < 0 || fstat(journal->fd, &journal_stat) != 0)
+    {
+        journal_close(journal);
+        return NULL;
+    }
+    if (journal_stat.st_size > 0)
+    {
+        journal->stale = journal_stat.st_size < JOURNAL_HEADER_SIZE ||
+                         pread(journal->fd, found, JOURNAL_HEADER_SIZE, 0) != JOURNAL_HEADER_SIZE ||
+                         memcmp(found, expected, JOURNAL_HEADER_SIZE) != 0;
+    }
+    if (journal_stat.st_size == 0 || journal->stale)
+    {
+        if (journal_reset(journal, base) != CODE_OK)
+        {
+            journal_close(journal);
+            return NULL;
+        }
+        return journal;
+    }
+    journal->size = journal_stat.st_size;
+    if (lseek(journal->fd, 0, SEEK_END) < 0)
+    {
+        journal_close(journal);
+        return NULL;
+    }
+    return journal;
+}
+
+ResultCode journal_replay(Journal *journal, JournalApply apply, void *context)
+{
+    if (journal == NULL || apply == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if (journal->size <= JOURNAL_HEADER_SIZE)
+    {
+        return CODE_OK;
+    }
+
+    // Journals are compacted well before they get large, so they are read whole
+    const size_t length = journal->size - JOURNAL_HEADER_SIZE;
+    unsigned char *records = malloc(length);
+    if (records == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    size_t read_bytes = 0;
+    while (read_bytes < length)
+    {
+        const ssize_t count = pread(journal->fd, records + read_bytes, length - read_bytes, JOURNAL_HEADER_SIZE + read_bytes);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            break;
+        }
+        read_bytes += count;
+    }
+    ResultCode result = CODE_OK;
+    size_t position = 0;
+    while (result == CODE_OK && position + JOURNAL_RECORD_HEADER_SIZE <= read_bytes)
+    {
+        const size_t record_length = journal_decode(records + position, 4);
+        const uint32_t checksum = journal_decode(records + position + 4, 4);
+        const char *contents = (const char *)records + position + JOURNAL_RECORD_HEADER_SIZE;
+        if (record_length > read_bytes - position - JOURNAL_RECORD_HEADER_SIZE ||
+            journal_checksum(contents, record_length) != checksum)
+        {
+            break;
+        }
+
+        // The contents are copied so the record can be used as a string that ends in a zero
+        String *record = types_string_create_from_buffer(contents, record_length);
+        result = record != NULL ? apply(context, record) : CODE_MEMORY_ERROR;
+        if (record != NULL)
+        {
+            types_string_free(record);
+            free(record);
+        }
+        position += JOURNAL_RECORD_HEADER_SIZE + record_length;
+    }
+    free(records);
+
+    // Whatever follows the last whole record was being appended when the program stopped
+    if (result == CODE_OK && position < length)
+    {
+        journal->size = JOURNAL_HEADER_SIZE + position;
+        if (ftruncate(journal->fd, journal->size) != 0 || lseek(journal->fd, journal->size, SEEK_SET) < 0)
+        {
+            result = CODE_WRITE_ERROR;
+        }
+    }
+    return result;
+}
+
+ResultCode journal_append(Journal *journal, const String *record)
+{
+    if (journal == NULL || record == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // The header and the contents go out in a single write, and a crash in the middle leaves
+    // a record that fails its checksum
+    const size_t length = record->length;
+    unsigned char *buffer = malloc(JOURNAL_RECORD_HEADER_SIZE + length);
+    if (buffer == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    journal_encode(buffer, length, 4);
+    journal_encode(buffer + 4, journal_checksum(record->buffer, length), 4);
+    memcpy(buffer + JOURNAL_RECORD_HEADER_SIZE, record->buffer, length);
+    ResultCode result = journal_write(journal->fd, buffer, JOURNAL_RECORD_HEADER_SIZE + length);
+    free(buffer);
+    if (result == CODE_OK && fdatasync(journal->fd) != 0)
+    {
+        result = CODE_WRITE_ERROR;
+    }
+    if (result == CODE_OK)
+    {
+        journal->size += JOURNAL_RECORD_HEADER_SIZE + length;
+    }
+    return result;
+}
+
+ResultCode journal_reset(Journal *journal, const String *base)
+{
+    if (journal == NULL || base == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    unsigned char header[JOURNAL_HEADER_SIZE];
+    journal_header(base, header);
+    if (ftruncate(journal->fd, 0) != 0 || lseek(journal->fd, 0, SEEK_SET) < 0 ||
+        journal_write(journal->fd, header, JOURNAL_HEADER_SIZE) != CODE_OK || fdatasync(journal->fd) != 0)
+    {
+        return CODE_WRITE_ERROR;
+    }
+    journal->size = JOURNAL_HEADER_SIZE;
+    return CODE_OK;
+}
+
+ResultCode journal_close(Journal *journal)
+{
+    if (journal == NULL)
+    {
+        return CODE_OK;
+    }
+    ResultCode result = journal->fd >= 0 && close(journal->fd) != 0 ? CODE_WRITE_ERROR : CODE_OK;
+    types_string_free(journal->path);
+    free(journal->path);
+    free(journal);
+    return result;
+}
+
+static void journal_header(const String *base, unsigned char *header)
+{
+    memcpy(header, "JWJ1", 4);
+    journal_encode(header + 4, base->length, 8);
+    journal_encode(header + 12, types_string_hash(base), 8);
+}
+
+static uint32_t journal_checksum(const char *buffer, const size_t length)
+{
+    // 32 bit FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)buffer[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void journal_encode(unsigned char *buffer, uint64_t value, const size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i++, value >>= 8)
+    {
+        buffer[i] = value & 0xff;
+    }
+}
+
+static uint64_t journal_decode(const unsigned char *buffer, const size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = bytes; i > 0; i--)
+    {
+        value = (value << 8) | buffer[i - 1];
+    }
+    return value;
+}
+
+static ResultCode journal_write(const int fd, const void *buffer, const size_t length)
+{
+    size_t written = 0;
+    while (written < length)
+    {
+        const ssize_t count = write(fd, (const char *)buffer + written, length - written);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            return CODE_WRITE_ERROR;
+        }
+        written += count;
+    }
+    return CODE_OK;
+}
@@ -0,0 +1,75 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils.h"
+#include "types/types_string.h"
+
+/// @brief Appended to the name of a file to give the name of its journal
+#define JOURNAL_SUFFIX ".journal"
+
+/// @brief Bytes at the start of a journal: "JWJ1", then the length and the hash of the text of
+/// the file it applies to, both as 64 bit little endian integers
+#define JOURNAL_HEADER_SIZE 20
+
+/// @brief Bytes before each record: its length and a checksum of its contents, both as 32 bit
+/// little endian integers
+#define JOURNAL_RECORD_HEADER_SIZE 8
+
+/// @brief Size past which a journal should be compacted into its file, unless told otherwise
+#define JOURNAL_DEFAULT_LIMIT (1024 * 1024)
+
+/// @brief Apply a record found in a journal
+/// @param context Context given to journal_replay
+/// @param record Contents of the record
+/// @return Result code
+typedef ResultCode (*JournalApply)(void *context, const String *record);
+
+/// @brief An append-only file with the changes made to a file since it was last written. The
+/// journal remembers the text of the file it applies to, so once the file is written again
+/// with the changes, the old records are recognised as already applied
+typedef struct Journal_st
+{
+    int fd;       // Open journal, positioned at its end
+    String *path; // Name of the journal
+    size_t size;  // Bytes in the journal, header included
+    bool stale;   // Indicates if the journal was found to belong to another text of the file
+} Journal;
+
+/// @brief Open the journal of a file, or create it if there is none. A journal that does not
+/// belong to the current text of the file is emptied
+/// @param filename Name of the file, to which JOURNAL_SUFFIX is appended
+/// @param base Current text of the file
+/// @retval Journal
+/// @retval NULL if the journal could not be opened or created
+Journal *journal_open(const String *filename, const String *base);
+
+/// @brief Apply every record of a journal in order. A record cut short or damaged by a crash
+/// in the middle of an append ends the journal, and is removed
+/// @param journal Journal
+/// @param apply Function that applies each record
+/// @param context Context given to the function
+/// @return Result code, the first failure of the function, which stops the replay
+ResultCode journal_replay(Journal *journal, JournalApply apply, void *context);
+
+/// @brief Append a record to a journal, and wait until it is on disk
+/// @param journal Journal
+/// @param record Contents of the record
+/// @return Result code
+ResultCode journal_append(Journal *journal, const String *record);
+
+/// @brief Empty a journal once its changes are in the file, and make it apply to the new text
+/// @param journal Journal
+/// @param base Text of the file just written
+/// @return Result code
+ResultCode journal_reset(Journal *journal, const String *base);
+
+/// @brief Close a journal and free the memory it uses, including the journal itself
+/// @param journal Journal
+/// @return Result code
+ResultCode journal_close(Journal *journal);
+
+#endif
@@ -0,0 +1,702 @@
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+
+#include "json_filter.h"
+#include "types/types_map.h"
+
+/// @brief Deepest nesting of parentheses and negations, as the compiler is recursive
+#define JSON_FILTER_MAX_DEPTH 256
+
+/// @brief Longest number accepted as a constant
+#define JSON_FILTER_MAX_NUMBER 64
+
+/// @brief State of the compiler while it reads the text of a filter
+typedef struct JsonFilterParser_st
+{
+    const char *text;
+    size_t length;
+    size_t position;
+    JsonFilter *filter;
+    size_t depth;   // Nodes on the stack at this point of the program
+    size_t nesting; // Parentheses and negations currently open
+} JsonFilterParser;
+
+// Nodes pushed as the results of comparisons and negations
+static const Node json_filter_true = {.type = NODE_TYPE_TRUE};
+static const Node json_filter_false = {.type = NODE_TYPE_FALSE};
+
+static bool json_filter_or(JsonFilterParser *parser);
+static bool json_filter_and(JsonFilterParser *parser);
+static bool json_filter_not(JsonFilterParser *parser);
+static bool json_filter_comparison(JsonFilterParser *parser);
+static bool json_filter_primary(JsonFilterParser *parser);
+static bool json_filter_operand(JsonFilterParser *parser);
+static bool json_filter_constant(JsonFilterParser *parser, Node *constant);
+static Node *json_filter_number(JsonFilterParser *parser);
+static String *json_filter_quoted(JsonFilterParser *parser);
+static bool json_filter_emit(JsonFilterParser *parser, const JsonFilterOperation operation, const size_t argument);
+static bool json_filter_accept(JsonFilterParser *parser, const char *token);
+static void json_filter_skip_spaces(JsonFilterParser *parser);
+static bool json_filter_run(const JsonFilter *filter, const Node *node, const Node **stack, size_t *hints);
+static const Node *json_filter_child(const Node *node, const JsonFilterStep *step, size_t *hint);
+static bool json_filter_compare(const Node *node1, const Node *node2, const JsonFilterOperation operation);
+static bool json_filter_truth(const Node *node);
+static ResultCode json_filter_free_nothing(void *element);
+static ResultCode json_filter_free_step(void *step);
+static ResultCode json_filter_free_constant(void *constant);
+
+JsonFilter *json_filter_compile(const char *text, const size_t length, const size_t position, size_t *end)
+{
+    if (text == NULL || position >= length || text[position] != '?')
+    {
+        return NULL;
+    }
+    JsonFilter *filter = malloc(sizeof(JsonFilter));
+    if (filter == NULL)
+    {
+        return NULL;
+    }
+    filter->program = types_vector_create(sizeof(JsonFilterInstruction), json_filter_free_nothing);
+    filter->operands = types_vector_create(sizeof(JsonFilterOperand), json_filter_free_nothing);
+    filter->steps = types_vector_create(sizeof(JsonFilterStep), json_filter_free_step);
+    filter->constants = types_vector_create(sizeof(Node *), json_filter_free_constant);
+    filter->stack_size = 0;
+    atomic_init(&filter->references, 1);
+
+    // The whole expression leaves a single node on the stack, whose truth is the result
+    JsonFilterParser parser = {text, length, position + 1, filter, 0, 0};
+    if (filter->program == NULL || filter->operands == NULL || filter->steps == NULL || filter->constants == NULL ||
+        !json_filter_or(&parser) || parser.depth != 1)
+    {
+        json_filter_free(filter);
+        return NULL;
+    }
+    json_filter_skip_spaces(&parser);
+    *end = parser.position;
+    return filter;
+}
+
+bool json_filter_match(const JsonFilter *filter, const Node *node)
+{
+    if (filter == NULL || node == NULL)
+    {
+        return false;
+    }
+    const Node **stack = malloc(filter->stack_size * sizeof(Node *));
+    size_t *hints = calloc(types_vector_size(filter->steps) + 1, sizeof(size_t));
+    const bool match = stack != NULL && hints != NULL && json_filter_run(filter, node, stack, hints);
+    free(stack);
+    free(hints);
+    return match;
+}
+
+ResultCode json_filter_select(const JsonFilter *filter, Node *node, Vector *matches)
+{
+    return json_filter_select_range(filter, node, 0, SIZE_MAX, matches);
+}
+
+ResultCode json_filter_select_range(const JsonFilter *filter, Node *node, const size_t first, const size_t last, Vector *matches)
+{
+    if (filter == NULL || node == NULL || matches == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if ((node->type != NODE_TYPE_ARRAY && node->type != NODE_TYPE_OBJECT) || node->data == NULL)
+    {
+        return CODE_OK;
+    }
+
+    // The stack and the hints are set up once for all the children
+    const Node **stack = malloc(filter->stack_size * sizeof(Node *));
+    size_t *hints = calloc(types_vector_size(filter->steps) + 1, sizeof(size_t));
+    ResultCode result = stack != NULL && hints != NULL ? CODE_OK : CODE_MEMORY_ERROR;
+    if (result == CODE_OK && node->type == NODE_TYPE_ARRAY)
+    {
+        // The children of an array are back to back in its buffer
+        const Vector *vector = node->data;
+        Node **children = vector->data;
+        for (size_t i = first, n = last < vector->size ? last : vector->size; i < n && result == CODE_OK; i++)
+        {
+            if (json_filter_run(filter, children[i], stack, hints))
+            {
+                result = types_vector_push(matches, &children[i]);
+            }
+        }
+    }
+    else if (result == CODE_OK)
+    {
+        const Vector *elements = ((Map *)node->data)->elements;
+        Pair *pairs = elements->data;
+        for (size_t i = first, n = last < elements->size ? last : elements->size; i < n && result == CODE_OK; i++)
+        {
+            if (json_filter_run(filter, pairs[i].value, stack, hints))
+            {
+                result = types_vector_push(matches, &pairs[i].value);
+            }
+        }
+    }
+    free(stack);
+    free(hints);
+    return result;
+}
+
+ResultCode json_filter_free(JsonFilter *filter)
+{
+    if (filter == NULL)
+    {
+        return CODE_OK;
+    }
+    if (atomic_fetch_sub(&filter->references, 1) > 1)
+    {
+        return CODE_OK;
+    }
+    Vector *vectors[] = {filter->program, filter->operands, filter->steps, filter->constants};
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+        if (vectors[i] != NULL)
+        {
+            types_vector_free(vectors[i]);
+            free(vectors[i]);
+        }
+    }
+    free(filter);
+    return CODE_OK;
+}
+
+static bool json_filter_or(JsonFilterParser *parser)
+{
+    if (!json_filter_and(parser))
+    {
+        return false;
+    }
+    while (json_filter_accept(parser, "||"))
+    {
+        // The right side only runs when the left one is not true
+        const size_t jump = types_vector_size(parser->filter->program);
+        if (!json_filter_emit(parser, FILTER_JUMP_IF_TRUE, 0) || !json_filter_and(parser))
+        {
+            return false;
+        }
+        ((JsonFilterInstruction *)types_vector_at(parser->filter->program, jump))->argument =
+            types_vector_size(parser->filter->program);
+    }
+    return true;
+}
+
+static bool json_filter_and(JsonFilterParser *parser)
+{
+    if (!json_filter_not(parser))
+    {
+        return false;
+    }
+    while (json_filter_accept(parser, "&&"))
+    {
+        // The right side only runs when the left one is true
+        const size_t jump = types_vector_size(parser->filter->program);
+        if (!json_filter_emit(parser, FILTER_JUMP_IF_FALSE, 0) || !json_filter_not(parser))
+        {
+            return false;
+        }
+        ((JsonFilterInstruction *)types_vector_at(parser->filter->program, jump))->argument =
+            types_vector_size(parser->filter->program);
+    }
+    return true;
+}
+
+static bool json_filter_not(JsonFilterParser *parser)
+{
+    json_filter_skip_spaces(parser);
+    if (parser->position + 1 < parser->length && parser->text[parser->position] == '!' &&
+        parser->text[parser->position + 1] != '=')
+    {
+        parser->position += 1;
+        parser->nesting += 1;
+        const bool valid = parser->nesting <= JSON_FILTER_MAX_DEPTH && json_filter_not(parser) &&
+                           json_filter_emit(parser, FILTER_NOT, 0);
+        parser->nesting -= 1;
+        return valid;
+    }
+    return json_filter_comparison(parser);
+}
+
+static bool json_filter_comparison(JsonFilterParser *parser)
+{
+    // Two-character operators are tried first
+    static const char *tokens[] = {"==", "!=", "<=", ">=", "<", ">"};
+    static const JsonFilterOperation operations[] = {FILTER_EQUAL, FILTER_NOT_EQUAL, FILTER_LESS_EQUAL,
+                                                     FILTER_GREATER_EQUAL, FILTER_LESS, FILTER_GREATER};
+    if (!json_filter_primary(parser))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(tokens) / sizeof(tokens[0]); i++)
+    {
+        if (json_filter_accept(parser, tokens[i]))
+        {
+            return json_filter_primary(parser) && json_filter_emit(parser, operations[i], 0);
+        }
+    }
+    return true;
+}
+
+static bool json_filter_primary(JsonFilterParser *parser)
+{
+    json_filter_skip_spaces(parser);
+    if (parser->position >= parser->length)
+    {
+        return false;
+    }
+    const char first = parser->text[parser->position];
+    if (first == '(')
+    {
+        parser->position += 1;
+        parser->nesting += 1;
+        const bool valid = parser->nesting <= JSON_FILTER_MAX_DEPTH && json_filter_or(parser) &&
+                           json_filter_accept(parser, ")");
+        parser->nesting -= 1;
+        return valid;
+    }
+    if (first == '@')
+    {
+        parser->position += 1;
+        return json_filter_operand(parser);
+    }
+
+    // Constants become nodes, so they are compared the same way as the nodes of the tree
+    Node *constant = NULL;
+    if (first == '\'' || first == '\"')
+    {
+        String *string = json_filter_quoted(parser);
+        constant = string != NULL ? node_create() : NULL;
+        if (constant == NULL)
+        {
+            types_string_free(string);
+            free(string);
+            return false;
+        }
+        constant->type = NODE_TYPE_STRING;
+        constant->data = string;
+    }
+    else if (first == '-' || (first >= '0' && first <= '9'))
+    {
+        constant = json_filter_number(parser);
+    }
+    else
+    {
+        static const char *literals[] = {"true", "false", "null"};
+        static const NodeType types[] = {NODE_TYPE_TRUE, NODE_TYPE_FALSE, NODE_TYPE_NULL};
+        for (size_t i = 0; i < sizeof(literals) / sizeof(literals[0]) && constant == NULL; i++)
+        {
+            if (json_filter_accept(parser, literals[i]))
+            {
+                constant = node_create();
+                if (constant != NULL)
+                {
+                    constant->type = types[i];
+                }
+            }
+        }
+    }
+    return constant != NULL && json_filter_constant(parser, constant);
+}
+
+static bool json_filter_operand(JsonFilterParser *parser)
+{
+    // Steps after the `@`, which stand for the element itself when there are none
+    JsonFilter *filter = parser->filter;
+    JsonFilterOperand operand = {types_vector_size(filter->steps), 0};
+    while (parser->position < parser->length)
+    {
+        JsonFilterStep step = {false, 0, {NULL, 0, 0}, 0};
+        String *key = NULL;
+        const char next = parser->text[parser->position];
+        if (next == '.')
+        {
+            const size_t start = ++parser->position;
+            while (parser->position < parser->length &&
+                   strchr(".[]()!=<>&|, \t\n\r'\"", parser->text[parser->position]) == NULL)
+            {
+                parser->position += 1;
+            }
+            if (parser->position == start)
+            {
+                return false;
+            }
+            key = types_string_create_from_buffer(parser->text + start, parser->position - start);
+        }
+        else if (next == '[')
+        {
+            parser->position += 1;
+            json_filter_skip_spaces(parser);
+            if (parser->position < parser->length && parser->text[parser->position] >= '0' && parser->text[parser->position] <= '9')
+            {
+                long index = 0;
+                while (parser->position < parser->length && parser->text[parser->position] >= '0' &&
+                       parser->text[parser->position] <= '9' && index <= INT_MAX)
+                {
+                    index = index * 10 + (parser->text[parser->position++] - '0');
+                }
+                if (index > INT_MAX)
+                {
+                    return false;
+                }
+                step.is_index = true;
+                step.index = index;
+            }
+            else
+            {
+                key = json_filter_quoted(parser);
+                if (key == NULL)
+                {
+                    return false;
+                }
+            }
+            if (!json_filter_accept(parser, "]"))
+            {
+                types_string_free(key);
+                free(key);
+                return false;
+            }
+        }
+        else
+        {
+            break;
+        }
+
+        // The step keeps the contents of the key, whose hash is computed once here
+        if (!step.is_index)
+        {
+            if (key == NULL)
+            {
+                return false;
+            }
+            step.key = *key;
+            step.hash = types_string_hash(key);
+            free(key);
+        }
+        if (types_vector_push(filter->steps, &step) != CODE_OK)
+        {
+            json_filter_free_step(&step);
+            return false;
+        }
+        operand.count += 1;
+    }
+    return types_vector_push(filter->operands, &operand) == CODE_OK &&
+           json_filter_emit(parser, FILTER_PUSH_OPERAND, types_vector_size(filter->operands) - 1);
+}
+
+static bool json_filter_constant(JsonFilterParser *parser, Node *constant)
+{
+    if (types_vector_push(parser->filter->constants, &constant) != CODE_OK)
+    {
+        node_destroy(constant);
+        return false;
+    }
+    return json_filter_emit(parser, FILTER_PUSH_CONSTANT, types_vector_size(parser->filter->constants) - 1);
+}
+
+static Node *json_filter_number(JsonFilterParser *parser)
+{
+    // Numbers follow the JSON grammar, and are copied so strtod stops at their end
+    const char *text = parser->text;
+    const size_t start = parser->position;
+    size_t position = start + (text[start] == '-');
+    const size_t digits = position;
+    while (position < parser->length && text[position] >= '0' && text[position] <= '9')
+    {
+        position += 1;
+    }
+    if (position == digits)
+    {
+        return NULL;
+    }
+    if (position < parser->length && text[position] == '.')
+    {
+        const size_t fraction = ++position;
+        while (position < parser->length && text[position] >= '0' && text[position] <= '9')
+        {
+            position += 1;
+        }
+        if (position == fraction)
+        {
+            return NULL;
+        }
+    }
+    if (position < parser->length && (text[position] == 'e' || text[position] == 'E'))
+    {
+        position += 1;
+        position += position < parser->length && (text[position] == '+' || text[position] == '-');
+        const size_t exponent = position;
+        while (position < parser->length && text[position] >= '0' && text[position] <= '9')
+        {
+            position += 1;
+        }
+        if (position == exponent)
+        {
+            return NULL;
+        }
+    }
+    if (position - start >= JSON_FILTER_MAX_NUMBER)
+    {
+        return NULL;
+    }
+    char copy[JSON_FILTER_MAX_NUMBER];
+    memcpy(copy, text + start, position - start);
+    copy[position - start] = '\0';
+
+    Node *node = node_create();
+    if (node == NULL || node_set_number(node, strtod(copy, NULL)) != CODE_OK)
+    {
+        node_destroy(node);
+        return NULL;
+    }
+    parser->position = position;
+    return node;
+}
+
+static String *json_filter_quoted(JsonFilterParser *parser)
+{
+    // Quoted with single or double quotes, and a reverse solidus escapes the next character
+    const char quote = parser->position < parser->length ? parser->text[parser->position] : '\0';
+    if (quote != '\'' && quote != '\"')
+    {
+        return NULL;
+    }
+    char *buffer = malloc(parser->length);
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+    size_t length = 0;
+    size_t position = parser->position + 1;
+    while (position < parser->length && parser->text[position] != quote)
+    {
+        if (parser->text[position] == '\\' && ++position >= parser->length)
+        {
+            break;
+        }
+        buffer[length++] = parser->text[position++];
+    }
+    String *string = position < parser->length ? types_string_create_from_buffer(buffer, length) : NULL;
+    free(buffer);
+    parser->position = position + 1;
+    return string;
+}
+
+static bool json_filter_emit(JsonFilterParser *parser, const JsonFilterOperation operation, const size_t argument)
+{
+    // Keep track of the nodes on the stack, to know how deep it gets
+    switch (operation)
+    {
+    case FILTER_PUSH_OPERAND:
+    case FILTER_PUSH_CONSTANT:
+        parser->depth += 1;
+        break;
+    case FILTER_NOT:
+        break;
+    default:
+        // Comparisons take two nodes and leave one, and jumps drop one when they do not jump
+        parser->depth -= 1;
+        break;
+    }
+    if (parser->depth > parser->filter->stack_size)
+    {
+        parser->filter->stack_size = parser->depth;
+    }
+    JsonFilterInstruction instruction = {operation, argument};
+    return types_vector_push(parser->filter->program, &instruction) == CODE_OK;
+}
+
+static bool json_filter_accept(JsonFilterParser *parser, const char *token)
+{
+    json_filter_skip_spaces(parser);
+    const size_t length = strlen(token);
+    if (parser->length - parser->position < length || memcmp(parser->text + parser->position, token, length) != 0)
+    {
+        return false;
+    }
+    parser->position += length;
+    return true;
+}
+
+static void json_filter_skip_spaces(JsonFilterParser *parser)
+{
+    while (parser->position < parser->length &&
+           (parser->text[parser->position] == ' ' || parser->text[parser->position] == '\t'))
+    {
+        parser->position += 1;
+    }
+}
+
+static bool json_filter_run(const JsonFilter *filter, const Node *node, const Node **stack, size_t *hints)
+{
+    const JsonFilterInstruction *program = filter->program->data;
+    const JsonFilterOperand *operands = filter->operands->data;
+    const JsonFilterStep *steps = filter->steps->data;
+    Node *const *constants = filter->constants->data;
+    size_t top = 0;
+    for (size_t i = 0, n = filter->program->size; i < n; i++)
+    {
+        const JsonFilterInstruction *instruction = &program[i];
+        switch (instruction->operation)
+        {
+        case FILTER_PUSH_OPERAND:
+        {
+            const JsonFilterOperand *operand = &operands[instruction->argument];
+            const Node *current = node;
+            for (size_t j = operand->first, last = operand->first + operand->count; j < last && current != NULL; j++)
+            {
+                current = json_filter_child(current, &steps[j], &hints[j]);
+            }
+            stack[top++] = current;
+            break;
+        }
+        case FILTER_PUSH_CONSTANT:
+            stack[top++] = constants[instruction->argument];
+            break;
+        case FILTER_NOT:
+            stack[top - 1] = json_filter_truth(stack[top - 1]) ? &json_filter_false : &json_filter_true;
+            break;
+        case FILTER_JUMP_IF_FALSE:
+        case FILTER_JUMP_IF_TRUE:
+            if (json_filter_truth(stack[top - 1]) == (instruction->operation == FILTER_JUMP_IF_TRUE))
+            {
+                // The jump lands right after the last instruction of the other side
+                i = instruction->argument - 1;
+            }
+            else
+            {
+                top -= 1;
+            }
+            break;
+        default:
+            top -= 1;
+            stack[top - 1] = json_filter_compare(stack[top - 1], stack[top], instruction->operation)
+                                 ? &json_filter_true
+                                 : &json_filter_false;
+            break;
+        }
+    }
+    return json_filter_truth(stack[0]);
+}
+
+static const Node *json_filter_child(const Node *node, const JsonFilterStep *step, size_t *hint)
+{
+    if (step->is_index)
+    {
+        return node->type == NODE_TYPE_ARRAY && node->data != NULL && (size_t)step->index < ((Vector *)node->data)->size
+                   ? ((Node **)((Vector *)node->data)->data)[step->index]
+                   : NULL;
+    }
+    if (node->type != NODE_TYPE_OBJECT || node->data == NULL)
+    {
+        return NULL;
+    }
+
+    // The key is first looked for where it was in the previous element
+    const Vector *elements = ((Map *)node->data)->elements;
+    const Pair *pairs = elements->data;
+    const size_t size = elements->size;
+    for (size_t i = 0; i <= size; i++)
+    {
+        const size_t position = i == 0 ? *hint : i - 1;
+        if (position < size && pairs[position].hash == step->hash)
+        {
+            const String *key = pairs[position].key;
+            if (key->length == step->key.length && memcmp(key->buffer, step->key.buffer, key->length) == 0)
+            {
+                *hint = position;
+                return pairs[position].value;
+            }
+        }
+    }
+    return NULL;
+}
+
+static bool json_filter_compare(const Node *node1, const Node *node2, const JsonFilterOperation operation)
+{
+    // Only nodes of the same type can be equal, and only numbers and strings are ordered
+    if (node1 == NULL || node2 == NULL || node1->type != node2->type)
+    {
+        return operation == FILTER_NOT_EQUAL;
+    }
+    if (node1->type == NODE_TYPE_NUMBER)
+    {
+        const double number1 = *(double *)node1->data;
+        const double number2 = *(double *)node2->data;
+        switch (operation)
+        {
+        case FILTER_EQUAL:
+            return number1 == number2;
+        case FILTER_NOT_EQUAL:
+            return number1 != number2;
+        case FILTER_LESS:
+            return number1 < number2;
+        case FILTER_LESS_EQUAL:
+            return number1 <= number2;
+        case FILTER_GREATER:
+            return number1 > number2;
+        case FILTER_GREATER_EQUAL:
+            return number1 >= number2;
+        default:
+            return false;
+        }
+    }
+    int order;
+    if (node1->type == NODE_TYPE_STRING)
+    {
+        const String *string1 = node1->data;
+        const String *string2 = node2->data;
+        const size_t shortest = string1->length < string2->length ? string1->length : string2->length;
+        order = memcmp(string1->buffer, string2->buffer, shortest);
+        order = order != 0 ? order : (string1->length > string2->length) - (string1->length < string2->length);
+    }
+    else if (node1->type == NODE_TYPE_TRUE || node1->type == NODE_TYPE_FALSE || node1->type == NODE_TYPE_NULL)
+    {
+        return operation == FILTER_EQUAL;
+    }
+    else
+    {
+        // Arrays and objects are not compared
+        return operation == FILTER_NOT_EQUAL;
+    }
+    switch (operation)
+    {
+    case FILTER_EQUAL:
+        return order == 0;
+    case FILTER_NOT_EQUAL:
+        return order != 0;
+    case FILTER_LESS:
+        return order < 0;
+    case FILTER_LESS_EQUAL:
+        return order <= 0;
+    case FILTER_GREATER:
+        return order > 0;
+    case FILTER_GREATER_EQUAL:
+        return order >= 0;
+    default:
+        return false;
+    }
+}
+
+static bool json_filter_truth(const Node *node)
+{
+    return node != NULL && node->type != NODE_TYPE_FALSE && node->type != NODE_TYPE_NULL;
+}
+
+static ResultCode json_filter_free_nothing(void *element)
+{
+    return CODE_OK;
+}
+
+static ResultCode json_filter_free_step(void *step)
+{
+    JsonFilterStep *filter_step = step;
+    return filter_step->is_index ? CODE_OK : types_string_free(&filter_step->key);
+}
+
+static ResultCode json_filter_free_constant(void *constant)
+{
+    return node_destroy(*(Node **)constant);
+}
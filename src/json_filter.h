@@ -0,0 +1,104 @@
+#ifndef JSON_FILTER_H
+#define JSON_FILTER_H
+
+#include <stdatomic.h>
+
+#include "types/types_vector.h"
+#include "types/types_string.h"
+#include "node.h"
+
+/// @brief Operations of a compiled filter, which run on a stack of nodes
+typedef enum JsonFilterOperation_e
+{
+    FILTER_PUSH_OPERAND,  // Push the node found by a path from the current element, or NULL if missing
+    FILTER_PUSH_CONSTANT, // Push one of the constants
+    FILTER_EQUAL,         // Replace the two nodes on top with the result of comparing them
+    FILTER_NOT_EQUAL,
+    FILTER_LESS,
+    FILTER_LESS_EQUAL,
+    FILTER_GREATER,
+    FILTER_GREATER_EQUAL,
+    FILTER_NOT,           // Replace the node on top with the opposite of its truth
+    FILTER_JUMP_IF_FALSE, // Jump if the node on top is not true, keeping it, or else drop it
+    FILTER_JUMP_IF_TRUE   // Jump if the node on top is true, keeping it, or else drop it
+} JsonFilterOperation;
+
+/// @brief An instruction of a compiled filter
+typedef struct JsonFilterInstruction_st
+{
+    JsonFilterOperation operation;
+    size_t argument; // Operand, constant or instruction to jump to
+} JsonFilterInstruction;
+
+/// @brief A step of the path of an operand, from the element being filtered
+typedef struct JsonFilterStep_st
+{
+    bool is_index;
+    int index;
+    String key;
+    size_t hash; // Hash of the key
+} JsonFilterStep;
+
+/// @brief An operand is a range of the steps of the filter
+typedef struct JsonFilterOperand_st
+{
+    size_t first;
+    size_t count;
+} JsonFilterOperand;
+
+/// @brief A filter expression compiled into instructions for a stack machine. Keys are hashed
+/// and constants are turned into nodes once, so testing an element reads no text at all
+typedef struct JsonFilter_st
+{
+    Vector *program;          // Vector of JsonFilterInstruction
+    Vector *operands;         // Vector of JsonFilterOperand
+    Vector *steps;            // Vector of JsonFilterStep, shared by all the operands
+    Vector *constants;        // Vector of Node *
+    size_t stack_size;        // Deepest the stack gets when running the program
+    atomic_size_t references; // Number of owners of the filter, which may be on different threads
+} JsonFilter;
+
+/// @brief Compile the filter expression of a path, as in `[?(@.status == "active" && @.size > 1024)]`.
+/// Operands are paths from the current element `@` made of `.name`, `['key']` and `[index]`, or
+/// constants: numbers, quoted strings, `true`, `false` and `null`. They are compared with `==`,
+/// `!=`, `<`, `<=`, `>` and `>=`, and combined with `!`, `&&`, `||` and parentheses. A node alone
+/// is true unless it is missing, false or null
+/// @param text Text of the path
+/// @param length Length of the text
+/// @param position Position of the `?` that starts the filter
+/// @param end Where the position right after the filter is returned
+/// @retval Filter, with one reference
+/// @retval NULL if the expression is not valid or a problem was encountered
+JsonFilter *json_filter_compile(const char *text, const size_t length, const size_t position, size_t *end);
+
+/// @brief Test a single node with a filter
+/// @param filter Filter
+/// @param node Node taken as `@`
+/// @return True if the filter holds for the node
+bool json_filter_match(const JsonFilter *filter, const Node *node);
+
+/// @brief Find the children of an array, or the values of an object, for which a filter holds.
+/// The children are tested one after the other in a single loop, which remembers where each
+/// key was found in the previous element, as the records of an array usually share a layout
+/// @param filter Filter
+/// @param node Array or object
+/// @param matches Vector of Node * where the children found are pushed, in order
+/// @return Result code
+ResultCode json_filter_select(const JsonFilter *filter, Node *node, Vector *matches);
+
+/// @brief Find the children for which a filter holds among a range of the children of an array,
+/// or of the values of an object, so separate ranges can be tested by separate threads
+/// @param filter Filter
+/// @param node Array or object
+/// @param first Position of the first child tested
+/// @param last Position after the last child tested, which may be past the end
+/// @param matches Vector of Node * where the children found are pushed, in order
+/// @return Result code
+ResultCode json_filter_select_range(const JsonFilter *filter, Node *node, const size_t first, const size_t last, Vector *matches);
+
+/// @brief Drop one reference to a filter, and free it with the last one
+/// @param filter Filter
+/// @return Result code
+ResultCode json_filter_free(JsonFilter *filter);
+
+#endif
@@ -1,6 +1,1054 @@
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+
 #include "json_path.h"
+#include "json_filter.h"
+#include "node_index.h"
+#include "types/types_map.h"
+
+/// @brief A node found by a trie, with what is needed to put the nodes found in order
+typedef struct JsonPathFound_st
+{
+    Node *node;
+    size_t depth; // Number of ancestors of the node
+    size_t order; // Position in which it was found
+} JsonPathFound;
+
+/// @brief Work shared by the threads that walk the slices of a large array
+typedef struct JsonPathSlices_st
+{
+    Node *node;           // Array
+    const PathTrie *trie; // Child of the trie with the step over the children of the array
+    bool create;          // Indicates if the missing steps are created
+    size_t size;          // Number of children in each slice
+    Vector **found;       // Nodes found below each slice, each a Vector of Node *
+    Vector **created;     // Nodes created below each slice, each a Vector of Node *
+} JsonPathSlices;
+
+static bool json_path_compile(const char *text, const size_t length, Vector *segments);
+static size_t json_path_name(const char *text, const size_t length, size_t position, const bool descendant, Vector *segment);
+static size_t json_path_union(const char *text, const size_t length, size_t position, const bool descendant, Vector *segment);
+static size_t json_path_selector(const char *text, const size_t length, size_t position, const bool descendant, Vector *segment);
+static bool json_path_step_key(const char *buffer, const size_t length, const enum PathStepId id, Vector *segment);
+static bool json_path_step_wildcard(const enum PathStepId id, Vector *segment);
+static size_t json_path_step_filter(const char *text, const size_t length, size_t position, Vector *segment);
+static bool json_path_step_has_key(const PathStep *step);
+static bool json_path_step_push(PathStep *step, Vector *segment);
+static bool json_path_step_equal(const PathStep *step1, const PathStep *step2);
+static bool json_path_step_copy(const PathStep *step, PathStep *copy);
+static Node *json_path_child(Node *node, const PathTrie *trie, Vector *created);
+static ResultCode json_path_trie_walk(Node *node, const PathTrie *trie, Vector *created, const bool definite, ThreadPool *pool, Vector *nodes);
+static ResultCode json_path_trie_matches(Node *const *matches, const size_t count, const PathTrie *trie, Vector *created, ThreadPool *pool, Vector *nodes);
+static bool json_path_trie_parallel(const Node *node, const PathStep *step, const bool create, const ThreadPool *pool);
+static ResultCode json_path_trie_split(Node *node, const PathTrie *trie, Vector *created, ThreadPool *pool, Vector *nodes);
+static void json_path_trie_undo(Vector *created);
+static ResultCode json_path_trie_slice(void *slices, const size_t index);
+static size_t json_path_trie_multiple(const PathTrie *trie, bool *branches);
+static ResultCode json_path_matches(Node *node, const PathStep *step, Vector *matches);
+static ResultCode json_path_descendants(Node *node, const PathStep *step, Vector *matches);
+static ResultCode json_path_order(Vector *nodes, const size_t start, const bool repeated);
+static int json_path_compare_node(const void *found1, const void *found2);
+static ResultCode json_path_free_nothing(void *node);
+static ResultCode json_path_trie_free_callback(void *trie);
+static bool json_path_push_vector(Vector *vectors, Vector *vector);
+static size_t json_path_skip_spaces(const char *text, const size_t length, size_t position);
+static ResultCode json_path_expand(const Vector *segments, Vector *paths, bool *valid);
+static ResultCode json_path_free_step(void *step);
+static ResultCode json_path_free_steps(void *steps);
 
 JsonPath *json_path_parse(const String *string)
 {
-    return NULL;
-}
\ No newline at end of file
+    if (string == NULL)
+    {
+        return NULL;
+    }
+    JsonPath *path = malloc(sizeof(JsonPath));
+    if (path == NULL)
+    {
+        return NULL;
+    }
+    path->original = types_string_copy(string);
+    path->valid = false;
+    path->paths = types_vector_create(sizeof(Vector), json_path_free_steps);
+
+    // The path is first split in segments, each one a vector with the alternative steps of a
+    // union, and then expanded into every combination of the alternatives
+    Vector *segments = types_vector_create(sizeof(Vector), json_path_free_steps);
+    ResultCode result = path->original != NULL && path->paths != NULL && segments != NULL ? CODE_OK : CODE_MEMORY_ERROR;
+    if (result == CODE_OK && json_path_compile(types_string_c_str(string), types_string_length(string), segments))
+    {
+        result = json_path_expand(segments, path->paths, &path->valid);
+    }
+    if (segments != NULL)
+    {
+        types_vector_free(segments);
+        free(segments);
+    }
+    if (result != CODE_OK)
+    {
+        json_path_free(path);
+        free(path);
+        return NULL;
+    }
+    return path;
+}
+
+Node *json_path_evaluate(Node *node, const Vector *steps)
+{
+    for (size_t i = 0, n = types_vector_size(steps); i < n && node != NULL; i++)
+    {
+        const PathStep *step = types_vector_at(steps, i);
+        if (step->id == PATH_STEP_INDEX)
+        {
+            node = node_array_get(node, step->data.index);
+        }
+        else if (step->id == PATH_STEP_KEY)
+        {
+            node = node_get_hashed(node, &step->data.key, step->hash);
+        }
+        else
+        {
+            node = NULL;
+        }
+    }
+    return node;
+}
+
+PathTrie *json_path_trie_create(const JsonPath *path)
+{
+    if (path == NULL || !path->valid)
+    {
+        return NULL;
+    }
+    PathTrie *trie = malloc(sizeof(PathTrie));
+    if (trie == NULL)
+    {
+        return NULL;
+    }
+    memset(&trie->step, '\0', sizeof(PathStep));
+    trie->end = false;
+    trie->children = NULL;
+
+    // The paths are all different and come in order, so the paths that share a prefix follow
+    // each other, and a step is either the last child added to its parent or a new one
+    for (size_t i = 0, n = types_vector_size(path->paths); i < n; i++)
+    {
+        const Vector *steps = types_vector_at(path->paths, i);
+        PathTrie *current = trie;
+        for (size_t j = 0, m = types_vector_size(steps); j < m; j++)
+        {
+            const PathStep *step = types_vector_at(steps, j);
+            const size_t size = types_vector_size(current->children);
+            PathTrie *last = size > 0 ? types_vector_at(current->children, size - 1) : NULL;
+            if (last == NULL || !json_path_step_equal(&last->step, step))
+            {
+                // Most nodes are leaves, so the vector of children is only created for the first one
+                PathTrie child;
+                child.end = false;
+                child.step.id = PATH_STEP_INDEX;
+                child.children = NULL;
+                if (current->children == NULL)
+                {
+                    current->children = types_vector_create(sizeof(PathTrie), json_path_trie_free_callback);
+                }
+                if (current->children == NULL || !json_path_step_copy(step, &child.step) ||
+                    types_vector_push(current->children, &child) != CODE_OK)
+                {
+                    json_path_trie_free(&child);
+                    json_path_trie_free(trie);
+                    free(trie);
+                    return NULL;
+                }
+                last = types_vector_at(current->children, size);
+            }
+            current = last;
+        }
+        current->end = true;
+    }
+    return trie;
+}
+
+ResultCode json_path_trie_evaluate(Node *root, const PathTrie *trie, const bool create, Vector *nodes)
+{
+    return json_path_trie_evaluate_parallel(root, trie, create, NULL, nodes);
+}
+
+ResultCode json_path_trie_evaluate_parallel(Node *root, const PathTrie *trie, const bool create, ThreadPool *pool, Vector *nodes)
+{
+    if (root == NULL || trie == NULL || nodes == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    const size_t start = types_vector_size(nodes);
+    if (trie->end && types_vector_push(nodes, &root) != CODE_OK)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // The nodes created along the way are kept, so a walk that fails takes them all back and
+    // leaves the tree as it found it
+    Vector *created = create ? types_vector_create(sizeof(Node *), json_path_free_nothing) : NULL;
+    if (create && created == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    ResultCode result = json_path_trie_walk(root, trie, created, true, pool, nodes);
+    if (result != CODE_OK && created != NULL)
+    {
+        json_path_trie_undo(created);
+    }
+    if (created != NULL)
+    {
+        types_vector_free(created);
+        free(created);
+    }
+
+    // Definite steps find each node once and in depth-first order. Wildcards and descendants
+    // may find a node after one of its descendants, and through several paths when there is
+    // more than one path or more than one of them in a path
+    bool branches = false;
+    const size_t multiple = json_path_trie_multiple(trie, &branches);
+    if (result == CODE_OK && multiple > 0)
+    {
+        result = json_path_order(nodes, start, branches || multiple > 1);
+    }
+    return result;
+}
+
+ResultCode json_path_trie_free(PathTrie *trie)
+{
+    if (trie == NULL)
+    {
+        return CODE_OK;
+    }
+    json_path_free_step(&trie->step);
+    if (trie->children != NULL)
+    {
+        types_vector_free(trie->children);
+        free(trie->children);
+        trie->children = NULL;
+    }
+    return CODE_OK;
+}
+
+ResultCode json_path_free(JsonPath *path)
+{
+    if (path == NULL)
+    {
+        return CODE_OK;
+    }
+    if (path->original != NULL)
+    {
+        types_string_free(path->original);
+        free(path->original);
+        path->original = NULL;
+    }
+    if (path->paths != NULL)
+    {
+        types_vector_free(path->paths);
+        free(path->paths);
+        path->paths = NULL;
+    }
+    return CODE_OK;
+}
+
+static bool json_path_compile(const char *text, const size_t length, Vector *segments)
+{
+    // Every path starts at the root
+    if (length == 0 || text[0] != '$')
+    {
+        return false;
+    }
+    size_t position = 1;
+    while (position < length)
+    {
+        Vector *segment = types_vector_create(sizeof(PathStep), json_path_free_step);
+        if (segment == NULL)
+        {
+            return false;
+        }
+        if (text[position] == '.')
+        {
+            // Two dots select nodes at any depth below, by the name or the selectors that follow
+            const bool descendant = position + 1 < length && text[position + 1] == '.';
+            position += descendant ? 2 : 1;
+            if (descendant && position < length && text[position] == '[')
+            {
+                position = json_path_union(text, length, position, true, segment);
+            }
+            else
+            {
+                position = json_path_name(text, length, position, descendant, segment);
+            }
+        }
+        else if (text[position] == '[')
+        {
+            position = json_path_union(text, length, position, false, segment);
+        }
+        else
+        {
+            position = 0;
+        }
+        if (position == 0 || !json_path_push_vector(segments, segment))
+        {
+            types_vector_free(segment);
+            free(segment);
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t json_path_name(const char *text, const size_t length, size_t position, const bool descendant, Vector *segment)
+{
+    // A name goes on until the next step. Returns the position after it, or 0 if it is not valid
+    const size_t start = position;
+    while (position < length && strchr(".[],'\" \t\n\r", text[position]) == NULL)
+    {
+        position += 1;
+    }
+    if (position == start)
+    {
+        return 0;
+    }
+    if (position - start == 1 && text[start] == '*')
+    {
+        return json_path_step_wildcard(descendant ? PATH_STEP_DESCENDANTS : PATH_STEP_WILDCARD, segment) ? position : 0;
+    }
+    return json_path_step_key(text + start, position - start, descendant ? PATH_STEP_DESCENDANT : PATH_STEP_KEY, segment) ? position : 0;
+}
+
+static size_t json_path_union(const char *text, const size_t length, size_t position, const bool descendant, Vector *segment)
+{
+    // One or more selectors separated by commas, between brackets
+    bool more = true;
+    position += 1;
+    while (more)
+    {
+        position = json_path_selector(text, length, json_path_skip_spaces(text, length, position), descendant, segment);
+        if (position == 0)
+        {
+            return 0;
+        }
+        position = json_path_skip_spaces(text, length, position);
+        more = position < length && text[position] == ',' && types_vector_size(segment) < JSON_PATH_MAX_PATHS;
+        position += more ? 1 : 0;
+    }
+    return position < length && text[position] == ']' ? position + 1 : 0;
+}
+
+static size_t json_path_selector(const char *text, const size_t length, size_t position, const bool descendant, Vector *segment)
+{
+    if (position >= length)
+    {
+        return 0;
+    }
+    if (text[position] == '*')
+    {
+        return json_path_step_wildcard(descendant ? PATH_STEP_DESCENDANTS : PATH_STEP_WILDCARD, segment) ? position + 1 : 0;
+    }
+    if (text[position] == '?' && !descendant)
+    {
+        return json_path_step_filter(text, length, position, segment);
+    }
+
+    // Indexes are non-negative integers, and only select children
+    if (text[position] >= '0' && text[position] <= '9' && !descendant)
+    {
+        long index = 0;
+        while (position < length && text[position] >= '0' && text[position] <= '9')
+        {
+            index = index * 10 + (text[position] - '0');
+            if (index > INT_MAX)
+            {
+                return 0;
+            }
+            position += 1;
+        }
+        PathStep step;
+        step.id = PATH_STEP_INDEX;
+        step.data.index = index;
+        step.hash = 0;
+        return json_path_step_push(&step, segment) ? position : 0;
+    }
+
+    // Keys are quoted with single or double quotes, and a reverse solidus escapes the next character
+    const char quote = text[position];
+    if (quote != '\'' && quote != '\"')
+    {
+        return 0;
+    }
+    char *key = malloc(length);
+    if (key == NULL)
+    {
+        return 0;
+    }
+    size_t key_length = 0;
+    position += 1;
+    while (position < length && text[position] != quote)
+    {
+        if (text[position] == '\\')
+        {
+            position += 1;
+            if (position >= length)
+            {
+                break;
+            }
+        }
+        key[key_length++] = text[position++];
+    }
+    const bool valid = position < length &&
+                       json_path_step_key(key, key_length, descendant ? PATH_STEP_DESCENDANT : PATH_STEP_KEY, segment);
+    free(key);
+    return valid ? position + 1 : 0;
+}
+
+static bool json_path_step_key(const char *buffer, const size_t length, const enum PathStepId id, Vector *segment)
+{
+    String *key = types_string_create_from_buffer(buffer, length);
+    if (key == NULL)
+    {
+        return false;
+    }
+
+    // The step keeps the contents of the string, and the hash is computed once here
+    PathStep step;
+    step.id = id;
+    step.data.key = *key;
+    step.hash = types_string_hash(key);
+    free(key);
+    return json_path_step_push(&step, segment);
+}
+
+static bool json_path_step_wildcard(const enum PathStepId id, Vector *segment)
+{
+    PathStep step;
+    step.id = id;
+    step.data.index = 0;
+    step.hash = 0;
+    return json_path_step_push(&step, segment);
+}
+
+static size_t json_path_step_filter(const char *text, const size_t length, size_t position, Vector *segment)
+{
+    // The filter is compiled once here, and then tested against every child
+    PathStep step;
+    step.id = PATH_STEP_FILTER;
+    step.data.filter = json_filter_compile(text, length, position, &position);
+    step.hash = 0;
+    return step.data.filter != NULL && json_path_step_push(&step, segment) ? position : 0;
+}
+
+static bool json_path_step_has_key(const PathStep *step)
+{
+    return step->id == PATH_STEP_KEY || step->id == PATH_STEP_DESCENDANT;
+}
+
+static bool json_path_step_push(PathStep *step, Vector *segment)
+{
+    // A union that names the same step twice stands for it once, so every path is different.
+    // The segment keeps the step, which is freed here if it is not needed or cannot be kept
+    for (size_t i = 0, n = types_vector_size(segment); i < n; i++)
+    {
+        if (json_path_step_equal(types_vector_at(segment, i), step))
+        {
+            json_path_free_step(step);
+            return true;
+        }
+    }
+    if (types_vector_push(segment, step) != CODE_OK)
+    {
+        json_path_free_step(step);
+        return false;
+    }
+    return true;
+}
+
+static bool json_path_step_equal(const PathStep *step1, const PathStep *step2)
+{
+    if (step1->id != step2->id)
+    {
+        return false;
+    }
+    if (step1->id == PATH_STEP_FILTER)
+    {
+        return step1->data.filter == step2->data.filter;
+    }
+    if (!json_path_step_has_key(step1))
+    {
+        return step1->data.index == step2->data.index;
+    }
+    return step1->hash == step2->hash && step1->data.key.length == step2->data.key.length &&
+           memcmp(step1->data.key.buffer, step2->data.key.buffer, step1->data.key.length) == 0;
+}
+
+static bool json_path_step_copy(const PathStep *step, PathStep *copy)
+{
+    // Keys are copied together with their hash, and filters are shared
+    *copy = *step;
+    if (step->id == PATH_STEP_FILTER)
+    {
+        atomic_fetch_add(&step->data.filter->references, 1);
+    }
+    if (json_path_step_has_key(step))
+    {
+        String *key = types_string_copy(&step->data.key);
+        if (key == NULL)
+        {
+            copy->id = PATH_STEP_INDEX;
+            return false;
+        }
+        copy->data.key = *key;
+        free(key);
+    }
+    return true;
+}
+
+static bool json_path_push_vector(Vector *vectors, Vector *vector)
+{
+    // The outer vector keeps the contents of the inner one, so only its shell is freed
+    if (types_vector_push(vectors, vector) != CODE_OK)
+    {
+        return false;
+    }
+    free(vector);
+    return true;
+}
+
+static size_t json_path_skip_spaces(const char *text, const size_t length, size_t position)
+{
+    while (position < length && (text[position] == ' ' || text[position] == '\t'))
+    {
+        position += 1;
+    }
+    return position;
+}
+
+static ResultCode json_path_expand(const Vector *segments, Vector *paths, bool *valid)
+{
+    // Number of paths: the product of the number of alternatives of each segment
+    const size_t number_segments = types_vector_size(segments);
+    size_t total = 1;
+    for (size_t i = 0; i < number_segments; i++)
+    {
+        total *= types_vector_size(types_vector_at(segments, i));
+        if (total > JSON_PATH_MAX_PATHS)
+        {
+            return CODE_OK;
+        }
+    }
+    if (types_vector_reserve(paths, total) != CODE_OK)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // Each path picks one alternative per segment, counting with the last segment changing fastest
+    for (size_t path = 0; path < total; path++)
+    {
+        Vector *steps = types_vector_create(sizeof(PathStep), json_path_free_step);
+        if (steps == NULL || types_vector_reserve(steps, number_segments) != CODE_OK)
+        {
+            free(steps);
+            return CODE_MEMORY_ERROR;
+        }
+        for (size_t i = 0, remaining = path, stride = total; i < number_segments; i++)
+        {
+            const Vector *segment = types_vector_at(segments, i);
+            stride /= types_vector_size(segment);
+            PathStep copy;
+            if (!json_path_step_copy(types_vector_at(segment, remaining / stride), &copy) ||
+                types_vector_push(steps, &copy) != CODE_OK)
+            {
+                json_path_free_step(&copy);
+                types_vector_free(steps);
+                free(steps);
+                return CODE_MEMORY_ERROR;
+            }
+            remaining %= stride;
+        }
+        if (!json_path_push_vector(paths, steps))
+        {
+            types_vector_free(steps);
+            free(steps);
+            return CODE_MEMORY_ERROR;
+        }
+    }
+    *valid = true;
+    return CODE_OK;
+}
+
+static Node *json_path_child(Node *node, const PathTrie *trie, Vector *created)
+{
+    const PathStep *step = &trie->step;
+    Node *child;
+    if (step->id == PATH_STEP_INDEX)
+    {
+        child = node_array_get(node, step->data.index);
+    }
+    else
+    {
+        child = node_get_hashed(node, &step->data.key, step->hash);
+    }
+    if (child != NULL || created == NULL)
+    {
+        return child;
+    }
+
+    // The step is missing, so a new node is created in its place. A node that the path goes on
+    // below is the container the next step needs, so several missing steps are created at once
+    child = node_create();
+    if (child == NULL)
+    {
+        return NULL;
+    }
+    const PathTrie *next = types_vector_size(trie->children) > 0 ? types_vector_at(trie->children, 0) : NULL;
+    if (next != NULL && next->step.id == PATH_STEP_KEY)
+    {
+        child->type = NODE_TYPE_OBJECT;
+    }
+    else if (next != NULL && next->step.id == PATH_STEP_INDEX)
+    {
+        child->type = NODE_TYPE_ARRAY;
+    }
+    ResultCode result;
+    if (step->id == PATH_STEP_INDEX)
+    {
+        // Only the position right after the last element can be filled
+        result = CODE_LOGIC_ERROR;
+        if (node->type == NODE_TYPE_ARRAY &&
+            (size_t)step->data.index == (node->data != NULL ? types_vector_size(node->data) : 0))
+        {
+            result = node_array_push(node, child);
+        }
+    }
+    else
+    {
+        result = node_append(node, &step->data.key, child);
+    }
+    if (result != CODE_OK)
+    {
+        node_destroy(child);
+        return NULL;
+    }
+    if (types_vector_push(created, &child) != CODE_OK)
+    {
+        node_erase(child);
+        return NULL;
+    }
+    return child;
+}
+
+static ResultCode json_path_trie_walk(Node *node, const PathTrie *trie, Vector *created, const bool definite, ThreadPool *pool, Vector *nodes)
+{
+    // Every child of the trie is looked up once from this node, however many paths go through it
+    for (size_t i = 0, n = types_vector_size(trie->children); i < n; i++)
+    {
+        const PathTrie *child_trie = types_vector_at(trie->children, i);
+        const PathStep *step = &child_trie->step;
+        ResultCode result = CODE_OK;
+        if (step->id == PATH_STEP_INDEX || step->id == PATH_STEP_KEY)
+        {
+            // A missing step is an error only on the paths that must lead to a single node
+            Node *child = json_path_child(node, child_trie, created);
+            if (child == NULL)
+            {
+                if (definite)
+                {
+                    return CODE_LOGIC_ERROR;
+                }
+                continue;
+            }
+            if (child_trie->end && types_vector_push(nodes, &child) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+            result = json_path_trie_walk(child, child_trie, created, definite, pool, nodes);
+        }
+        else if (json_path_trie_parallel(node, step, created != NULL, pool))
+        {
+            result = json_path_trie_split(node, child_trie, created, pool, nodes);
+        }
+        else
+        {
+            // The matches are all found before going below them, as that may change the tree
+            Vector *matches = types_vector_create(sizeof(Node *), json_path_free_nothing);
+            result = matches != NULL ? json_path_matches(node, step, matches) : CODE_MEMORY_ERROR;
+            if (result == CODE_OK)
+            {
+                result = json_path_trie_matches(matches->data, matches->size, child_trie, created, pool, nodes);
+            }
+            types_vector_free(matches);
+            free(matches);
+        }
+        if (result != CODE_OK)
+        {
+            return result;
+        }
+    }
+    return CODE_OK;
+}
+
+static ResultCode json_path_trie_matches(Node *const *matches, const size_t count, const PathTrie *trie, Vector *created, ThreadPool *pool, Vector *nodes)
+{
+    // Every match is found, and then the rest of the paths are followed below it
+    for (size_t i = 0; i < count; i++)
+    {
+        Node *match = matches[i];
+        if (trie->end && types_vector_push(nodes, &match) != CODE_OK)
+        {
+            return CODE_MEMORY_ERROR;
+        }
+        const ResultCode result = json_path_trie_walk(match, trie, created, false, pool, nodes);
+        if (result != CODE_OK)
+        {
+            return result;
+        }
+    }
+    return CODE_OK;
+}
+
+static bool json_path_trie_parallel(const Node *node, const PathStep *step, const bool create, const ThreadPool *pool)
+{
+    // The children of an array hang from separate subtrees, but the key index belongs to all of them
+    return thread_pool_size(pool) > 1 && (step->id == PATH_STEP_WILDCARD || step->id == PATH_STEP_FILTER) &&
+           node->type == NODE_TYPE_ARRAY && types_vector_size(node->data) >= JSON_PATH_PARALLEL_MIN &&
+           !(create && node->index != NULL);
+}
+
+static ResultCode json_path_trie_split(Node *node, const PathTrie *trie, Vector *created, ThreadPool *pool, Vector *nodes)
+{
+    // Creating a node marks its ancestors as dirty, and the array is marked here so the threads
+    // stop below it, instead of all of them writing to the same ancestors
+    const bool create = created != NULL;
+    if (create)
+    {
+        node_mark_dirty(node);
+    }
+    const size_t children = types_vector_size(node->data);
+    size_t slices = thread_pool_size(pool) * JSON_PATH_PARALLEL_SLICES;
+    JsonPathSlices work = {node, trie, create, (children + slices - 1) / slices, NULL, NULL};
+    slices = (children + work.size - 1) / work.size;
+    work.found = calloc(slices, sizeof(Vector *));
+    work.created = create ? calloc(slices, sizeof(Vector *)) : NULL;
+    ResultCode result = work.found != NULL && (!create || work.created != NULL) ? CODE_OK : CODE_MEMORY_ERROR;
+    for (size_t i = 0; i < slices && result == CODE_OK; i++)
+    {
+        work.found[i] = types_vector_create(sizeof(Node *), json_path_free_nothing);
+        result = work.found[i] != NULL ? CODE_OK : CODE_MEMORY_ERROR;
+        if (result == CODE_OK && create)
+        {
+            work.created[i] = types_vector_create(sizeof(Node *), json_path_free_nothing);
+            result = work.created[i] != NULL ? CODE_OK : CODE_MEMORY_ERROR;
+        }
+    }
+    if (result == CODE_OK)
+    {
+        result = thread_pool_run(pool, slices, json_path_trie_slice, &work);
+    }
+
+    // The slices are joined in order, which is the order a single thread finds the nodes in
+    for (size_t i = 0; work.found != NULL && i < slices; i++)
+    {
+        for (size_t j = 0, n = types_vector_size(work.found[i]); j < n && result == CODE_OK; j++)
+        {
+            result = types_vector_push(nodes, types_vector_at(work.found[i], j));
+        }
+        if (work.found[i] != NULL)
+        {
+            types_vector_free(work.found[i]);
+            free(work.found[i]);
+        }
+    }
+    free(work.found);
+
+    // Every node created by a slice is handed over, even when the walk failed, so it can be undone.
+    // The ones that cannot be handed over are undone here, from the last slice back
+    bool kept = true;
+    for (size_t i = 0; work.created != NULL && i < slices && kept; i++)
+    {
+        for (size_t j = 0, n = types_vector_size(work.created[i]); j < n && kept; j++)
+        {
+            kept = types_vector_push(created, types_vector_at(work.created[i], j)) == CODE_OK;
+            if (!kept)
+            {
+                const Iterator first = types_vector_begin(work.created[i]);
+                types_vector_erase(work.created[i], first, types_iterator_increase(first, j));
+                result = CODE_MEMORY_ERROR;
+            }
+        }
+        if (kept)
+        {
+            types_vector_clear(work.created[i]);
+        }
+    }
+    for (size_t i = slices; work.created != NULL && i > 0; i--)
+    {
+        if (work.created[i - 1] != NULL)
+        {
+            json_path_trie_undo(work.created[i - 1]);
+            types_vector_free(work.created[i - 1]);
+            free(work.created[i - 1]);
+        }
+    }
+    free(work.created);
+    return result;
+}
+
+static ResultCode json_path_trie_slice(void *slices, const size_t index)
+{
+    // The children of the array do not move while the threads walk below them. Threads do not
+    // split the arrays they find below, as the pool is already busy
+    JsonPathSlices *work = slices;
+    const size_t first = index * work->size;
+    const size_t children = types_vector_size(work->node->data);
+    const size_t last = first + work->size < children ? first + work->size : children;
+    if (work->trie->step.id == PATH_STEP_WILDCARD)
+    {
+        Node **child = types_vector_at(work->node->data, first);
+        return json_path_trie_matches(child, last - first, work->trie, work->create ? work->created[index] : NULL, NULL, work->found[index]);
+    }
+    Vector *matches = types_vector_create(sizeof(Node *), json_path_free_nothing);
+    ResultCode result = matches != NULL ? json_filter_select_range(work->trie->step.data.filter, work->node, first, last, matches)
+                                        : CODE_MEMORY_ERROR;
+    if (result == CODE_OK)
+    {
+        result = json_path_trie_matches(matches->data, matches->size, work->trie, work->create ? work->created[index] : NULL, NULL, work->found[index]);
+    }
+    if (matches != NULL)
+    {
+        types_vector_free(matches);
+        free(matches);
+    }
+    return result;
+}
+
+static void json_path_trie_undo(Vector *created)
+{
+    // The nodes are erased from the last one created back, so every node goes before its parent
+    for (size_t i = types_vector_size(created); i > 0; i--)
+    {
+        node_erase(*(Node **)types_vector_at(created, i - 1));
+    }
+}
+
+static size_t json_path_trie_multiple(const PathTrie *trie, bool *branches)
+{
+    // Greatest number of wildcards and descendants in a path, and whether the paths ever part
+    size_t multiple = 0;
+    *branches = *branches || types_vector_size(trie->children) > 1;
+    for (size_t i = 0, n = types_vector_size(trie->children); i < n; i++)
+    {
+        const PathTrie *child = types_vector_at(trie->children, i);
+        const size_t below = json_path_trie_multiple(child, branches) +
+                             (child->step.id != PATH_STEP_INDEX && child->step.id != PATH_STEP_KEY);
+        multiple = below > multiple ? below : multiple;
+    }
+    return multiple;
+}
+
+static ResultCode json_path_matches(Node *node, const PathStep *step, Vector *matches)
+{
+    if (step->id == PATH_STEP_WILDCARD)
+    {
+        // Every child, in order
+        if (node->type == NODE_TYPE_ARRAY)
+        {
+            for (size_t i = 0, n = types_vector_size(node->data); i < n; i++)
+            {
+                if (types_vector_push(matches, types_vector_at(node->data, i)) != CODE_OK)
+                {
+                    return CODE_MEMORY_ERROR;
+                }
+            }
+        }
+        else if (node->type == NODE_TYPE_OBJECT && node->data != NULL)
+        {
+            const Vector *elements = ((Map *)node->data)->elements;
+            for (size_t i = 0, n = types_vector_size(elements); i < n; i++)
+            {
+                if (types_vector_push(matches, &((Pair *)types_vector_at(elements, i))->value) != CODE_OK)
+                {
+                    return CODE_MEMORY_ERROR;
+                }
+            }
+        }
+        return CODE_OK;
+    }
+    if (step->id == PATH_STEP_FILTER)
+    {
+        return json_filter_select(step->data.filter, node, matches);
+    }
+    if (step->id == PATH_STEP_DESCENDANT && node->index != NULL && node->parent == NULL)
+    {
+        // The index knows every node with the key, and below the root they all match. Below any
+        // other node its subtree is walked instead: sorting out the matches of the whole tree by
+        // their ancestors would cost more than the subtree, once for every such node
+        const Vector *indexed = node_index_find(node->index, &step->data.key, step->hash);
+        for (size_t i = 0, n = types_vector_size(indexed); i < n; i++)
+        {
+            if (types_vector_push(matches, types_vector_at(indexed, i)) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+        }
+        return CODE_OK;
+    }
+    return json_path_descendants(node, step, matches);
+}
+
+static ResultCode json_path_descendants(Node *node, const PathStep *step, Vector *matches)
+{
+    // Walk everything below the node, keeping the nodes with the key, or all of them
+    if (node->type == NODE_TYPE_ARRAY)
+    {
+        for (size_t i = 0, n = types_vector_size(node->data); i < n; i++)
+        {
+            Node **child = types_vector_at(node->data, i);
+            if ((step->id == PATH_STEP_DESCENDANTS && types_vector_push(matches, child) != CODE_OK) ||
+                json_path_descendants(*child, step, matches) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+        }
+    }
+    else if (node->type == NODE_TYPE_OBJECT && node->data != NULL)
+    {
+        const Vector *elements = ((Map *)node->data)->elements;
+        for (size_t i = 0, n = types_vector_size(elements); i < n; i++)
+        {
+            Pair *pair = types_vector_at(elements, i);
+            const String *key = pair->key;
+            const bool match = step->id == PATH_STEP_DESCENDANTS ||
+                               (pair->hash == step->hash && key->length == step->data.key.length &&
+                                memcmp(key->buffer, step->data.key.buffer, key->length) == 0);
+            if ((match && types_vector_push(matches, &pair->value) != CODE_OK) ||
+                json_path_descendants(pair->value, step, matches) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+        }
+    }
+    return CODE_OK;
+}
+
+static ResultCode json_path_order(Vector *nodes, const size_t start, const bool repeated)
+{
+    const size_t count = types_vector_size(nodes) - start;
+    if (count < 2)
+    {
+        return CODE_OK;
+    }
+    JsonPathFound *found = malloc(2 * count * sizeof(JsonPathFound));
+    if (found == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    JsonPathFound *sorted = found + count;
+    size_t deepest = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        found[i].node = *(Node **)types_vector_at(nodes, start + i);
+        found[i].order = i;
+        found[i].depth = 0;
+        for (const Node *ancestor = found[i].node->parent; ancestor != NULL; ancestor = ancestor->parent)
+        {
+            found[i].depth += 1;
+        }
+        deepest = found[i].depth > deepest ? found[i].depth : deepest;
+    }
+
+    // Only the first time each node was found is kept. Sorting by node puts the repeated ones
+    // together, and then they go back to the order they were found in without them
+    size_t kept = count;
+    if (repeated)
+    {
+        qsort(found, count, sizeof(JsonPathFound), json_path_compare_node);
+        for (size_t i = 0; i < count; i++)
+        {
+            sorted[found[i].order] = found[i];
+            if (i > 0 && found[i].node == found[i - 1].node)
+            {
+                sorted[found[i].order].node = NULL;
+            }
+        }
+        kept = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (sorted[i].node != NULL)
+            {
+                found[kept++] = sorted[i];
+            }
+        }
+    }
+
+    // Shallower nodes go first, which puts every node after its ancestors. Depths are small,
+    // so they are counted, and the nodes of the same depth keep the order they were found in
+    size_t *offsets = calloc(deepest + 2, sizeof(size_t));
+    if (offsets == NULL)
+    {
+        free(found);
+        return CODE_MEMORY_ERROR;
+    }
+    for (size_t i = 0; i < kept; i++)
+    {
+        offsets[found[i].depth + 1] += 1;
+    }
+    for (size_t depth = 1; depth <= deepest; depth++)
+    {
+        offsets[depth] += offsets[depth - 1];
+    }
+    for (size_t i = 0; i < kept; i++)
+    {
+        sorted[offsets[found[i].depth]++] = found[i];
+    }
+    nodes->size = start;
+    for (size_t i = 0; i < kept; i++)
+    {
+        types_vector_push(nodes, &sorted[i].node);
+    }
+    free(offsets);
+    free(found);
+    return CODE_OK;
+}
+
+static int json_path_compare_node(const void *found1, const void *found2)
+{
+    const JsonPathFound *first = found1;
+    const JsonPathFound *second = found2;
+    if (first->node != second->node)
+    {
+        return (uintptr_t)first->node < (uintptr_t)second->node ? -1 : 1;
+    }
+    return first->order < second->order ? -1 : first->order > second->order;
+}
+
+static ResultCode json_path_free_nothing(void *node)
+{
+    // The vectors of matches only point to nodes of the tree
+    return CODE_OK;
+}
+
+static ResultCode json_path_trie_free_callback(void *trie)
+{
+    return json_path_trie_free(trie);
+}
+
+static ResultCode json_path_free_step(void *step)
+{
+    PathStep *path_step = step;
+    if (path_step->id == PATH_STEP_FILTER)
+    {
+        return json_filter_free(path_step->data.filter);
+    }
+    if (json_path_step_has_key(path_step))
+    {
+        return types_string_free(&path_step->data.key);
+    }
+    return CODE_OK;
+}
+
+static ResultCode json_path_free_steps(void *steps)
+{
+    return types_vector_free(steps);
+}
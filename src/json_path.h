@@ -3,23 +3,42 @@
 
 #include "types/types_vector.h"
 #include "types/types_string.h"
+#include "node.h"
+#include "thread_pool.h"
+
+/// @brief Greatest number of paths a single json path can expand to through its unions
+#define JSON_PATH_MAX_PATHS 4096
+
+/// @brief Fewest children of an array for a wildcard or a filter over it to be split among threads
+#define JSON_PATH_PARALLEL_MIN 1024
+
+/// @brief Number of slices of an array given to each thread, so threads that finish early take more
+#define JSON_PATH_PARALLEL_SLICES 4
 
 enum PathStepId
 {
     PATH_STEP_INDEX,
-    PATH_STEP_KEY
+    PATH_STEP_KEY,
+    PATH_STEP_WILDCARD,    // Every child
+    PATH_STEP_DESCENDANT,  // Every node below with the key
+    PATH_STEP_DESCENDANTS, // Every node below
+    PATH_STEP_FILTER       // Every child for which a filter expression holds
 };
 
 union PathStepData_u
 {
     int index;
     String key;
+    struct JsonFilter_st *filter; // Compiled filter, shared by the copies of the step
 };
 
+/// @brief A compiled step of a path. Keys are hashed when the path is compiled, so running the
+/// path over any number of documents never hashes them again
 typedef struct PathStep_st
 {
     enum PathStepId id;
     union PathStepData_u data;
+    size_t hash; // Hash of the key, for PATH_STEP_KEY and PATH_STEP_DESCENDANT
 } PathStep;
 
 typedef struct JsonPath_st
@@ -29,6 +48,78 @@ typedef struct JsonPath_st
     Vector *paths;    // Each path here is a vector of steps
 } JsonPath;
 
+/// @brief The paths of a json path merged by their common prefixes, so that a prefix shared by
+/// many paths is followed only once
+typedef struct PathTrie_st
+{
+    PathStep step;    // Step from the parent to this node, unused at the root
+    bool end;         // Indicates if one of the paths ends here
+    Vector *children; // Each child here is a PathTrie, in the order of the paths, or NULL for none
+} PathTrie;
+
+/// @brief Compile a json path into the steps of each of the paths it stands for. The syntax is
+/// `$` followed by any number of `.name` or `[selectors]`, where the selectors are indexes,
+/// quoted keys or `*`, separated by commas. Every selector of a union gives a different path, so
+/// `$.a[0,1]` stands for `$.a[0]` and `$.a[1]`. The wildcard `.*` or `[*]` selects every child,
+/// and `..name` or `..['name']` every node below with that key, or every node below for `..*`.
+/// A filter `[?(expression)]` selects the children for which the expression holds, as described
+/// in json_filter_compile
+/// @param string Json path
+/// @retval Compiled path, whose valid member tells if the syntax was correct
+/// @retval NULL if a problem was encountered
 JsonPath *json_path_parse(const String *string);
 
-#endif
\ No newline at end of file
+/// @brief Follow the steps of a compiled path from a node. Wildcards and descendants stand for
+/// many nodes, so only json_path_trie_evaluate follows them, and here they lead nowhere
+/// @param node Node where the path starts
+/// @param steps Steps of one of the paths, as found in JsonPath.paths
+/// @retval Node at the end of the path
+/// @retval NULL if the path does not lead anywhere in this tree
+Node *json_path_evaluate(Node *node, const Vector *steps);
+
+/// @brief Merge the paths of a compiled json path into a trie
+/// @param path Compiled path, which must be valid
+/// @retval Root of the trie
+/// @retval NULL if a problem was encountered
+PathTrie *json_path_trie_create(const JsonPath *path);
+
+/// @brief Find the nodes at the end of every path of a trie with a single depth-first walk of
+/// the tree. Definite steps look up each node at most once. Descendants of the root are found
+/// through the key index of the tree when it has one, which takes time proportional to the matches
+/// @param root Node where the paths start
+/// @param trie Trie of the paths
+/// @param create Indicates if the missing steps are created along the way. A missing key or index
+/// followed by a key becomes an empty object, followed by an index an empty array, and otherwise
+/// null, so `$.a.b[0]` can be created on `{}`. An index can only be created right after the last
+/// element of its array
+/// @param nodes Vector of Node * where the nodes found are pushed once each, parents before their children
+/// @return Result code, CODE_LOGIC_ERROR if some path made only of definite steps does not lead
+/// anywhere. Missing steps after a wildcard or a descendant simply do not match
+ResultCode json_path_trie_evaluate(Node *root, const PathTrie *trie, const bool create, Vector *nodes);
+
+/// @brief Find the nodes at the end of every path of a trie like json_path_trie_evaluate, with
+/// the work split among the threads of a pool. A wildcard or a filter over an array with at least
+/// JSON_PATH_PARALLEL_MIN children cuts it into contiguous slices, and each thread runs the rest
+/// of the paths below the children of a slice. The slices are joined in order, so the nodes found
+/// are the same as without a pool. Missing steps are created below each child only, so threads
+/// never change the same part of the tree. With create, arrays of a tree with a key index are
+/// walked by a single thread, as the index is shared by the whole tree
+/// @param root Node where the paths start
+/// @param trie Trie of the paths
+/// @param create Indicates if the missing steps are created along the way, as for json_path_trie_evaluate
+/// @param pool Pool of threads, or NULL to do everything in this thread
+/// @param nodes Vector of Node * where the nodes found are pushed once each, parents before their children
+/// @return Result code, as for json_path_trie_evaluate
+ResultCode json_path_trie_evaluate_parallel(Node *root, const PathTrie *trie, const bool create, ThreadPool *pool, Vector *nodes);
+
+/// @brief Free the memory used by a trie, but not the trie itself
+/// @param trie Trie of the paths
+/// @return Result code
+ResultCode json_path_trie_free(PathTrie *trie);
+
+/// @brief Free the memory used by a compiled path, but not the path itself
+/// @param path Compiled path
+/// @return Result code
+ResultCode json_path_free(JsonPath *path);
+
+#endif
@@ -2,11 +2,26 @@
 #include <string.h>
 
 #include "node.h"
+#include "node_index.h"
 #include "types/types_vector.h"
 #include "types/types_map.h"
+#include "types/types_memory.h"
 #include "write.h"
 #include "read/read.h"
 
+// Callbacks used by the containers that hold the children of a node.
+// Arrays store Node * elements, objects store String * keys and Node * values
+static ResultCode node_free_element(void *element);
+static ResultCode node_free_key(void *key);
+static ResultCode node_free_value(void *value);
+static bool node_compare_key(const void *key1, const void *key2);
+static void *node_copy_key(const void *key);
+static void *node_copy_value(const void *value);
+static size_t node_hash_key(const void *key);
+static void node_stats_string(const String *string, NodeStats *stats, size_t *node_bytes);
+static void node_forget_source(Node *node);
+static ResultCode node_reserve(Vector *vector);
+
 Node *node_create()
 {
     Node *node = malloc(sizeof(Node));
@@ -14,14 +29,38 @@ Node *node_create()
     {
         return NULL;
     }
+    types_memory_allocate(MEMORY_CATEGORY_NODE, sizeof(Node));
 
     // Default values
     node->type = NODE_TYPE_NULL;
+    node->dirty = false;
+    node->key_dirty = false;
     node->parent = NULL;
     node->data = NULL;
+    node->source_start = 0;
+    node->source_end = 0;
+    node->index = NULL;
     return node;
 }
 
+ResultCode node_set_number(Node *node, const double value)
+{
+    if (node == NULL || node->data != NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    double *data = malloc(sizeof(double));
+    if (data == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    types_memory_allocate(MEMORY_CATEGORY_NODE, sizeof(double));
+    *data = value;
+    node->type = NODE_TYPE_NUMBER;
+    node->data = data;
+    return CODE_OK;
+}
+
 String *node_to_string(const Node *node)
 {
     return write_to_string(node);
@@ -73,6 +112,20 @@ Node *node_get(Node *node, const String *key)
     return (Node *)types_map_at(map, key);
 }
 
+Node *node_get_hashed(Node *node, const String *key, const size_t hash)
+{
+    if (node == NULL || key == NULL || node->type != NODE_TYPE_OBJECT || node->data == NULL)
+    {
+        return NULL;
+    }
+    Iterator pair = types_map_find_hashed(node->data, key, hash);
+    if (types_iterator_equal(pair, types_iterator_invalid()))
+    {
+        return NULL;
+    }
+    return ((Pair *)types_iterator_get(pair))->value;
+}
+
 ResultCode node_append(Node *node, const String *key, const Node *child)
 {
     if (node == NULL || key == NULL || child == NULL)
@@ -86,13 +139,42 @@ ResultCode node_append(Node *node, const String *key, const Node *child)
         return CODE_LOGIC_ERROR;
     }
 
-    // Add the key value to the existant map
+    // Create the map on the first insertion
+    if (node->data == NULL)
+    {
+        node->data = types_map_create(sizeof(String *), sizeof(Node *),
+                                      node_free_key, node_free_value, node_compare_key,
+                                      node_copy_key, node_copy_value, node_hash_key);
+        if (node->data == NULL)
+        {
+            return CODE_MEMORY_ERROR;
+        }
+    }
+
+    // Add the key value to the existant map. The map keeps the child itself
     Map *map = node->data;
-    if (map == NULL)
+    if (node_reserve(map->elements) != CODE_OK)
     {
         return CODE_MEMORY_ERROR;
     }
-    types_map_insert(map, key, child);
+    Iterator inserted = types_map_insert(map, key, child);
+    if (types_iterator_equal(inserted, types_iterator_invalid()))
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    ((Node *)child)->parent = node;
+    node_mark_dirty(node);
+
+    // The child and everything below it join the index of the tree, if there is one
+    if (node->index != NULL)
+    {
+        const Pair *pair = types_iterator_get(inserted);
+        if (node_index_insert(node->index, key, pair->hash, (Node *)child) != CODE_OK ||
+            node_index_insert_below(node->index, (Node *)child) != CODE_OK)
+        {
+            return CODE_MEMORY_ERROR;
+        }
+    }
 
     return CODE_OK;
 }
@@ -110,7 +192,9 @@ ResultCode node_erase(Node *node)
         return CODE_MEMORY_ERROR;
     }
 
-    switch (node->parent->type)
+    // The parent loses one of its children
+    Node *parent = node->parent;
+    switch (parent->type)
     {
     case NODE_TYPE_NULL:
     case NODE_TYPE_TRUE:
@@ -120,14 +204,19 @@ ResultCode node_erase(Node *node)
         return CODE_MEMORY_ERROR;
     case NODE_TYPE_ARRAY:
     {
-        Vector *vector = node->parent->data;
+        Vector *vector = parent->data;
         for (Iterator current = types_vector_begin(vector), end = types_vector_end(vector);
              !types_iterator_equal(current, end);
-             types_iterator_increase(current, 1))
+             current = types_iterator_increase(current, 1))
         {
-            if (types_iterator_get(current) == node)
+            if (*(Node **)types_iterator_get(current) == node)
             {
                 // This is the one that needs to be removed
+                if (node_index_remove_below(node->index, node) != CODE_OK)
+                {
+                    return CODE_LOGIC_ERROR;
+                }
+                node_mark_dirty(parent);
                 return types_vector_erase(vector, current, types_iterator_increase(current, 1));
             }
         }
@@ -135,21 +224,28 @@ ResultCode node_erase(Node *node)
     }
     case NODE_TYPE_OBJECT:
     {
-        Map *map = node->parent->data;
+        Map *map = parent->data;
         for (Iterator current = types_map_begin(map), end = types_map_end(map);
              !types_iterator_equal(current, end);
-             types_iterator_increase(current, 1))
+             current = types_iterator_increase(current, 1))
         {
             Pair *pair = types_iterator_get(current);
             if (pair->value == node)
             {
                 // This is the one that needs to be removed
+                if (node->index != NULL && (node_index_remove(node->index, pair->key, pair->hash, node) != CODE_OK ||
+                                            node_index_remove_below(node->index, node) != CODE_OK))
+                {
+                    return CODE_LOGIC_ERROR;
+                }
+                node_mark_dirty(parent);
                 return types_map_erase(map, current, types_iterator_increase(current, 1));
             }
         }
         return CODE_LOGIC_ERROR;
     }
     }
+    return CODE_LOGIC_ERROR;
 }
 
 ResultCode node_set_key(Node *node, const String *key)
@@ -175,15 +271,23 @@ ResultCode node_set_key(Node *node, const String *key)
     Map *map = node->parent->data;
     for (Iterator current = types_map_begin(map), end = types_map_end(map);
          !types_iterator_equal(current, end);
-         types_iterator_increase(current, 1))
+         current = types_iterator_increase(current, 1))
     {
         Pair *pair = types_iterator_get(current);
         if (pair->value == node)
         {
-            // Change the key here because we know the index
-            types_string_free(pair->key);
-            free(pair->key);
-            pair->key = types_string_copy(key);
+            // Change the key here because we know the index. The node moves to its new key
+            // in the index of the tree, if there is one
+            if ((node->index != NULL && node_index_remove(node->index, pair->key, pair->hash, node) != CODE_OK) ||
+                types_map_rekey(map, current, key) != CODE_OK ||
+                (node->index != NULL && node_index_insert(node->index, pair->key, pair->hash, node) != CODE_OK))
+            {
+                return CODE_MEMORY_ERROR;
+            }
+
+            // The key is written by the parent, the value itself is unchanged
+            node->key_dirty = true;
+            node_mark_dirty(node->parent);
             return CODE_OK;
         }
     }
@@ -198,12 +302,40 @@ ResultCode node_set_data(Node *node, const Node *new)
         return CODE_MEMORY_ERROR;
     }
 
-    // Clean the memory used by the previous data
+    // The node gets a copy of the new data, so the same value can be given to many nodes and
+    // the caller keeps its own
+    Node *copy = node_copy(new);
+    if (copy == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // Clean the memory used by the previous data, which leaves the index of the tree
+    if (node_index_remove_below(node->index, node) != CODE_OK)
+    {
+        node_destroy(copy);
+        return CODE_LOGIC_ERROR;
+    }
     node_free(node);
 
-    // Assign new data
-    node->type = new->type;
-    node->data = new->data;
+    // Assign new data. The children that come with it now hang from this node
+    node->type = copy->type;
+    node->data = copy->data;
+    copy->type = NODE_TYPE_NULL;
+    copy->data = NULL;
+    node_destroy(copy);
+    const size_t source_start = node->source_start;
+    const size_t source_end = node->source_end;
+    node_forget_source(node);
+    node_mark_dirty(node);
+    if (node_index_insert_below(node->index, node) != CODE_OK)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // The node itself still stands where it was read, so the text around it can be kept
+    node->source_start = source_start;
+    node->source_end = source_end;
     return CODE_OK;
 }
 
@@ -220,13 +352,25 @@ ResultCode node_array_push(Node *root, Node *node)
         return CODE_LOGIC_ERROR;
     }
 
-    // Push it to the existing list
+    // Create the vector on the first insertion
+    if (root->data == NULL)
+    {
+        root->data = types_vector_create(sizeof(Node *), node_free_element);
+        if (root->data == NULL)
+        {
+            return CODE_MEMORY_ERROR;
+        }
+    }
+
+    // Push it to the existing list. The vector stores the pointer to the node
     Vector *vector = root->data;
-    if (types_vector_push(vector, node) != CODE_OK)
+    if (node_reserve(vector) != CODE_OK || types_vector_push(vector, &node) != CODE_OK)
     {
         return CODE_LOGIC_ERROR;
     }
-    return CODE_OK;
+    node->parent = root;
+    node_mark_dirty(root);
+    return node_index_insert_below(root->index, node);
 }
 
 Iterator node_array_begin(Node *node)
@@ -271,7 +415,16 @@ ResultCode node_array_insert(Node *node, Iterator first, Iterator last, Iterator
     }
 
     Vector *vector = node->data;
-    return types_vector_insert(vector, first, last, destination);
+    node_mark_dirty(node);
+    ResultCode result = types_vector_insert(vector, first, last, destination);
+
+    // The new elements join the index of the tree, if there is one
+    for (Iterator current = first; result == CODE_OK && node->index != NULL && !types_iterator_equal(current, last);
+         current = types_iterator_increase(current, 1))
+    {
+        result = node_index_insert_below(node->index, *(Node **)types_iterator_get(current));
+    }
+    return result;
 }
 
 size_t node_array_size(Node *node)
@@ -299,8 +452,27 @@ Node *node_array_get(Node *node, size_t index)
         return NULL;
     }
 
-    Vector *vector = node->data;
-    return (Node *)types_vector_at(vector, index);
+    Node **element = types_vector_at(node->data, index);
+    if (element == NULL)
+    {
+        return NULL;
+    }
+    return *element;
+}
+
+void node_mark_dirty(Node *node)
+{
+    // Once a node is dirty all its ancestors are as well, so the walk can stop there
+    while (node != NULL && !node->dirty)
+    {
+        node->dirty = true;
+        node = node->parent;
+    }
+}
+
+bool node_is_clean(const Node *node)
+{
+    return node != NULL && !node->dirty && node->source_end > node->source_start;
 }
 
 ResultCode node_free(void *node)
@@ -312,15 +484,23 @@ ResultCode node_free(void *node)
     switch (my_node->type)
     {
     case NODE_TYPE_NULL:
-    case NODE_TYPE_NUMBER:
     case NODE_TYPE_TRUE:
     case NODE_TYPE_FALSE:
         break;
+    case NODE_TYPE_NUMBER:
+        if (my_node->data != NULL)
+        {
+            types_memory_release(MEMORY_CATEGORY_NODE, sizeof(double));
+        }
+        break;
     case NODE_TYPE_STRING:
         result = types_string_free(my_node->data);
         break;
     case NODE_TYPE_ARRAY:
-        result = types_vector_free(my_node->data);
+        if (my_node->data != NULL)
+        {
+            result = types_vector_free(my_node->data);
+        }
         break;
     case NODE_TYPE_OBJECT:
         result = types_map_free(my_node->data);
@@ -335,4 +515,253 @@ ResultCode node_free(void *node)
     my_node->type = NODE_TYPE_NULL;
 
     return result;
-}
\ No newline at end of file
+}
+
+ResultCode node_destroy(Node *node)
+{
+    if (node == NULL)
+    {
+        return CODE_OK;
+    }
+    ResultCode result = node_free(node);
+    types_memory_release(MEMORY_CATEGORY_NODE, sizeof(Node));
+    free(node);
+    return result;
+}
+
+Node *node_copy(const Node *node)
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+    Node *copy = node_create();
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+
+    // The children are copied one by one, and hang from the copy
+    ResultCode result = CODE_OK;
+    copy->type = node->type;
+    switch (node->type)
+    {
+    case NODE_TYPE_NULL:
+    case NODE_TYPE_TRUE:
+    case NODE_TYPE_FALSE:
+        break;
+    case NODE_TYPE_NUMBER:
+        if (node->data != NULL)
+        {
+            result = node_set_number(copy, *(const double *)node->data);
+        }
+        break;
+    case NODE_TYPE_STRING:
+        if (node->data != NULL)
+        {
+            copy->data = types_string_copy(node->data);
+            result = copy->data != NULL ? CODE_OK : CODE_MEMORY_ERROR;
+        }
+        break;
+    case NODE_TYPE_ARRAY:
+        for (size_t i = 0, n = node->data != NULL ? types_vector_size(node->data) : 0; i < n && result == CODE_OK; i++)
+        {
+            Node *child = node_copy(*(Node **)types_vector_at(node->data, i));
+            if (child == NULL || node_array_push(copy, child) != CODE_OK)
+            {
+                node_destroy(child);
+                result = CODE_MEMORY_ERROR;
+            }
+        }
+        break;
+    case NODE_TYPE_OBJECT:
+        for (size_t i = 0, n = node->data != NULL ? types_map_size(node->data) : 0; i < n && result == CODE_OK; i++)
+        {
+            const Pair *pair = types_vector_at(((Map *)node->data)->elements, i);
+            Node *child = node_copy(pair->value);
+            if (child == NULL || node_append(copy, pair->key, child) != CODE_OK)
+            {
+                node_destroy(child);
+                result = CODE_MEMORY_ERROR;
+            }
+        }
+        break;
+    }
+    if (result != CODE_OK)
+    {
+        node_destroy(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+ResultCode node_stats(const Node *node, NodeStats *stats)
+{
+    if (node == NULL || stats == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // The node itself
+    size_t node_bytes = sizeof(Node);
+
+    // Plus its own data, depending on the type
+    switch (node->type)
+    {
+    case NODE_TYPE_NULL:
+    case NODE_TYPE_TRUE:
+    case NODE_TYPE_FALSE:
+        break;
+    case NODE_TYPE_NUMBER:
+        node_bytes += node->data != NULL ? sizeof(double) : 0;
+        break;
+    case NODE_TYPE_STRING:
+        node_stats_string(node->data, stats, &node_bytes);
+        break;
+    case NODE_TYPE_ARRAY:
+    {
+        const Vector *vector = node->data;
+        if (vector == NULL)
+        {
+            break;
+        }
+        const size_t bytes = sizeof(Vector) + vector->capacity * vector->element_size;
+        node_bytes += bytes;
+        stats->container_bytes += bytes;
+        stats->container_overhead_bytes += sizeof(Vector) + (vector->capacity - vector->size) * vector->element_size;
+        for (size_t i = 0, n = types_vector_size(vector); i < n; i++)
+        {
+            if (node_stats(*(Node **)types_vector_at(vector, i), stats) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+        }
+        break;
+    }
+    case NODE_TYPE_OBJECT:
+    {
+        const Map *map = node->data;
+        if (map == NULL)
+        {
+            break;
+        }
+        const Vector *elements = map->elements;
+        const size_t bytes = sizeof(Map) + sizeof(Vector) + elements->capacity * elements->element_size;
+        node_bytes += bytes;
+        stats->container_bytes += bytes;
+        stats->container_overhead_bytes += sizeof(Map) + sizeof(Vector) + (elements->capacity - elements->size) * elements->element_size;
+        for (size_t i = 0, n = types_vector_size(elements); i < n; i++)
+        {
+            const Pair *pair = types_vector_at(elements, i);
+            node_stats_string(pair->key, stats, &node_bytes);
+            if (node_stats(pair->value, stats) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+        }
+        break;
+    }
+    }
+
+    stats->nodes[node->type] += 1;
+    stats->node_bytes[node->type] += node_bytes;
+    stats->total_bytes += node_bytes;
+    return CODE_OK;
+}
+
+static void node_stats_string(const String *string, NodeStats *stats, size_t *node_bytes)
+{
+    if (string == NULL)
+    {
+        return;
+    }
+    const size_t bytes = sizeof(String) + string->capacity;
+    stats->string_bytes += bytes;
+    *node_bytes += bytes;
+}
+
+static ResultCode node_reserve(Vector *vector)
+{
+    // Children are added one at a time, so the room for them grows geometrically
+    if (types_vector_size(vector) < vector->capacity)
+    {
+        return CODE_OK;
+    }
+    return types_vector_reserve(vector, vector->capacity < 4 ? 4 : 2 * vector->capacity);
+}
+
+static void node_forget_source(Node *node)
+{
+    node->source_start = 0;
+    node->source_end = 0;
+    switch (node->type)
+    {
+    case NODE_TYPE_ARRAY:
+        for (size_t i = 0, n = types_vector_size(node->data); i < n; i++)
+        {
+            Node *child = *(Node **)types_vector_at(node->data, i);
+            child->parent = node;
+            node_forget_source(child);
+        }
+        break;
+    case NODE_TYPE_OBJECT:
+        for (size_t i = 0, n = types_map_size(node->data); i < n; i++)
+        {
+            Node *child = ((Pair *)types_vector_at(((Map *)node->data)->elements, i))->value;
+            child->parent = node;
+            node_forget_source(child);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static ResultCode node_free_element(void *element)
+{
+    // Vectors hand over a pointer to the element, which is itself a Node *
+    if (element == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    ResultCode result = node_destroy(*(Node **)element);
+    *(Node **)element = NULL;
+    return result;
+}
+
+static ResultCode node_free_key(void *key)
+{
+    ResultCode result = types_string_free(key);
+    free(key);
+    return result;
+}
+
+static ResultCode node_free_value(void *value)
+{
+    return node_destroy(value);
+}
+
+static bool node_compare_key(const void *key1, const void *key2)
+{
+    // Maps expect the same convention as strcmp. Keys may hold NULL characters,
+    // so the lengths are compared too
+    const size_t length = types_string_length(key1);
+    return length != types_string_length(key2) ||
+           memcmp(types_string_c_str(key1), types_string_c_str(key2), length) != 0;
+}
+
+static size_t node_hash_key(const void *key)
+{
+    return types_string_hash(key);
+}
+
+static void *node_copy_key(const void *key)
+{
+    return types_string_copy(key);
+}
+
+static void *node_copy_value(const void *value)
+{
+    // Children are owned by the map, so they are not copied
+    return (void *)value;
+}
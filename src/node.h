@@ -16,16 +16,42 @@ typedef enum
     NODE_TYPE_OBJECT
 } NodeType;
 
+/// @brief Number of values in NodeType
+#define NODE_TYPE_NUMBER_OF_TYPES 7
+
 /// @brief Definition of a node structure
 typedef struct Node_st
 {
     NodeType type;
+    bool dirty;     // Set when the node, or anything below it, has changed since it was read
+    bool key_dirty; // Set when the key of the node in its parent object has changed since it was read
     struct Node_st *parent;
-    void *data;
+    void *data;                 // String * for strings, double * for numbers, Vector * of Node * for arrays, Map * for objects
+    size_t source_start;        // Byte span [source_start, source_end) of the node in the text it was read from,
+    size_t source_end;          // empty if the node was not read from a text
+    struct NodeIndex_st *index; // Key index of the tree the node belongs to, or NULL if it has none
 } Node;
 
+/// @brief Memory used by a tree of nodes
+typedef struct NodeStats_st
+{
+    size_t nodes[NODE_TYPE_NUMBER_OF_TYPES];      // Number of nodes of each type
+    size_t node_bytes[NODE_TYPE_NUMBER_OF_TYPES]; // Bytes used by the nodes of each type and their own data, children excluded
+    size_t string_bytes;                          // Bytes used by strings, both keys and values
+    size_t container_bytes;                       // Bytes used by vectors and maps, including their buffers
+    size_t container_overhead_bytes;              // Part of container_bytes not holding elements: headers and unused capacity
+    size_t total_bytes;                           // Bytes used by the whole tree
+} NodeStats;
+
 Node *node_create();
 
+/// @brief Make a new node a number. The value is kept in a block of its own, recorded by the
+/// memory accounting with the nodes
+/// @param node Node that holds no data yet
+/// @param value Value of the number
+/// @return Result code, and the node is left as it was on failure
+ResultCode node_set_number(Node *node, const double value);
+
 String *node_to_string(const Node *node);
 
 Node *node_from_string(const String *string);
@@ -36,12 +62,25 @@ Node *node_get_parent(const Node *node);
 
 Node *node_get(Node *node, const String *key);
 
+/// @brief Find the child of an object with a key whose hash was computed beforehand with
+/// types_string_hash, so repeated lookups of the same key do not hash it again
+/// @param node Object
+/// @param key Key
+/// @param hash Hash of the key
+/// @retval Child
+/// @retval NULL if the node is not an object or has no such key
+Node *node_get_hashed(Node *node, const String *key, const size_t hash);
+
 ResultCode node_append(Node *node, const String *key, const Node *child);
 
 ResultCode node_erase(Node *node);
 
 ResultCode node_set_key(Node *node, const String *key);
 
+/// @brief Replace the data of a node with a copy of the data of another one
+/// @param node Node that changes
+/// @param new Node holding the new data, which still belongs to the caller
+/// @return Result code
 ResultCode node_set_data(Node *node, const Node *new);
 
 ResultCode node_array_push(Node *root, Node *node);
@@ -56,8 +95,27 @@ size_t node_array_size(Node *node);
 
 Node *node_array_get(Node *node, size_t index);
 
+/// @brief Record that a node has changed, together with all its ancestors, so none of them
+/// is written back from the text it was read from
+/// @param node Node that has changed
+void node_mark_dirty(Node *node);
+
+/// @brief Decide if a node can be written by copying the text it was read from
+/// @param node Node
+/// @return True if the node has a source span and nothing in it has changed since it was read
+bool node_is_clean(const Node *node);
+
 ResultCode node_free(void *node);
 
+ResultCode node_destroy(Node *node);
+
+ResultCode node_stats(const Node *node, NodeStats *stats);
+
+/// @brief Copy a node and everything below it. The copy has no parent and was not read from
+/// any text, so it is written by formatting it
+/// @param node Node
+/// @retval Copy, to be freed with node_destroy
+/// @retval NULL if a problem was encountered
 Node *node_copy(const Node *node);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include <string.h>
+
+#include "node_index.h"
+#include "types/types_map.h"
+
+/// @brief Number of entries of a new index
+#define NODE_INDEX_INITIAL_CAPACITY 64
+
+static NodeIndexEntry *node_index_slot(const NodeIndex *index, const String *key, const size_t hash);
+static ResultCode node_index_grow(NodeIndex *index);
+static void node_index_detach(Node *node);
+static ResultCode node_index_free_node(void *node);
+
+NodeIndex *node_index_create(Node *root)
+{
+    if (root == NULL)
+    {
+        return NULL;
+    }
+    NodeIndex *index = malloc(sizeof(NodeIndex));
+    if (index == NULL)
+    {
+        return NULL;
+    }
+    index->capacity = NODE_INDEX_INITIAL_CAPACITY;
+    index->size = 0;
+    index->entries = calloc(index->capacity, sizeof(NodeIndexEntry));
+    if (index->entries == NULL || node_index_insert_below(index, root) != CODE_OK)
+    {
+        // None of the nodes can be left pointing to the index
+        node_index_detach(root);
+        node_index_free(index);
+        return NULL;
+    }
+    return index;
+}
+
+const Vector *node_index_find(const NodeIndex *index, const String *key, const size_t hash)
+{
+    if (index == NULL || key == NULL)
+    {
+        return NULL;
+    }
+    const NodeIndexEntry *entry = node_index_slot(index, key, hash);
+    return entry->key.buffer != NULL ? entry->nodes : NULL;
+}
+
+ResultCode node_index_insert(NodeIndex *index, const String *key, const size_t hash, Node *node)
+{
+    if (index == NULL || key == NULL || node == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // Keep at least half of the entries free, so probes stay short
+    if (2 * (index->size + 1) > index->capacity && node_index_grow(index) != CODE_OK)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    NodeIndexEntry *entry = node_index_slot(index, key, hash);
+    if (entry->key.buffer == NULL)
+    {
+        // First node with this key. The entry keeps the contents of the copy of the key
+        String *copy = types_string_copy(key);
+        Vector *nodes = types_vector_create(sizeof(Node *), node_index_free_node);
+        if (copy == NULL || nodes == NULL)
+        {
+            if (copy != NULL)
+            {
+                types_string_free(copy);
+            }
+            free(copy);
+            free(nodes);
+            return CODE_MEMORY_ERROR;
+        }
+        entry->key = *copy;
+        entry->hash = hash;
+        entry->nodes = nodes;
+        free(copy);
+        index->size += 1;
+    }
+    return types_vector_push(entry->nodes, &node);
+}
+
+ResultCode node_index_remove(NodeIndex *index, const String *key, const size_t hash, const Node *node)
+{
+    if (index == NULL || key == NULL || node == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    NodeIndexEntry *entry = node_index_slot(index, key, hash);
+    if (entry->key.buffer == NULL)
+    {
+        return CODE_LOGIC_ERROR;
+    }
+
+    // The order does not matter, so the last node takes the place of the one removed
+    Vector *nodes = entry->nodes;
+    for (size_t i = types_vector_size(nodes); i > 0; i--)
+    {
+        if (*(Node **)types_vector_at(nodes, i - 1) == node)
+        {
+            memcpy(types_vector_at(nodes, i - 1), types_vector_at(nodes, nodes->size - 1), sizeof(Node *));
+            nodes->size -= 1;
+            return CODE_OK;
+        }
+    }
+    return CODE_LOGIC_ERROR;
+}
+
+ResultCode node_index_insert_below(NodeIndex *index, Node *node)
+{
+    if (index == NULL)
+    {
+        return CODE_OK;
+    }
+    node->index = index;
+    if (node->type == NODE_TYPE_ARRAY)
+    {
+        for (size_t i = 0, n = types_vector_size(node->data); i < n; i++)
+        {
+            if (node_index_insert_below(index, *(Node **)types_vector_at(node->data, i)) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+        }
+    }
+    else if (node->type == NODE_TYPE_OBJECT && node->data != NULL)
+    {
+        const Vector *elements = ((Map *)node->data)->elements;
+        for (size_t i = 0, n = types_vector_size(elements); i < n; i++)
+        {
+            const Pair *pair = types_vector_at(elements, i);
+            if (node_index_insert(index, pair->key, pair->hash, pair->value) != CODE_OK ||
+                node_index_insert_below(index, pair->value) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+        }
+    }
+    return CODE_OK;
+}
+
+ResultCode node_index_remove_below(NodeIndex *index, Node *node)
+{
+    if (index == NULL)
+    {
+        return CODE_OK;
+    }
+    if (node->type == NODE_TYPE_ARRAY)
+    {
+        for (size_t i = 0, n = types_vector_size(node->data); i < n; i++)
+        {
+            if (node_index_remove_below(index, *(Node **)types_vector_at(node->data, i)) != CODE_OK)
+            {
+                return CODE_LOGIC_ERROR;
+            }
+        }
+    }
+    else if (node->type == NODE_TYPE_OBJECT && node->data != NULL)
+    {
+        const Vector *elements = ((Map *)node->data)->elements;
+        for (size_t i = 0, n = types_vector_size(elements); i < n; i++)
+        {
+            const Pair *pair = types_vector_at(elements, i);
+            if (node_index_remove(index, pair->key, pair->hash, pair->value) != CODE_OK ||
+                node_index_remove_below(index, pair->value) != CODE_OK)
+            {
+                return CODE_LOGIC_ERROR;
+            }
+        }
+    }
+    return CODE_OK;
+}
+
+ResultCode node_index_free(NodeIndex *index)
+{
+    if (index == NULL)
+    {
+        return CODE_OK;
+    }
+    for (size_t i = 0; index->entries != NULL && i < index->capacity; i++)
+    {
+        NodeIndexEntry *entry = &index->entries[i];
+        if (entry->key.buffer != NULL)
+        {
+            types_string_free(&entry->key);
+            types_vector_free(entry->nodes);
+            free(entry->nodes);
+        }
+    }
+    free(index->entries);
+    free(index);
+    return CODE_OK;
+}
+
+static NodeIndexEntry *node_index_slot(const NodeIndex *index, const String *key, const size_t hash)
+{
+    // Entry with the key, or the unused entry where it would go
+    for (size_t i = hash & (index->capacity - 1);; i = (i + 1) & (index->capacity - 1))
+    {
+        NodeIndexEntry *entry = &index->entries[i];
+        if (entry->key.buffer == NULL ||
+            (entry->hash == hash && entry->key.length == key->length &&
+             memcmp(entry->key.buffer, key->buffer, key->length) == 0))
+        {
+            return entry;
+        }
+    }
+}
+
+static ResultCode node_index_grow(NodeIndex *index)
+{
+    NodeIndexEntry *entries = index->entries;
+    const size_t capacity = index->capacity;
+    index->entries = calloc(2 * capacity, sizeof(NodeIndexEntry));
+    if (index->entries == NULL)
+    {
+        index->entries = entries;
+        return CODE_MEMORY_ERROR;
+    }
+    index->capacity = 2 * capacity;
+
+    // Entries are moved to their place in the larger table, keeping their contents
+    for (size_t i = 0; i < capacity; i++)
+    {
+        if (entries[i].key.buffer != NULL)
+        {
+            *node_index_slot(index, &entries[i].key, entries[i].hash) = entries[i];
+        }
+    }
+    free(entries);
+    return CODE_OK;
+}
+
+static void node_index_detach(Node *node)
+{
+    node->index = NULL;
+    if (node->type == NODE_TYPE_ARRAY)
+    {
+        for (size_t i = 0, n = types_vector_size(node->data); i < n; i++)
+        {
+            node_index_detach(*(Node **)types_vector_at(node->data, i));
+        }
+    }
+    else if (node->type == NODE_TYPE_OBJECT && node->data != NULL)
+    {
+        const Vector *elements = ((Map *)node->data)->elements;
+        for (size_t i = 0, n = types_vector_size(elements); i < n; i++)
+        {
+            node_index_detach(((Pair *)types_vector_at(elements, i))->value);
+        }
+    }
+}
+
+static ResultCode node_index_free_node(void *node)
+{
+    // The index only points to the nodes, which belong to the tree
+    return CODE_OK;
+}
@@ -0,0 +1,73 @@
+#ifndef NODE_INDEX_H
+#define NODE_INDEX_H
+
+#include "node.h"
+#include "types/types_vector.h"
+
+/// @brief Nodes of a tree that hang from an object with the same key
+typedef struct NodeIndexEntry_st
+{
+    String key;    // Copy of the key, with a NULL buffer for an unused entry
+    size_t hash;   // Hash of the key, as computed by types_string_hash
+    Vector *nodes; // Vector of Node *, in no particular order
+} NodeIndexEntry;
+
+/// @brief Index from every key of a tree to the nodes that hang from it. Once created, the
+/// index is kept up to date by the functions that change the tree
+typedef struct NodeIndex_st
+{
+    NodeIndexEntry *entries; // Open addressing table, probed linearly
+    size_t capacity;         // Number of entries, always a power of two
+    size_t size;             // Number of entries in use
+} NodeIndex;
+
+/// @brief Index all the keys of a tree in one pass, and attach the index to all its nodes
+/// @param root Root of the tree
+/// @retval Index, owned by the caller, who must free it after the tree
+/// @retval NULL if a problem was encountered
+NodeIndex *node_index_create(Node *root);
+
+/// @brief Find the nodes that hang from an object with a key
+/// @param index Index
+/// @param key Key
+/// @param hash Hash of the key, as computed by types_string_hash
+/// @retval Vector of Node *, which may be empty
+/// @retval NULL if no node was ever indexed with the key
+const Vector *node_index_find(const NodeIndex *index, const String *key, const size_t hash);
+
+/// @brief Add a node to the nodes that hang from a key
+/// @param index Index
+/// @param key Key of the node in its parent
+/// @param hash Hash of the key
+/// @param node Node
+/// @return Result code
+ResultCode node_index_insert(NodeIndex *index, const String *key, const size_t hash, Node *node);
+
+/// @brief Remove a node from the nodes that hang from a key. This takes time proportional to
+/// the number of nodes with the same key
+/// @param index Index
+/// @param key Key of the node in its parent
+/// @param hash Hash of the key
+/// @param node Node
+/// @return Result code
+ResultCode node_index_remove(NodeIndex *index, const String *key, const size_t hash, const Node *node);
+
+/// @brief Attach the index to a node and to everything below it, and add all the keys below it
+/// @param index Index, or NULL to do nothing
+/// @param node Node that has just joined the tree
+/// @return Result code
+ResultCode node_index_insert_below(NodeIndex *index, Node *node);
+
+/// @brief Remove all the keys below a node, which is about to leave the tree or lose its children
+/// @param index Index, or NULL to do nothing
+/// @param node Node
+/// @return Result code
+ResultCode node_index_remove_below(NodeIndex *index, Node *node);
+
+/// @brief Free the memory used by the index, including the index itself. The nodes that
+/// still point to it are not changed
+/// @param index Index
+/// @return Result code
+ResultCode node_index_free(NodeIndex *index);
+
+#endif
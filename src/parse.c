@@ -3,4 +3,35 @@
 ParsedCommand *parse(const String *string)
 {
     return NULL;
-}
\ No newline at end of file
+}
+
+ResultCode parse_free(ParsedCommand *parsed_command)
+{
+    if (parsed_command == NULL)
+    {
+        return CODE_OK;
+    }
+    if (parsed_command->words != NULL)
+    {
+        types_vector_free(parsed_command->words);
+        free(parsed_command->words);
+    }
+    if (parsed_command->filename != NULL)
+    {
+        types_string_free(parsed_command->filename);
+        free(parsed_command->filename);
+    }
+    json_path_free(&parsed_command->path);
+
+    // The data holds the contents of a string, as the command requires
+    if (parsed_command->command == COMMAND_SET_VALUE)
+    {
+        types_string_free(&parsed_command->data.set_value_data.value);
+    }
+    else if (parsed_command->command == COMMAND_SET_KEY)
+    {
+        types_string_free(&parsed_command->data.set_key_data.key);
+    }
+    free(parsed_command);
+    return CODE_OK;
+}
@@ -40,4 +40,9 @@ typedef struct ParsedCommand_st
 
 ParsedCommand *parse(const String *string);
 
+/// @brief Free a parsed command, including the command itself
+/// @param parsed_command Parsed command, or NULL
+/// @return Result code
+ResultCode parse_free(ParsedCommand *parsed_command);
+
 #endif
\ No newline at end of file
@@ -1,47 +1,264 @@
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
 #include "read.h"
 #include "read_sm.h"
 #include "read_sm_define.h"
 #include "read_lex.h"
 #include "read_parse.h"
+#include "trace.h"
+
+static String *read_file(const String *filename);
+static size_t read_count_nodes(const Vector *tokens);
 
-ResultCode read_initialise()
+ReadContext *read_context_create(const ReadLexer *lexer)
 {
-    // Initialise the lexer
-    if (read_lex_initialise() != CODE_OK)
+    ReadContext *context = malloc(sizeof(ReadContext));
+    if (context == NULL)
     {
-        return CODE_ERROR;
+        return NULL;
     }
+    context->lexer = lexer != NULL ? lexer : read_lex_default();
+    context->tokens = read_tokens_create();
+    if (context->lexer == NULL || context->tokens == NULL)
+    {
+        read_context_free(context);
+        return NULL;
+    }
+    return context;
+}
 
-    // Initialise the parser
-
-    return CODE_OK;
+ResultCode read_context_free(ReadContext *context)
+{
+    if (context == NULL)
+    {
+        return CODE_OK;
+    }
+    ResultCode result = context->tokens != NULL ? types_vector_free(context->tokens) : CODE_OK;
+    free(context->tokens);
+    free(context);
+    return result;
 }
 
 Node *read_from_file(const String *filename)
 {
-    return NULL;
+    Document *document = read_document(filename);
+    if (document == NULL)
+    {
+        return NULL;
+    }
+
+    // Only the tree is kept
+    Node *root = document->root;
+    document->root = NULL;
+    document_free(document);
+    return root;
+}
+
+Document *read_document(const String *filename)
+{
+    ReadContext *context = read_context_create(NULL);
+    if (context == NULL)
+    {
+        return NULL;
+    }
+    Document *document = read_document_with_context(filename, context);
+    read_context_free(context);
+    return document;
+}
+
+Document *read_document_with_context(const String *filename, ReadContext *context)
+{
+    const uint64_t start = trace_begin();
+    String *source = read_file(filename);
+    if (source == NULL)
+    {
+        return NULL;
+    }
+    trace_end(TRACE_PHASE_READ, start, 0, types_string_length(source));
+    Node *root = read_from_string_with_context(source, context);
+    Document *document = document_create(root, source);
+    if (document == NULL)
+    {
+        node_destroy(root);
+        types_string_free(source);
+        free(source);
+        return NULL;
+    }
+    return document;
 }
 
 Node *read_from_string(const String *string)
 {
-    if (string == NULL || string->buffer == NULL)
+    ReadContext *context = read_context_create(NULL);
+    if (context == NULL)
     {
         return NULL;
     }
+    Node *node = read_from_string_with_context(string, context);
+    read_context_free(context);
+    return node;
+}
 
-    if (string->length == 0)
+Node *read_from_string_with_context(const String *string, ReadContext *context)
+{
+    if (string == NULL || string->buffer == NULL || context == NULL)
     {
         return NULL;
     }
 
-    // Go through the lexer
-    Vector *tokens = types_vector_create(sizeof(Token), read_lex_free_token);
-    if (read_lex(string, tokens) != CODE_OK)
+    if (string->length == 0)
     {
         return NULL;
     }
 
-    // Go through the parser
-    Node *node = read_parse(tokens);
+    // Go through the lexer, which empties the tokens but keeps their memory
+    Node *node = NULL;
+    uint64_t start = trace_begin();
+    if (read_lex(context->lexer, string, context->tokens) == CODE_OK)
+    {
+        trace_end(TRACE_PHASE_LEX, start, types_vector_size(context->tokens), string->length);
+
+        // Go through the parser, which keeps no state of its own
+        start = trace_begin();
+        node = read_parse(string, context->tokens);
+        trace_end(TRACE_PHASE_PARSE, start, start != 0 ? read_count_nodes(context->tokens) : 0, string->length);
+    }
     return node;
-}
\ No newline at end of file
+}
+
+Vector *read_tokens_create(void)
+{
+    return types_vector_create(sizeof(Token), read_lex_free_token);
+}
+
+Node *read_from_file_format(const String *filename, const Format format)
+{
+    if (format == FORMAT_JSON)
+    {
+        return read_from_file(filename);
+    }
+    String *source = read_file(filename);
+    if (source == NULL)
+    {
+        return NULL;
+    }
+    Node *root = format == FORMAT_CBOR ? read_from_cbor(source) : (format == FORMAT_MSGPACK ? read_from_msgpack(source) : NULL);
+    types_string_free(source);
+    free(source);
+    return root;
+}
+
+Snapshot *read_snapshot(const String *filename)
+{
+    if (filename == NULL)
+    {
+        return NULL;
+    }
+    int fd = open(types_string_c_str(filename), O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t)sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping stays valid after the file is closed
+    const size_t size = file_stat.st_size;
+    void *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+    Snapshot *snapshot = malloc(sizeof(Snapshot));
+    if (snapshot == NULL || !snapshot_check(base, size))
+    {
+        free(snapshot);
+        munmap(base, size);
+        return NULL;
+    }
+    snapshot->base = base;
+    snapshot->size = size;
+    snapshot->mapped = true;
+    return snapshot;
+}
+
+static String *read_file(const String *filename)
+{
+    if (filename == NULL)
+    {
+        return NULL;
+    }
+    int fd = open(types_string_c_str(filename), O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    // The whole text is kept in memory, so the file can later be overwritten in place
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size >= INT_MAX)
+    {
+        close(fd);
+        return NULL;
+    }
+    const size_t size = file_stat.st_size;
+    String *source = types_string_create();
+    if (source == NULL || types_string_reserve(source, size + 1) != CODE_OK)
+    {
+        close(fd);
+        if (source != NULL)
+        {
+            types_string_free(source);
+            free(source);
+        }
+        return NULL;
+    }
+    size_t length = 0;
+    while (length < size)
+    {
+        const ssize_t result = read(fd, source->buffer + length, size - length);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            break;
+        }
+        length += result;
+    }
+    close(fd);
+    if (length != size)
+    {
+        types_string_free(source);
+        free(source);
+        return NULL;
+    }
+    source->buffer[length] = '\0';
+    source->length = length;
+    return source;
+}
+
+static size_t read_count_nodes(const Vector *tokens)
+{
+    // Every value and every opening of a container is a node, except the strings used as keys,
+    // which are the ones followed by a colon
+    size_t nodes = 0;
+    for (size_t i = 0, n = types_vector_size(tokens); i < n; i++)
+    {
+        const enum TokenId id = ((const Token *)types_vector_at(tokens, i))->id;
+        nodes += id <= TOKEN_ID_NULL || id == TOKEN_ID_LEFT_BRACE || id == TOKEN_ID_LEFT_BRACKET;
+        nodes -= id == TOKEN_ID_COLON;
+    }
+    return nodes;
+}
@@ -3,11 +3,90 @@
 
 #include "utils.h"
 #include "node.h"
+#include "document.h"
+#include "snapshot.h"
+#include "read_lex.h"
 
-ResultCode read_initialise();
+/// @brief Everything a reader keeps from one text to the next: the lexer, which may be shared,
+/// and the tokens of the last text read. A context is used by one thread at a time, so threads
+/// that read at once each have their own, and reading many texts with one context reuses the
+/// memory of the largest
+typedef struct ReadContext_st
+{
+    const ReadLexer *lexer; // Lexer, owned by the caller or the shared one
+    Vector *tokens;         // Vector of Token, emptied on each read
+} ReadContext;
+
+/// @brief Create a context for a reader
+/// @param lexer Lexer used by the context, which has to outlive it, or NULL for the shared one
+/// @retval Context, to be freed with read_context_free
+/// @retval NULL if a problem was encountered
+ReadContext *read_context_create(const ReadLexer *lexer);
+
+/// @brief Free a context, including the context itself but not its lexer
+/// @param context Context
+/// @return Result code
+ResultCode read_context_free(ReadContext *context);
 
 Node *read_from_file(const String *filename);
 
+/// @brief Read a file into a document, which keeps the text of the file so that the nodes
+/// that are not modified can be written back as they were
+/// @param filename Name of the file
+/// @retval Document
+/// @retval NULL if the file could not be read or is not valid JSON
+Document *read_document(const String *filename);
+
+/// @brief Read a file into a document like read_document, with a context that the caller keeps
+/// between reads
+/// @param filename Name of the file
+/// @param context Context
+/// @retval Document
+/// @retval NULL if the file could not be read or is not valid JSON
+Document *read_document_with_context(const String *filename, ReadContext *context);
+
 Node *read_from_string(const String *string);
 
-#endif
\ No newline at end of file
+/// @brief Read a text into a tree of nodes like read_from_string, with a context that the caller
+/// keeps between reads
+/// @param string Text
+/// @param context Context
+/// @retval Root of the tree
+/// @retval NULL if the text is not valid JSON or a problem was encountered
+Node *read_from_string_with_context(const String *string, ReadContext *context);
+
+/// @brief Create a vector to hold the tokens of a text
+/// @retval Vector, to be freed with types_vector_free
+/// @retval NULL if a problem was encountered
+Vector *read_tokens_create(void);
+
+/// @brief Decode a CBOR (RFC 8949) item into a tree of nodes. Text keys, tags, indefinite
+/// lengths and half, single and double precision floats are accepted; byte strings and maps
+/// with other kinds of keys have no JSON equivalent and are rejected
+/// @param string Encoded bytes, which must hold exactly one item
+/// @retval Root of the tree
+/// @retval NULL if the input is not valid or cannot be represented
+Node *read_from_cbor(const String *string);
+
+/// @brief Decode a MessagePack object into a tree of nodes. Binary data and extension
+/// types have no JSON equivalent and are rejected
+/// @param string Encoded bytes, which must hold exactly one object
+/// @retval Root of the tree
+/// @retval NULL if the input is not valid or cannot be represented
+Node *read_from_msgpack(const String *string);
+
+/// @brief Read a file in the given format into a tree of nodes
+/// @param filename Name of the file
+/// @param format Format of the file
+/// @retval Root of the tree
+/// @retval NULL if the file could not be read or is not valid
+Node *read_from_file_format(const String *filename, const Format format);
+
+/// @brief Map a snapshot saved by write_snapshot into memory. Nothing is parsed or copied: the
+/// pages are loaded as the values are queried
+/// @param filename Name of the file
+/// @retval Snapshot, to be released with snapshot_close
+/// @retval NULL if the file could not be mapped or is not a valid snapshot
+Snapshot *read_snapshot(const String *filename);
+
+#endif
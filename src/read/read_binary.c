@@ -0,0 +1,420 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "read.h"
+
+/// @brief Deepest nesting of containers accepted by the binary decoders, which are recursive
+#define READ_BINARY_MAX_DEPTH 1024
+
+/// @brief Position of a binary decoder in its input
+typedef struct BinaryReader_st
+{
+    const unsigned char *data;
+    size_t length;
+    size_t position;
+    size_t depth; // Containers currently open
+} BinaryReader;
+
+static Node *read_binary_all(const String *string, Node *(*decode)(BinaryReader *));
+static bool read_binary_big_endian(BinaryReader *reader, const size_t bytes, uint64_t *value);
+static Node *read_binary_scalar(const NodeType type, void *data);
+static Node *read_binary_number(const double value);
+static Node *read_binary_string(BinaryReader *reader, const uint64_t length);
+static Node *read_binary_container(BinaryReader *reader, Node *(*decode)(BinaryReader *), const NodeType type,
+                                   const uint64_t length, const bool indefinite);
+static double read_binary_half(const uint16_t bits);
+static Node *read_cbor_item(BinaryReader *reader);
+static bool read_cbor_argument(BinaryReader *reader, const unsigned char info, uint64_t *argument);
+static Node *read_msgpack_item(BinaryReader *reader);
+
+Node *read_from_cbor(const String *string)
+{
+    return read_binary_all(string, read_cbor_item);
+}
+
+Node *read_from_msgpack(const String *string)
+{
+    return read_binary_all(string, read_msgpack_item);
+}
+
+static Node *read_binary_all(const String *string, Node *(*decode)(BinaryReader *))
+{
+    if (string == NULL || string->buffer == NULL || string->length == 0)
+    {
+        return NULL;
+    }
+    BinaryReader reader;
+    reader.data = (const unsigned char *)string->buffer;
+    reader.length = string->length;
+    reader.position = 0;
+    reader.depth = 0;
+    Node *node = decode(&reader);
+
+    // A single item must take the whole input
+    if (node != NULL && reader.position != reader.length)
+    {
+        node_destroy(node);
+        return NULL;
+    }
+    return node;
+}
+
+static bool read_binary_big_endian(BinaryReader *reader, const size_t bytes, uint64_t *value)
+{
+    if (reader->length - reader->position < bytes)
+    {
+        return false;
+    }
+    *value = 0;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        *value = (*value << 8) | reader->data[reader->position + i];
+    }
+    reader->position += bytes;
+    return true;
+}
+
+static Node *read_binary_scalar(const NodeType type, void *data)
+{
+    Node *node = node_create();
+    if (node == NULL)
+    {
+        if (type == NODE_TYPE_STRING)
+        {
+            types_string_free(data);
+        }
+        free(data);
+        return NULL;
+    }
+    node->type = type;
+    node->data = data;
+    return node;
+}
+
+static Node *read_binary_number(const double value)
+{
+    Node *node = node_create();
+    if (node == NULL || node_set_number(node, value) != CODE_OK)
+    {
+        node_destroy(node);
+        return NULL;
+    }
+    return node;
+}
+
+static Node *read_binary_string(BinaryReader *reader, const uint64_t length)
+{
+    if (length > reader->length - reader->position)
+    {
+        return NULL;
+    }
+    String *string = types_string_create_from_buffer((const char *)reader->data + reader->position, length);
+    if (string == NULL)
+    {
+        return NULL;
+    }
+    reader->position += length;
+    return read_binary_scalar(NODE_TYPE_STRING, string);
+}
+
+static Node *read_binary_container(BinaryReader *reader, Node *(*decode)(BinaryReader *), const NodeType type,
+                                   const uint64_t length, const bool indefinite)
+{
+    // Every element takes at least one byte, so longer lengths cannot be valid
+    if (reader->depth >= READ_BINARY_MAX_DEPTH || (!indefinite && length > reader->length - reader->position))
+    {
+        return NULL;
+    }
+    Node *node = node_create();
+    if (node == NULL)
+    {
+        return NULL;
+    }
+    node->type = type;
+    reader->depth += 1;
+    for (uint64_t i = 0; indefinite || i < length; i++)
+    {
+        // Indefinite containers end with a break byte
+        if (indefinite && reader->position < reader->length && reader->data[reader->position] == 0xff)
+        {
+            reader->position += 1;
+            break;
+        }
+        ResultCode result = CODE_SYNTAX_ERROR;
+        Node *key = type == NODE_TYPE_OBJECT ? decode(reader) : NULL;
+        Node *child = type == NODE_TYPE_ARRAY || key != NULL ? decode(reader) : NULL;
+        if (child != NULL && type == NODE_TYPE_ARRAY)
+        {
+            result = node_array_push(node, child);
+        }
+        else if (child != NULL && key->type == NODE_TYPE_STRING)
+        {
+            // Only text keys have a JSON equivalent
+            result = node_append(node, key->data, child);
+        }
+        node_destroy(key);
+        if (result != CODE_OK)
+        {
+            node_destroy(child);
+            node_destroy(node);
+            return NULL;
+        }
+    }
+    reader->depth -= 1;
+
+    // The tree was not read from a text, so none of it can be copied back
+    node->dirty = false;
+    return node;
+}
+
+static double read_binary_half(const uint16_t bits)
+{
+    // Half precision: 1 sign bit, 5 exponent bits and 10 fraction bits
+    const int exponent = (bits >> 10) & 0x1f;
+    const int fraction = bits & 0x3ff;
+    double value;
+    if (exponent == 0)
+    {
+        value = ldexp(fraction, -24);
+    }
+    else if (exponent == 31)
+    {
+        value = fraction == 0 ? INFINITY : NAN;
+    }
+    else
+    {
+        value = ldexp(fraction + 1024, exponent - 25);
+    }
+    return bits & 0x8000 ? -value : value;
+}
+
+static Node *read_cbor_item(BinaryReader *reader)
+{
+    // Tags only add meaning to the item that follows, which is kept as it is
+    while (reader->position < reader->length && reader->data[reader->position] >> 5 == 6)
+    {
+        uint64_t tag;
+        reader->position += 1;
+        if (!read_cbor_argument(reader, reader->data[reader->position - 1] & 0x1f, &tag))
+        {
+            return NULL;
+        }
+    }
+    if (reader->position >= reader->length)
+    {
+        return NULL;
+    }
+    const unsigned char first = reader->data[reader->position];
+    const unsigned char major = first >> 5;
+    const unsigned char info = first & 0x1f;
+    reader->position += 1;
+
+    // Simple values and floats take their argument as bits, not as a number
+    if (major == 7)
+    {
+        uint64_t bits;
+        switch (info)
+        {
+        case 20:
+            return read_binary_scalar(NODE_TYPE_FALSE, NULL);
+        case 21:
+            return read_binary_scalar(NODE_TYPE_TRUE, NULL);
+        case 22:
+        case 23:
+            // Undefined has no JSON equivalent other than null
+            return read_binary_scalar(NODE_TYPE_NULL, NULL);
+        case 25:
+            return read_binary_big_endian(reader, 2, &bits) ? read_binary_number(read_binary_half(bits)) : NULL;
+        case 26:
+        {
+            if (!read_binary_big_endian(reader, 4, &bits))
+            {
+                return NULL;
+            }
+            const uint32_t single_bits = bits;
+            float single;
+            memcpy(&single, &single_bits, sizeof(single));
+            return read_binary_number(single);
+        }
+        case 27:
+        {
+            if (!read_binary_big_endian(reader, 8, &bits))
+            {
+                return NULL;
+            }
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return read_binary_number(value);
+        }
+        }
+        return NULL;
+    }
+
+    // Indefinite lengths are allowed for text and containers only
+    uint64_t argument = 0;
+    const bool indefinite = info == 31 && (major == 3 || major == 4 || major == 5);
+    if (!indefinite && !read_cbor_argument(reader, info, &argument))
+    {
+        return NULL;
+    }
+    switch (major)
+    {
+    case 0:
+        return read_binary_number((double)argument);
+    case 1:
+        return read_binary_number(-1.0 - (double)argument);
+    case 3:
+    {
+        if (!indefinite)
+        {
+            return read_binary_string(reader, argument);
+        }
+
+        // Indefinite text is a sequence of definite chunks
+        String *string = types_string_create();
+        while (string != NULL)
+        {
+            if (reader->position < reader->length && reader->data[reader->position] == 0xff)
+            {
+                reader->position += 1;
+                return read_binary_scalar(NODE_TYPE_STRING, string);
+            }
+            Node *chunk = reader->position < reader->length && reader->data[reader->position] >> 5 == 3 &&
+                                  (reader->data[reader->position] & 0x1f) != 31
+                              ? read_cbor_item(reader)
+                              : NULL;
+            ResultCode result = chunk != NULL ? types_string_join_in_place(string, chunk->data) : CODE_SYNTAX_ERROR;
+            node_destroy(chunk);
+            if (result != CODE_OK)
+            {
+                break;
+            }
+        }
+        types_string_free(string);
+        free(string);
+        return NULL;
+    }
+    case 4:
+        return read_binary_container(reader, read_cbor_item, NODE_TYPE_ARRAY, argument, indefinite);
+    case 5:
+        return read_binary_container(reader, read_cbor_item, NODE_TYPE_OBJECT, argument, indefinite);
+    }
+
+    // Byte strings have no JSON equivalent
+    return NULL;
+}
+
+static bool read_cbor_argument(BinaryReader *reader, const unsigned char info, uint64_t *argument)
+{
+    if (info < 24)
+    {
+        *argument = info;
+        return true;
+    }
+    if (info > 27)
+    {
+        return false;
+    }
+    return read_binary_big_endian(reader, (size_t)1 << (info - 24), argument);
+}
+
+static Node *read_msgpack_item(BinaryReader *reader)
+{
+    if (reader->position >= reader->length)
+    {
+        return NULL;
+    }
+    const unsigned char first = reader->data[reader->position];
+    reader->position += 1;
+
+    // Fix types hold their value or length in the first byte
+    if (first <= 0x7f)
+    {
+        return read_binary_number(first);
+    }
+    if (first >= 0xe0)
+    {
+        return read_binary_number((int8_t)first);
+    }
+    if (first <= 0x8f)
+    {
+        return read_binary_container(reader, read_msgpack_item, NODE_TYPE_OBJECT, first & 0x0f, false);
+    }
+    if (first <= 0x9f)
+    {
+        return read_binary_container(reader, read_msgpack_item, NODE_TYPE_ARRAY, first & 0x0f, false);
+    }
+    if (first <= 0xbf)
+    {
+        return read_binary_string(reader, first & 0x1f);
+    }
+
+    uint64_t value;
+    switch (first)
+    {
+    case 0xc0:
+        return read_binary_scalar(NODE_TYPE_NULL, NULL);
+    case 0xc2:
+        return read_binary_scalar(NODE_TYPE_FALSE, NULL);
+    case 0xc3:
+        return read_binary_scalar(NODE_TYPE_TRUE, NULL);
+    case 0xca:
+    {
+        if (!read_binary_big_endian(reader, 4, &value))
+        {
+            return NULL;
+        }
+        const uint32_t single_bits = value;
+        float single;
+        memcpy(&single, &single_bits, sizeof(single));
+        return read_binary_number(single);
+    }
+    case 0xcb:
+    {
+        if (!read_binary_big_endian(reader, 8, &value))
+        {
+            return NULL;
+        }
+        double number;
+        memcpy(&number, &value, sizeof(number));
+        return read_binary_number(number);
+    }
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+        return read_binary_big_endian(reader, (size_t)1 << (first - 0xcc), &value) ? read_binary_number((double)value) : NULL;
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3:
+    {
+        // Sign-extend from the width of the value
+        const size_t bytes = (size_t)1 << (first - 0xd0);
+        if (!read_binary_big_endian(reader, bytes, &value))
+        {
+            return NULL;
+        }
+        const uint64_t sign = (uint64_t)1 << (8 * bytes - 1);
+        return read_binary_number((double)(int64_t)((value ^ sign) - sign));
+    }
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+        return read_binary_big_endian(reader, (size_t)1 << (first - 0xd9), &value) ? read_binary_string(reader, value) : NULL;
+    case 0xdc:
+    case 0xdd:
+        return read_binary_big_endian(reader, first == 0xdc ? 2 : 4, &value)
+                   ? read_binary_container(reader, read_msgpack_item, NODE_TYPE_ARRAY, value, false)
+                   : NULL;
+    case 0xde:
+    case 0xdf:
+        return read_binary_big_endian(reader, first == 0xde ? 2 : 4, &value)
+                   ? read_binary_container(reader, read_msgpack_item, NODE_TYPE_OBJECT, value, false)
+                   : NULL;
+    }
+
+    // Binary data and extension types have no JSON equivalent
+    return NULL;
+}
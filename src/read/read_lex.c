@@ -1,3 +1,5 @@
+#include <pthread.h>
+
 #include "read_lex.h"
 #include "read_sm.h"
 #include "read_sm_define.h"
@@ -22,7 +24,7 @@ typedef struct StateMachineInit_st
 } StateMachineInit;
 
 // Callbacks for each of the state machines, as well as token ids on success
-StateMachineInit state_machines_init[STATE_MACHINE_TOTAL] = {
+static const StateMachineInit state_machines_init[STATE_MACHINE_TOTAL] = {
     {STATE_MACHINE_STRING, read_sm_define_string, true, TOKEN_ID_STRING},
     {STATE_MACHINE_NUMBER, read_sm_define_number, true, TOKEN_ID_NUMBER},
     {STATE_MACHINE_TRUE, read_sm_define_true, true, TOKEN_ID_TRUE},
@@ -47,8 +49,12 @@ static const ReservedCharInit reserved_chars_init[RESERVED_CHAR_INIT_LENGTH] = {
     {']', TOKEN_ID_RIGHT_BRACKET},
 };
 
-// List of state machines. Call initialise function to initialise them
-StateMachine *state_machines[STATE_MACHINE_TOTAL];
+/// @brief Number of tokens reserved before starting to read a string
+#define READ_LEX_INITIAL_TOKENS 16
+
+// Lexer shared by the readers that are not given one, compiled once on first use
+static ReadLexer *read_lex_shared;
+static pthread_once_t read_lex_shared_once = PTHREAD_ONCE_INIT;
 
 static enum TokenId state_machine_id_to_token_id(const enum StateMachineId id)
 {
@@ -69,23 +75,58 @@ static enum TokenId state_machine_id_to_token_id(const enum StateMachineId id)
     }
 }
 
-ResultCode read_lex_initialise()
+static ResultCode read_lex_push(Vector *tokens, const Token *token)
+{
+    // The number of tokens is not known in advance, so the room for them grows geometrically
+    if (types_vector_size(tokens) == tokens->capacity &&
+        types_vector_reserve(tokens, 2 * tokens->capacity) != CODE_OK)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    return types_vector_push(tokens, token);
+}
+
+ReadLexer *read_lex_create(void)
 {
+    _Static_assert(STATE_MACHINE_TOTAL == READ_LEX_MACHINES, "every state machine needs a slot in the lexer");
+    ReadLexer *lexer = malloc(sizeof(ReadLexer));
+    if (lexer == NULL)
+    {
+        return NULL;
+    }
+
     // Create all the state machines
     for (size_t i = 0, n = STATE_MACHINE_TOTAL; i < n; i++)
     {
-        state_machines[i] = state_machines_init[i].init_callback();
-        if (state_machines[i] == NULL)
+        lexer->machines[i] = state_machines_init[i].init_callback();
+        if (lexer->machines[i] == NULL)
         {
-            return CODE_MEMORY_ERROR;
+            for (size_t j = 0; j < i; j++)
+            {
+                read_sm_free(lexer->machines[j]);
+                free(lexer->machines[j]);
+            }
+            free(lexer);
+            return NULL;
         }
     }
-    return CODE_OK;
+    return lexer;
+}
+
+static void read_lex_create_shared(void)
+{
+    read_lex_shared = read_lex_create();
 }
 
-ResultCode read_lex(const String *string, Vector *tokens)
+const ReadLexer *read_lex_default(void)
 {
-    if (string == NULL || tokens == NULL)
+    pthread_once(&read_lex_shared_once, read_lex_create_shared);
+    return read_lex_shared;
+}
+
+ResultCode read_lex(const ReadLexer *lexer, const String *string, Vector *tokens)
+{
+    if (lexer == NULL || string == NULL || tokens == NULL)
     {
         return CODE_MEMORY_ERROR;
     }
@@ -93,34 +134,37 @@ ResultCode read_lex(const String *string, Vector *tokens)
     // Clear the vector provided just in case
     types_vector_clear(tokens);
 
-    String *remaining_string = types_string_copy(string);
-    while (types_string_length(remaining_string))
+    // Walk the string once, keeping the position of the next character to consume
+    const char *buffer = types_string_c_str(string);
+    const size_t length = types_string_length(string);
+    if (types_vector_reserve(tokens, READ_LEX_INITIAL_TOKENS) != CODE_OK)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    size_t position = 0;
+    while (position < length)
     {
         // Check if this is one of the reserved characters
         bool reserved_character_success = false;
-        if (types_string_length(remaining_string) >= 1)
+        const char current_char = buffer[position];
+        for (size_t i = 0, n = RESERVED_CHAR_INIT_LENGTH; i < n; i++)
         {
-            const char current_char = types_string_at(remaining_string, 0);
-            for (size_t i = 0, n = RESERVED_CHAR_INIT_LENGTH; i < n; i++)
+            if (current_char == reserved_chars_init[i].character)
             {
-                if (current_char == reserved_chars_init[i].character)
+                // This is one of the reserved characters, so push the token
+                Token new_token;
+                new_token.id = reserved_chars_init[i].id;
+                new_token.start = position;
+                new_token.end = position + 1;
+                if (read_lex_push(tokens, &new_token) != CODE_OK)
                 {
-                    // This is one of the reserved characters
-
-                    // Push the token
-                    Token new_token;
-                    new_token.id = reserved_chars_init[i].id;
-                    types_vector_push(tokens, &new_token);
-
-                    // Consume the character
-                    String *new_string = types_string_create_from_buffer(types_string_c_str(remaining_string) + 1, types_string_length(remaining_string) - 1);
-                    types_string_free(remaining_string);
-                    free(remaining_string);
-                    remaining_string = new_string;
-
-                    // Get out of this loop
-                    break;
+                    return CODE_MEMORY_ERROR;
                 }
+
+                // Consume the character
+                position += 1;
+                reserved_character_success = true;
+                break;
             }
         }
         if (reserved_character_success)
@@ -129,49 +173,39 @@ ResultCode read_lex(const String *string, Vector *tokens)
         }
 
         // Check if this matches any of the state machines we have defined for the lexer
-        ResultCode result;
         bool success;
         size_t offset;
         bool state_machine_success = false;
         for (size_t i = 0, n = STATE_MACHINE_TOTAL; i < n; i++)
         {
-            result = read_sm_execute(state_machines[i], remaining_string, &success, &offset);
-            if (result != CODE_OK)
+            if (read_sm_execute(lexer->machines[i], buffer + position, length - position, &success, &offset) != CODE_OK)
             {
                 return CODE_MEMORY_ERROR;
             }
-            else if (success)
+            if (!success)
+            {
+                continue;
+            }
+            state_machine_success = true;
+
+            // If a token is specified, we need to include it in the token of vectors
+            if (state_machines_init[i].add_token)
             {
-                state_machine_success = true;
+                Token new_token;
+                new_token.id = state_machine_id_to_token_id(state_machines_init[i].id);
+                new_token.start = position;
+                new_token.end = position + offset;
 
-                // If a token is specified, we need to include it in the token of vectors
-                if (state_machines_init[i].add_token)
+                // Add the token to the list
+                if (read_lex_push(tokens, &new_token) != CODE_OK)
                 {
-                    Token new_token;
-                    new_token.id = state_machine_id_to_token_id(state_machines_init[i].id);
-                    // If a string or a number, I still need to fill in the data.
-                    if (new_token.id == TOKEN_ID_STRING || new_token.id == TOKEN_ID_NUMBER)
-                    {
-                        new_token.data = types_string_create_from_buffer(types_string_c_str(remaining_string) + 1, offset - 1);
-                        if (new_token.data == NULL)
-                        {
-                            return CODE_MEMORY_ERROR;
-                        }
-                    }
-
-                    // Add the token to the list
-                    types_vector_push(tokens, &new_token);
+                    return CODE_MEMORY_ERROR;
                 }
-
-                // The state machine has been successful, so we need to consume the string
-                String *new_string = types_string_create_from_buffer(remaining_string->buffer + offset, types_string_length(remaining_string) - offset);
-                types_string_free(remaining_string);
-                free(remaining_string);
-                remaining_string = new_string;
-
-                // Get out of this loop
-                break;
             }
+
+            // The state machine has been successful, so we need to consume the string
+            position += offset;
+            break;
         }
         if (state_machine_success)
         {
@@ -186,15 +220,33 @@ ResultCode read_lex(const String *string, Vector *tokens)
     return CODE_OK;
 }
 
+ResultCode read_lex_free(ReadLexer *lexer)
+{
+    if (lexer == NULL)
+    {
+        return CODE_OK;
+    }
+    ResultCode result = CODE_OK;
+    for (size_t i = 0, n = STATE_MACHINE_TOTAL; i < n; i++)
+    {
+        if (read_sm_free(lexer->machines[i]) != CODE_OK)
+        {
+            result = CODE_MEMORY_ERROR;
+        }
+        free(lexer->machines[i]);
+    }
+    free(lexer);
+    return result;
+}
+
 ResultCode read_lex_free_token(void *token_raw)
 {
     if (token_raw == NULL)
     {
         return CODE_MEMORY_ERROR;
     }
+    // Tokens own no memory, since their text stays in the string that was read
     Token *token = (Token *)token_raw;
     token->id = 0;
-    free(token->data);
-    token->data = NULL;
     return CODE_OK;
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 #include "utils.h"
 #include "types/types_string.h"
 #include "types/types_vector.h"
+#include "read_sm.h"
 
 enum TokenId
 {
@@ -21,15 +22,47 @@ enum TokenId
     TOKEN_ID_TOTAL
 };
 
+/// @brief Token found by the lexer. The text of the token is not copied, the span locates
+/// it inside the text that was read, which has to outlive the tokens
 typedef struct Token_st
 {
     enum TokenId id;
-    String *data;
+    size_t start; // Byte span [start, end) of the token in the text that was read,
+    size_t end;   // quotes included for strings
 } Token;
 
-ResultCode read_lex_initialise();
+/// @brief Number of state machines the lexer tries, one after the other, on each token
+#define READ_LEX_MACHINES 6
 
-ResultCode read_lex(const String *string, Vector *tokens);
+/// @brief Compiled state machines of the lexer. They are only read while lexing, so one lexer
+/// can be shared by any number of readers and threads
+typedef struct ReadLexer_st
+{
+    StateMachine *machines[READ_LEX_MACHINES];
+} ReadLexer;
+
+/// @brief Compile the state machines of a lexer
+/// @retval Lexer, to be freed with read_lex_free once no reader uses it
+/// @retval NULL if a problem was encountered
+ReadLexer *read_lex_create(void);
+
+/// @brief Return the lexer shared by the readers that are not given one. It is compiled on the
+/// first call, once whatever the number of threads calling, and never changes afterwards
+/// @retval Lexer, which must not be freed
+/// @retval NULL if a problem was encountered
+const ReadLexer *read_lex_default(void);
+
+/// @brief Split a text into tokens
+/// @param lexer Lexer
+/// @param string Text
+/// @param tokens Vector of Token, emptied first but keeping its memory
+/// @return Result code
+ResultCode read_lex(const ReadLexer *lexer, const String *string, Vector *tokens);
+
+/// @brief Free a lexer created by read_lex_create, including the lexer itself
+/// @param lexer Lexer
+/// @return Result code
+ResultCode read_lex_free(ReadLexer *lexer);
 
 ResultCode read_lex_free_token(void *token_raw);
 
@@ -1,25 +1,29 @@
+#include <string.h>
+
 #include "read_parse.h"
 #include "read_lex.h"
 #include "types/types_map.h"
 
 static NodeType token_id_to_node_type(const enum TokenId id);
-static Node *read_parse_value(const Iterator first, const Iterator last);
-static Node *read_parse_object(const Iterator first, const Iterator last);
-static Node *read_parse_array(const Iterator first, const Iterator last);
-static ResultCode read_parse_find_token(const Iterator first, const Iterator last,
-                                        const enum TokenId token_id, Iterator *result);
+static Node *read_parse_value(const char *text, const Iterator first, const Iterator last);
+static Node *read_parse_object(const char *text, const Iterator first, const Iterator last);
+static Node *read_parse_array(const char *text, const Iterator first, const Iterator last);
+static String *read_parse_unescape(const char *text, const Token *token);
+static size_t read_parse_hex(const char *buffer);
+static size_t read_parse_utf8(char *buffer, const size_t code_point);
+static Iterator read_parse_find_separator(const Iterator first, const Iterator last);
 static ResultCode read_parse_find_closing_token(const Iterator first, const Iterator last,
                                                 const enum TokenId opening_token_id, const enum TokenId closing_token_id, Iterator *result);
 
-Node *read_parse(const Vector *tokens)
+Node *read_parse(const String *string, const Vector *tokens)
 {
-    if (tokens == NULL)
+    if (string == NULL || tokens == NULL)
     {
         return NULL;
     }
 
     // A JSON string is a value
-    return read_parse_value(types_vector_begin(tokens), types_vector_end(tokens));
+    return read_parse_value(types_string_c_str(string), types_vector_begin(tokens), types_vector_end(tokens));
 }
 
 static NodeType token_id_to_node_type(const enum TokenId id)
@@ -41,7 +45,7 @@ static NodeType token_id_to_node_type(const enum TokenId id)
     }
 }
 
-static Node *read_parse_value(const Iterator first, const Iterator last)
+static Node *read_parse_value(const char *text, const Iterator first, const Iterator last)
 {
     size_t number;
     if (types_iterator_distance(first, last, &number) != CODE_OK)
@@ -55,320 +59,401 @@ static Node *read_parse_value(const Iterator first, const Iterator last)
 
     // Decide according to the token we have
     Token *token = (Token *)types_iterator_get(first);
+    Node *node = NULL;
     switch (token->id)
     {
     case TOKEN_ID_STRING:
-    case TOKEN_ID_NUMBER:
     {
-        // Check this node has some data
-        if (token->data == NULL)
+        // Check this is the only value provided
+        if (number != 1)
+        {
+            return NULL;
+        }
+
+        // Create the node to return, with the escape sequences already decoded
+        String *value = read_parse_unescape(text, token);
+        if (value == NULL)
+        {
+            return NULL;
+        }
+        node = node_create();
+        if (node == NULL)
         {
+            types_string_free(value);
+            free(value);
             return NULL;
         }
+        node->type = token_id_to_node_type(token->id);
+        node->data = value;
+        break;
+    }
+    case TOKEN_ID_NUMBER:
+    {
         // Check this is the only value provided
         if (number != 1)
         {
             return NULL;
         }
 
-        // Create the node to return and copy the data
-        Node *node = malloc(sizeof(node));
-        if (node == NULL)
+        // Numbers are stored in binary form. The lexer has taken the longest number possible,
+        // so strtod stops at the end of the token
+        node = node_create();
+        if (node == NULL || node_set_number(node, strtod(text + token->start, NULL)) != CODE_OK)
         {
+            node_destroy(node);
             return NULL;
         }
-        node->type = token_id_to_node_type(token->id);
-        node->data = types_string_copy(token->data);
-        return node;
+        break;
     }
     case TOKEN_ID_TRUE:
     case TOKEN_ID_FALSE:
     case TOKEN_ID_NULL:
     {
+        // Check this is the only value provided
+        if (number != 1)
+        {
+            return NULL;
+        }
+
         // Create the node to return and copy the data
-        Node *node = malloc(sizeof(node));
+        node = node_create();
         if (node == NULL)
         {
             return NULL;
         }
         node->type = token_id_to_node_type(token->id);
         node->data = NULL;
-        return node;
+        break;
     }
     case TOKEN_ID_LEFT_BRACE:
+    case TOKEN_ID_LEFT_BRACKET:
     {
-        // Find the matching right brace
+        const bool object = token->id == TOKEN_ID_LEFT_BRACE;
+
+        // Find the matching closing token
         Iterator result;
-        if (read_parse_find_closing_token(types_iterator_increase(first, 1), last, TOKEN_ID_LEFT_BRACE, TOKEN_ID_RIGHT_BRACE, &result) != CODE_OK)
+        if (read_parse_find_closing_token(types_iterator_increase(first, 1), last,
+                                          object ? TOKEN_ID_LEFT_BRACE : TOKEN_ID_LEFT_BRACKET,
+                                          object ? TOKEN_ID_RIGHT_BRACE : TOKEN_ID_RIGHT_BRACKET,
+                                          &result) != CODE_OK)
         {
             return NULL;
         }
 
-        // Check that the matching right brace is exactly at the end of the provided range
-        if (types_iterator_get(result) != types_iterator_get(last))
+        // Check that the matching closing token is exactly at the end of the provided range
+        if (!types_iterator_equal(types_iterator_increase(result, 1), last))
         {
             return NULL;
         }
 
-        // Ignore the opening and closing tokens and parse the object
+        // Ignore the opening and closing tokens and parse the contents
         Iterator inner_first = types_iterator_increase(first, 1);
-        Iterator inner_last = types_iterator_decrease(last, 1);
-        return read_parse_object(inner_first, inner_last);
-    }
-    case TOKEN_ID_LEFT_BRACKET:
-    {
-        // Find the matching right bracket
-        Iterator result;
-        if (read_parse_find_closing_token(types_iterator_increase(first, 1), last, TOKEN_ID_LEFT_BRACKET, TOKEN_ID_RIGHT_BRACKET, &result) != CODE_OK)
-        {
-            return NULL;
-        }
-
-        // Check that the matching right bracket is exactly at the end of the provided range
-        if (types_iterator_get(result) != types_iterator_get(last))
+        node = object ? read_parse_object(text, inner_first, result) : read_parse_array(text, inner_first, result);
+        if (node == NULL)
         {
             return NULL;
         }
+        token = (Token *)types_iterator_get(result);
+        node->source_start = ((Token *)types_iterator_get(first))->start;
+        node->source_end = token->end;
 
-        // Ignore the opening and closing tokens and parse the object
-        Iterator inner_first = types_iterator_increase(first, 1);
-        Iterator inner_last = types_iterator_decrease(last, 1);
-        return read_parse_array(inner_first, inner_last);
+        // Appending the children has marked the node as modified, but it is exactly as read
+        node->dirty = false;
+        return node;
     }
     default:
         return NULL;
     }
+
+    // Scalars span a single token
+    node->source_start = token->start;
+    node->source_end = token->end;
+    return node;
 }
 
-static Node *read_parse_object(const Iterator first, const Iterator last)
+static Node *read_parse_object(const char *text, const Iterator first, const Iterator last)
 {
     // Create the node
-    // TODO
     Node *node = node_create();
-    node->type = NODE_TYPE_OBJECT;
-
-    size_t distance;
-    if (types_iterator_distance(first, last, &distance) != CODE_OK)
+    if (node == NULL)
     {
         return NULL;
     }
+    node->type = NODE_TYPE_OBJECT;
 
     // An object node could be empty
-    if (distance == 1)
-    {
-        return node;
-    }
-
     Iterator current = first;
-    Token *token;
-    while (distance > 1)
+    while (!types_iterator_equal(current, last))
     {
         // This token has to be a string
-        token = (Token *)types_iterator_get(current);
+        Token *token = (Token *)types_iterator_get(current);
         if (token->id != TOKEN_ID_STRING)
         {
-            node_free(node);
-            free(node);
+            node_destroy(node);
             return NULL;
         }
-
-        // Create the key, which is a string
-        String *key = types_string_copy((String *)token->data);
+        Iterator key_iterator = current;
 
         // Next token has to be a colon
         current = types_iterator_increase(current, 1);
-        token = (Token *)types_iterator_get(current);
-        if (token->id != TOKEN_ID_COLON)
-        {
-            node_free(node);
-            free(node);
-            return NULL;
-        }
-
-        // Find a comma if there is any
-        Iterator comma_iterator;
-        if (read_parse_find_token(first, last, TOKEN_ID_COMMA, &comma_iterator) != CODE_OK)
+        if (types_iterator_equal(current, last) || ((Token *)types_iterator_get(current))->id != TOKEN_ID_COLON)
         {
-            node_free(node);
-            free(node);
+            node_destroy(node);
             return NULL;
         }
 
-        // The end of the current value is the comma or the complete end, whichever comes first
-        Iterator value_last;
-        if (types_iterator_get(comma_iterator) < types_iterator_get(last))
-        {
-            value_last = comma_iterator;
-        }
-        else
-        {
-            value_last = last;
-        }
-
-        // Advance the start of the value as well
+        // The value ends at the next comma of this object, or at the end
         current = types_iterator_increase(current, 1);
+        Iterator value_last = read_parse_find_separator(current, last);
 
-        // Check there is at least something to work with inside the value
-        size_t value_distance;
-        if (types_iterator_distance(current, value_last, &value_distance) != CODE_OK)
-        {
-            node_free(node);
-            free(node);
-            return NULL;
-        }
-        // A value cannot be empty
-        if (value_distance == 0)
-        {
-            node_free(node);
-            free(node);
-            return NULL;
-        }
-
-        // Create the value
-        Node *value = read_parse_value(current, value_last);
+        // Create the value, which cannot be empty
+        Node *value = read_parse_value(text, current, value_last);
         if (value == NULL)
         {
-            node_free(node);
-            free(node);
+            node_destroy(node);
             return NULL;
         }
 
-        // Add element to the node
-        if (node_append(node, key, value) != CODE_OK)
+        // Create the key, which is a string, and add the element to the node
+        String *key = read_parse_unescape(text, types_iterator_get(key_iterator));
+        if (key == NULL || node_append(node, key, value) != CODE_OK)
         {
-            node_free(node);
-            free(node);
+            if (key != NULL)
+            {
+                types_string_free(key);
+                free(key);
+            }
+            node_destroy(value);
+            node_destroy(node);
             return NULL;
         }
+        types_string_free(key);
+        free(key);
 
-        // Advance the iterator
+        // Skip the comma, which has to be followed by another element
         current = value_last;
-        if (types_iterator_distance(current, last, &distance) != CODE_OK)
+        if (!types_iterator_equal(current, last))
         {
-            return NULL;
+            current = types_iterator_increase(current, 1);
+            if (types_iterator_equal(current, last))
+            {
+                node_destroy(node);
+                return NULL;
+            }
         }
     }
 
     return node;
 }
 
-static Node *read_parse_array(const Iterator first, const Iterator last)
+static Node *read_parse_array(const char *text, const Iterator first, const Iterator last)
 {
     // Create the node
-    // TODO
     Node *node = node_create();
     if (node == NULL)
     {
         return NULL;
     }
     node->type = NODE_TYPE_ARRAY;
-    node->data = types_vector_create(sizeof(Node *), node_free);
-
-    size_t distance;
-    if (types_iterator_distance(first, last, &distance) != CODE_OK)
-    {
-        return NULL;
-    }
 
     // An array node could be empty
-    if (distance == 1)
-    {
-        return node;
-    }
-
     Iterator current = first;
-    while (distance > 1)
+    while (!types_iterator_equal(current, last))
     {
-        // Find a comma if there is any
-        Iterator result;
-        if (read_parse_find_token(current, last, TOKEN_ID_COMMA, &result) != CODE_OK)
+        // The value ends at the next comma of this array, or at the end
+        Iterator value_last = read_parse_find_separator(current, last);
+
+        // Create the value, which cannot be empty
+        Node *value = read_parse_value(text, current, value_last);
+        if (value == NULL)
         {
-            node_free(node);
-            free(node);
+            node_destroy(node);
             return NULL;
         }
 
-        // The end of the value is either the comma, or the end, whichever comes first
-        Iterator value_last;
-        if (types_iterator_get(result) < types_iterator_get(last))
+        // Push back to the array
+        if (node_array_push(node, value) != CODE_OK)
         {
-            value_last = result;
+            node_destroy(value);
+            node_destroy(node);
+            return NULL;
         }
-        else
+
+        // Skip the comma, which has to be followed by another element
+        current = value_last;
+        if (!types_iterator_equal(current, last))
         {
-            value_last = last;
+            current = types_iterator_increase(current, 1);
+            if (types_iterator_equal(current, last))
+            {
+                node_destroy(node);
+                return NULL;
+            }
         }
+    }
 
-        // Advance the start of the value as well
-        current = types_iterator_increase(current, 1);
+    return node;
+}
 
-        // Check there is at least something to work with inside the value
-        size_t value_distance;
-        if (types_iterator_distance(current, value_last, &value_distance) != CODE_OK)
+static String *read_parse_unescape(const char *text, const Token *token)
+{
+    // Most strings have no escape sequences at all, so the text between the quotes is copied
+    String *result = types_string_create_from_buffer(text + token->start + 1, token->end - token->start - 2);
+    if (result == NULL)
+    {
+        return NULL;
+    }
+    char *buffer = result->buffer;
+    const size_t length = types_string_length(result);
+    const char *escape = memchr(buffer, '\\', length);
+    if (escape == NULL)
+    {
+        return result;
+    }
+
+    // Decode in place: an escape sequence is never shorter than the characters it stands for.
+    // The lexer has already checked the sequences are well formed
+    size_t read = escape - buffer;
+    size_t written = read;
+    while (read < length)
+    {
+        const char c = buffer[read];
+        if (c != '\\')
         {
-            node_free(node);
-            free(node);
-            return NULL;
+            buffer[written++] = c;
+            read += 1;
+            continue;
         }
-        if (distance == 0)
+        const char kind = buffer[read + 1];
+        read += 2;
+        switch (kind)
         {
-            node_free(node);
-            free(node);
-            return NULL;
+        case 'b':
+            buffer[written++] = '\b';
+            break;
+        case 'f':
+            buffer[written++] = '\f';
+            break;
+        case 'n':
+            buffer[written++] = '\n';
+            break;
+        case 'r':
+            buffer[written++] = '\r';
+            break;
+        case 't':
+            buffer[written++] = '\t';
+            break;
+        case 'u':
+        {
+            size_t code_point = read_parse_hex(buffer + read);
+            read += 4;
+            if (code_point >= 0xD800 && code_point <= 0xDBFF && read + 6 <= length &&
+                buffer[read] == '\\' && buffer[read + 1] == 'u')
+            {
+                // High surrogate, combined with the low surrogate that follows it
+                const size_t low = read_parse_hex(buffer + read + 2);
+                if (low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    read += 6;
+                }
+            }
+            if (code_point >= 0xD800 && code_point <= 0xDFFF)
+            {
+                // A surrogate on its own is not a character, so it becomes the replacement character
+                code_point = 0xFFFD;
+            }
+            written += read_parse_utf8(buffer + written, code_point);
+            break;
+        }
+        default:
+            // Quote, reverse solidus and solidus stand for themselves
+            buffer[written++] = kind;
+            break;
         }
+    }
+    buffer[written] = '\0';
+    result->length = written;
+    return result;
+}
 
-        // Create the value
-        Node *value = read_parse_value(current, value_last);
-        if (value == NULL)
+static size_t read_parse_hex(const char *buffer)
+{
+    size_t value = 0;
+    for (size_t i = 0; i < 4; i++)
+    {
+        const char c = buffer[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9')
         {
-            node_free(node);
-            free(node);
-            return NULL;
+            value |= c - '0';
         }
-
-        // Push back to the array
-        if (node_array_push(node, value) != CODE_OK)
+        else if (c >= 'a' && c <= 'f')
         {
-            node_free(node);
-            free(node);
-            return NULL;
+            value |= c - 'a' + 10;
         }
-
-        // Advance the iterator
-        current = value_last;
-        if (types_iterator_distance(current, last, &distance) != CODE_OK)
+        else
         {
-            return NULL;
+            value |= c - 'A' + 10;
         }
     }
-
-    return node;
+    return value;
 }
 
-static ResultCode read_parse_find_token(const Iterator first, const Iterator last,
-                                        const enum TokenId token_id, Iterator *result)
+static size_t read_parse_utf8(char *buffer, const size_t code_point)
 {
-    // Check there are at least some elements to work with
-    size_t distance;
-    if (types_iterator_distance(first, last, &distance) != CODE_OK)
+    if (code_point < 0x80)
     {
-        return CODE_LOGIC_ERROR;
+        buffer[0] = code_point;
+        return 1;
+    }
+    if (code_point < 0x800)
+    {
+        buffer[0] = 0xC0 | (code_point >> 6);
+        buffer[1] = 0x80 | (code_point & 0x3F);
+        return 2;
     }
+    if (code_point < 0x10000)
+    {
+        buffer[0] = 0xE0 | (code_point >> 12);
+        buffer[1] = 0x80 | ((code_point >> 6) & 0x3F);
+        buffer[2] = 0x80 | (code_point & 0x3F);
+        return 3;
+    }
+    buffer[0] = 0xF0 | (code_point >> 18);
+    buffer[1] = 0x80 | ((code_point >> 12) & 0x3F);
+    buffer[2] = 0x80 | ((code_point >> 6) & 0x3F);
+    buffer[3] = 0x80 | (code_point & 0x3F);
+    return 4;
+}
 
-    // Iterate to find
-    for (size_t i = 0; i < distance; i++)
+static Iterator read_parse_find_separator(const Iterator first, const Iterator last)
+{
+    // Find the first comma that is not inside a nested object or array
+    int depth = 0;
+    for (Iterator current = first; !types_iterator_equal(current, last); current = types_iterator_increase(current, 1))
     {
-        Iterator current = types_iterator_increase(first, i);
-        Token *token = (Token *)types_iterator_get(current);
-        if (token->id == token_id)
+        switch (((Token *)types_iterator_get(current))->id)
         {
-            *result = current;
-            return CODE_OK;
+        case TOKEN_ID_LEFT_BRACE:
+        case TOKEN_ID_LEFT_BRACKET:
+            depth += 1;
+            break;
+        case TOKEN_ID_RIGHT_BRACE:
+        case TOKEN_ID_RIGHT_BRACKET:
+            depth -= 1;
+            break;
+        case TOKEN_ID_COMMA:
+            if (depth == 0)
+            {
+                return current;
+            }
+            break;
+        default:
+            break;
         }
     }
-
-    // Closing token has not been found, this cannot be
-    return CODE_LOGIC_ERROR;
+    return last;
 }
 
 static ResultCode read_parse_find_closing_token(const Iterator first, const Iterator last,
@@ -409,4 +494,4 @@ static ResultCode read_parse_find_closing_token(const Iterator first, const Iter
 
     // Closing token has not been found, this cannot be
     return CODE_LOGIC_ERROR;
-}
\ No newline at end of file
+}
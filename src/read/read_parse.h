@@ -3,7 +3,13 @@
 
 #include "node.h"
 #include "types/types_vector.h"
+#include "types/types_string.h"
 
-Node *read_parse(const Vector *tokens);
+/// @brief Build a tree of nodes from the tokens found by the lexer
+/// @param string Text the tokens were found in
+/// @param tokens Vector of Token
+/// @retval Root of the tree
+/// @retval NULL if the tokens do not form a valid JSON value
+Node *read_parse(const String *string, const Vector *tokens);
 
 #endif
\ No newline at end of file
@@ -1,18 +1,24 @@
 #include "read_sm.h"
 
-static ResultCode read_sm_free(void *data)
+static ResultCode read_sm_free_transition(void *data)
 {
-    // The data pointed at is itself a StateMachine
+    return CODE_OK;
+}
+
+static ResultCode read_sm_free_state(void *data)
+{
+    // The data pointed at is a State, which owns its transitions
     if (data == NULL)
     {
         return CODE_MEMORY_ERROR;
     }
-    StateMachine *sm = (StateMachine *)data;
-    if (sm->states != NULL)
+    State *state = (State *)data;
+    if (state->transitions != NULL)
     {
-        types_vector_free(sm->states);
+        types_vector_free(state->transitions);
+        free(state->transitions);
+        state->transitions = NULL;
     }
-    sm->acceptance_state = 0;
     return CODE_OK;
 }
 
@@ -23,13 +29,12 @@ StateMachine *read_sm_create()
     {
         return NULL;
     }
-    sm->states = types_vector_create(sizeof(StateMachine), read_sm_free);
+    sm->states = types_vector_create(sizeof(State), read_sm_free_state);
     if (sm->states == NULL)
     {
         free(sm);
         return NULL;
     }
-    sm->acceptance_state = 0;
     return sm;
 }
 
@@ -43,7 +48,27 @@ ResultCode read_sm_add_state(StateMachine *sm, int id)
     {
         return CODE_MEMORY_ERROR;
     }
-    types_vector_push(sm->states, &id);
+
+    // States are looked up by index, so they have to be added in order
+    if (id != types_vector_size(sm->states))
+    {
+        return CODE_LOGIC_ERROR;
+    }
+
+    State state;
+    state.id = id;
+    state.accepting = false;
+    state.transitions = types_vector_create(sizeof(Transition), read_sm_free_transition);
+    if (state.transitions == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if (types_vector_push(sm->states, &state) != CODE_OK)
+    {
+        types_vector_free(state.transitions);
+        free(state.transitions);
+        return CODE_MEMORY_ERROR;
+    }
     return CODE_OK;
 }
 
@@ -59,7 +84,7 @@ ResultCode read_sm_add_tranistions(StateMachine *sm, TransitionDef *transition_d
         TransitionDef transition_def = transition_defs[i];
 
         // Check the origin and destination states have been defined
-        if (types_vector_size(sm->states) < transition_def.origin || types_vector_size(sm->states) < transition_def.destination)
+        if (types_vector_size(sm->states) <= transition_def.origin || types_vector_size(sm->states) <= transition_def.destination)
         {
             return CODE_LOGIC_ERROR;
         }
@@ -79,7 +104,10 @@ ResultCode read_sm_add_tranistions(StateMachine *sm, TransitionDef *transition_d
         transition.destination = transition_def.destination;
 
         // Push to the other transitions
-        types_vector_push(origin_state->transitions, &transition);
+        if (types_vector_push(origin_state->transitions, &transition) != CODE_OK)
+        {
+            return CODE_MEMORY_ERROR;
+        }
     }
 
     return CODE_OK;
@@ -98,29 +126,34 @@ ResultCode read_sm_define_acceptance_state(StateMachine *sm, int state)
         return CODE_LOGIC_ERROR;
     }
 
-    // Set the acceptance state
-    sm->acceptance_state = state;
+    // A state machine can have several acceptance states
+    ((State *)types_vector_at(sm->states, state))->accepting = true;
     return CODE_OK;
 }
 
-ResultCode read_sm_execute(const StateMachine *sm, const String *string, bool *success, size_t *offset)
+ResultCode read_sm_execute(const StateMachine *sm, const char *buffer, const size_t length, bool *success, size_t *offset)
 {
-    if (sm == NULL || string == NULL || success == NULL || offset == NULL)
+    if (sm == NULL || buffer == NULL || success == NULL || offset == NULL)
     {
         return CODE_MEMORY_ERROR;
     }
+    if (types_vector_size(sm->states) == 0)
+    {
+        return CODE_LOGIC_ERROR;
+    }
 
-    // Iterate over the complete string
-    State *state = types_vector_at(sm->states, 0);
-    for (size_t i = 0, n = types_string_length(string); i < n; i++)
+    // Move through the buffer for as long as some transition matches
+    const State *state = types_vector_at(sm->states, 0);
+    size_t i = 0;
+    for (; i < length; i++)
     {
         // For each of the transitions of the current state,
         // call the callback to see it matches the condition
-        Transition *transition_found = NULL;
+        const Transition *transition_found = NULL;
         for (size_t j = 0, m = types_vector_size(state->transitions); j < m; j++)
         {
-            Transition *transition = types_vector_at(state->transitions, j);
-            if (transition->callback(types_string_at(string, i)))
+            const Transition *transition = types_vector_at(state->transitions, j);
+            if (transition->callback(buffer[i]))
             {
                 // The condition matches, so break
                 transition_found = transition;
@@ -128,30 +161,30 @@ ResultCode read_sm_execute(const StateMachine *sm, const String *string, bool *s
             }
         }
 
-        // If no transition has been found (and this is not the acceptance state)
-        // then return with an error
+        // The token ends where no transition is possible
         if (!transition_found)
         {
-            *success = false;
-            *offset = i;
-            return CODE_ERROR;
-        }
-
-        // If we have found the acceptance state, return with success
-        if (transition_found->destination == sm->acceptance_state)
-        {
-            *success = true;
-            *offset = i;
-            return CODE_OK;
+            break;
         }
 
         // The transition was found, so move the state machine
-        state = types_vector_at(state->transitions, transition_found->destination);
+        state = types_vector_at(sm->states, transition_found->destination);
     }
 
-    // The string provided has been completed without finding the acceptance
-    // state, so return with an error
-    *success = false;
-    *offset = types_string_length(string);
-    return CODE_ERROR;
-}
\ No newline at end of file
+    // The characters consumed form a token only if the machine stopped in an acceptance state
+    *success = i > 0 && state->accepting;
+    *offset = i;
+    return CODE_OK;
+}
+
+ResultCode read_sm_free(StateMachine *sm)
+{
+    if (sm == NULL)
+    {
+        return CODE_OK;
+    }
+    ResultCode result = types_vector_free(sm->states);
+    free(sm->states);
+    sm->states = NULL;
+    return result;
+}
@@ -7,6 +7,7 @@
 typedef struct State_st
 {
     int id;              // identifier of the transition, should come from an enum
+    bool accepting;      // true if the state machine can stop successfully in this state
     Vector *transitions; // Vector of all the possible transitions from this state
 } State;
 
@@ -18,8 +19,7 @@ typedef struct Transition_st
 
 typedef struct StateMachine_st
 {
-    Vector *states;
-    int acceptance_state;
+    Vector *states; // Vector of State, the index in the vector is the id of the state
 } StateMachine;
 
 typedef struct TransitionDefSt
@@ -37,6 +37,16 @@ ResultCode read_sm_add_tranistions(StateMachine *sm, TransitionDef *transition_d
 
 ResultCode read_sm_define_acceptance_state(StateMachine *sm, int state);
 
-ResultCode read_sm_execute(const StateMachine *sm, const String *string, bool *success, size_t *offset);
+/// @brief Run the state machine over the start of a buffer, for as long as there is a transition
+/// for the next character
+/// @param sm State machine
+/// @param buffer Characters to consume
+/// @param length Number of characters in the buffer
+/// @param success Set to true if the state machine stopped in an acceptance state
+/// @param offset Number of characters consumed
+/// @return Result code
+ResultCode read_sm_execute(const StateMachine *sm, const char *buffer, const size_t length, bool *success, size_t *offset);
 
-#endif
\ No newline at end of file
+ResultCode read_sm_free(StateMachine *sm);
+
+#endif
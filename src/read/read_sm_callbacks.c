@@ -10,7 +10,8 @@ bool callback_quote(const char c)
 
 bool callback_code_point(const char c)
 {
-    return c != '\"' && c != '\\' && c >= 31;
+    // Bytes above 0x7F are part of UTF-8 sequences and are taken as they come
+    return c != '\"' && c != '\\' && (unsigned char)c >= 0x20;
 }
 
 bool callback_reverse_solidus(const char c)
@@ -53,6 +54,11 @@ bool callback_unicode(const char c)
     return c == 'u';
 }
 
+bool callback_hex_digit(const char c)
+{
+    return isxdigit((unsigned char)c);
+}
+
 bool callback_zero(const char c)
 {
     return c == '0';
@@ -70,12 +76,12 @@ bool callback_plus(const char c)
 
 bool callback_digit_1to9(const char c)
 {
-    return isdigit(c) && !callback_zero(c);
+    return isdigit((unsigned char)c) && !callback_zero(c);
 }
 
 bool callback_digit(const char c)
 {
-    return isdigit(c);
+    return isdigit((unsigned char)c);
 }
 
 bool callback_dot(const char c)
@@ -11,6 +11,7 @@ bool callback_line_feed(const char c);
 bool callback_carriage_return(const char c);
 bool callback_horizontal_tab(const char c);
 bool callback_unicode(const char c);
+bool callback_hex_digit(const char c);
 
 bool callback_zero(const char c);
 bool callback_minus(const char c);
@@ -78,7 +78,7 @@ enum ReadSmWhitespaceState
     SM_WHITESPACE_TOTAL
 };
 
-#define READ_SM_DEFS_STRING_NUMBER 43
+#define READ_SM_DEFS_STRING_NUMBER 47
 static TransitionDef read_sm_defs_string[READ_SM_DEFS_STRING_NUMBER] =
     {
         {SM_STRING_FIRST, callback_quote, SM_STRING_QUOTATION_MARK_START},
@@ -133,12 +133,17 @@ static TransitionDef read_sm_defs_string[READ_SM_DEFS_STRING_NUMBER] =
         {SM_STRING_HORIZONTAL_TAB, callback_code_point, SM_STRING_CODEPOINT},
         {SM_STRING_HORIZONTAL_TAB, callback_reverse_solidus, SM_STRING_REVERSE_SOLIDUS_START},
 
-        {SM_STRING_UNICODE, callback_quote, SM_STRING_QUOTATION_MARK_END},
-        {SM_STRING_UNICODE, callback_code_point, SM_STRING_CODEPOINT},
-        {SM_STRING_UNICODE, callback_reverse_solidus, SM_STRING_REVERSE_SOLIDUS_START},
+        {SM_STRING_UNICODE, callback_hex_digit, SM_STRING_HEX_CHARACTER_1},
+        {SM_STRING_HEX_CHARACTER_1, callback_hex_digit, SM_STRING_HEX_CHARACTER_2},
+        {SM_STRING_HEX_CHARACTER_2, callback_hex_digit, SM_STRING_HEX_CHARACTER_3},
+        {SM_STRING_HEX_CHARACTER_3, callback_hex_digit, SM_STRING_HEX_CHARACTER_4},
+
+        {SM_STRING_HEX_CHARACTER_4, callback_quote, SM_STRING_QUOTATION_MARK_END},
+        {SM_STRING_HEX_CHARACTER_4, callback_code_point, SM_STRING_CODEPOINT},
+        {SM_STRING_HEX_CHARACTER_4, callback_reverse_solidus, SM_STRING_REVERSE_SOLIDUS_START},
 };
 
-#define READ_SM_DEFS_NUMBER_NUMBER 20
+#define READ_SM_DEFS_NUMBER_NUMBER 21
 static TransitionDef read_sm_defs_number[READ_SM_DEFS_NUMBER_NUMBER] =
     {
         {SM_NUMBER_FIRST, callback_zero, SM_NUMBER_ZERO},
@@ -146,17 +151,18 @@ static TransitionDef read_sm_defs_number[READ_SM_DEFS_NUMBER_NUMBER] =
         {SM_NUMBER_FIRST, callback_digit_1to9, SM_NUMBER_DIGIT_1TO9},
 
         {SM_NUMBER_ZERO, callback_dot, SM_NUMBER_DOT},
-        {SM_NUMBER_ZERO, callback_e, SM_NUMBER_E},
+        {SM_NUMBER_ZERO, callback_exponent_e, SM_NUMBER_E},
 
         {SM_NUMBER_MINUS_WHOLE, callback_zero, SM_NUMBER_ZERO},
         {SM_NUMBER_MINUS_WHOLE, callback_digit_1to9, SM_NUMBER_DIGIT_1TO9},
 
         {SM_NUMBER_DIGIT_1TO9, callback_digit, SM_NUMBER_DIGIT_WHOLE},
         {SM_NUMBER_DIGIT_1TO9, callback_dot, SM_NUMBER_DOT},
-        {SM_NUMBER_DIGIT_1TO9, callback_e, SM_NUMBER_E},
+        {SM_NUMBER_DIGIT_1TO9, callback_exponent_e, SM_NUMBER_E},
 
         {SM_NUMBER_DIGIT_WHOLE, callback_digit, SM_NUMBER_DIGIT_WHOLE},
         {SM_NUMBER_DIGIT_WHOLE, callback_dot, SM_NUMBER_DOT},
+        {SM_NUMBER_DIGIT_WHOLE, callback_exponent_e, SM_NUMBER_E},
 
         {SM_NUMBER_DOT, callback_digit, SM_NUMBER_DIGIT_FRACTION},
 
@@ -0,0 +1,386 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server.h"
+
+/// @brief Bytes read from a socket at a time
+#define SERVER_READ_SIZE 65536
+
+/// @brief Events handled in each round of the loop
+#define SERVER_EVENTS 64
+
+static ResultCode server_accept(Server *server);
+static ResultCode server_read(Server *server, ServerClient *client);
+static ResultCode server_answer(Server *server, ServerClient *client);
+static ResultCode server_write(Server *server, ServerClient *client);
+static void server_close(Server *server, ServerClient *client);
+static ResultCode server_append(String *string, const char *buffer, const size_t length);
+static long server_now(void);
+static ResultCode server_free_client(void *client);
+
+Server *server_create(const char *path, ServerHandler handler, void *context)
+{
+    struct sockaddr_un address;
+    if (path == NULL || handler == NULL || strlen(path) >= sizeof(address.sun_path))
+    {
+        return NULL;
+    }
+    Server *server = malloc(sizeof(Server));
+    if (server == NULL)
+    {
+        return NULL;
+    }
+    server->path = types_string_create_from_literal(path);
+    server->clients = types_vector_create(sizeof(ServerClient *), server_free_client);
+    server->handler = handler;
+    server->timer = NULL;
+    server->context = context;
+    server->interval = 0;
+    server->stop = false;
+    server->epoll = epoll_create1(0);
+    server->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server->path == NULL || server->clients == NULL || server->epoll < 0 || server->listener < 0)
+    {
+        server_free(server);
+        return NULL;
+    }
+
+    // A socket left behind by an earlier server would make the bind fail
+    memset(&address, '\0', sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    if (bind(server->listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(server->listener, SOMAXCONN) != 0 ||
+        fcntl(server->listener, F_SETFL, fcntl(server->listener, F_GETFL) | O_NONBLOCK) != 0 ||
+        epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->listener, &event) != 0)
+    {
+        server_free(server);
+        return NULL;
+    }
+    return server;
+}
+
+ResultCode server_set_timer(Server *server, ServerTimer timer, const long interval)
+{
+    if (server == NULL || (timer != NULL && interval <= 0))
+    {
+        return CODE_LOGIC_ERROR;
+    }
+    server->timer = timer;
+    server->interval = interval;
+    return CODE_OK;
+}
+
+ResultCode server_run(Server *server)
+{
+    if (server == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    struct epoll_event events[SERVER_EVENTS];
+    long next = server_now() + server->interval;
+    server->stop = false;
+    while (!server->stop)
+    {
+        // Wait for the sockets, or until the timer is due
+        const long now = server_now();
+        const int timeout = server->timer == NULL ? -1 : (next > now ? (int)(next - now) : 0);
+        const int count = epoll_wait(server->epoll, events, SERVER_EVENTS, timeout);
+        if (count < 0 && errno != EINTR)
+        {
+            return CODE_ERROR;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            ServerClient *client = events[i].data.ptr;
+            ResultCode result = CODE_OK;
+            if (client == NULL)
+            {
+                result = server_accept(server);
+            }
+            else
+            {
+                // Each client shows up at most once in a round, so it can be closed right away
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    result = server_read(server, client);
+                }
+                if (result == CODE_OK && (events[i].events & EPOLLOUT))
+                {
+                    result = server_write(server, client);
+                }
+                if (result != CODE_OK || (client->closing && client->sent == (size_t)client->output->length))
+                {
+                    server_close(server, client);
+                    result = CODE_OK;
+                }
+            }
+            if (result != CODE_OK)
+            {
+                return result;
+            }
+        }
+        if (server->timer != NULL && server_now() >= next)
+        {
+            server->timer(server->context);
+            next = server_now() + server->interval;
+        }
+    }
+    return CODE_OK;
+}
+
+void server_stop(Server *server)
+{
+    if (server != NULL)
+    {
+        server->stop = true;
+    }
+}
+
+ResultCode server_free(Server *server)
+{
+    if (server == NULL)
+    {
+        return CODE_OK;
+    }
+    if (server->clients != NULL)
+    {
+        types_vector_free(server->clients);
+        free(server->clients);
+    }
+    if (server->listener >= 0)
+    {
+        close(server->listener);
+        if (server->path != NULL)
+        {
+            unlink(types_string_c_str(server->path));
+        }
+    }
+    if (server->epoll >= 0)
+    {
+        close(server->epoll);
+    }
+    if (server->path != NULL)
+    {
+        types_string_free(server->path);
+        free(server->path);
+    }
+    free(server);
+    return CODE_OK;
+}
+
+static ResultCode server_accept(Server *server)
+{
+    // Take every connection waiting, and turn away those beyond the limit
+    int connection;
+    while ((connection = accept(server->listener, NULL, NULL)) >= 0)
+    {
+        if (types_vector_size(server->clients) >= SERVER_MAX_CLIENTS ||
+            fcntl(connection, F_SETFL, fcntl(connection, F_GETFL) | O_NONBLOCK) != 0)
+        {
+            close(connection);
+            continue;
+        }
+        ServerClient *client = malloc(sizeof(ServerClient));
+        if (client == NULL)
+        {
+            close(connection);
+            return CODE_MEMORY_ERROR;
+        }
+        client->socket = connection;
+        client->input = types_string_create();
+        client->output = types_string_create();
+        client->sent = 0;
+        client->events = EPOLLIN;
+        client->closing = false;
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = client};
+        if (client->input == NULL || client->output == NULL || types_vector_push(server->clients, &client) != CODE_OK)
+        {
+            server_free_client(&client);
+            return CODE_MEMORY_ERROR;
+        }
+        if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, connection, &event) != 0)
+        {
+            server_close(server, client);
+        }
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED || errno == EINTR ? CODE_OK : CODE_ERROR;
+}
+
+static ResultCode server_read(Server *server, ServerClient *client)
+{
+    char buffer[SERVER_READ_SIZE];
+    while (!client->closing)
+    {
+        const ssize_t received = recv(client->socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            if (server_append(client->input, buffer, received) != CODE_OK)
+            {
+                return CODE_MEMORY_ERROR;
+            }
+
+            // The lines read so far are answered before reading more, so a request that never
+            // ends closes the client once it passes the limit. What is left in the socket
+            // wakes the server again
+            if (client->input->length > SERVER_MAX_REQUEST)
+            {
+                break;
+            }
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        // The client is gone, or will send nothing more, so it only waits for the replies
+        client->closing = true;
+    }
+    return server_answer(server, client);
+}
+
+static ResultCode server_answer(Server *server, ServerClient *client)
+{
+    // Every complete line is a request, answered in order
+    String *input = client->input;
+    size_t start = 0;
+    char *end;
+    while ((end = memchr(input->buffer + start, '\n', input->length - start)) != NULL)
+    {
+        size_t length = end - (input->buffer + start);
+        length -= length > 0 && input->buffer[start + length - 1] == '\r';
+        input->buffer[start + length] = '\0';
+        const String request = {input->buffer + start, length, length + 1};
+        String *reply = types_string_create();
+        if (reply == NULL)
+        {
+            return CODE_MEMORY_ERROR;
+        }
+        server->handler(server->context, &request, reply);
+        const ResultCode result = server_append(client->output, reply->buffer, reply->length) == CODE_OK
+                                      ? server_append(client->output, "\n", 1)
+                                      : CODE_MEMORY_ERROR;
+        types_string_free(reply);
+        free(reply);
+        if (result != CODE_OK)
+        {
+            return result;
+        }
+        start = end + 1 - input->buffer;
+    }
+
+    // What is left is the start of the next request
+    memmove(input->buffer, input->buffer + start, input->length - start);
+    input->length -= start;
+    input->buffer[input->length] = '\0';
+    if (input->length > SERVER_MAX_REQUEST)
+    {
+        static const char *too_long = "ERROR request too long\n";
+        input->length = 0;
+        client->closing = true;
+        if (server_append(client->output, too_long, strlen(too_long)) != CODE_OK)
+        {
+            return CODE_MEMORY_ERROR;
+        }
+    }
+    return server_write(server, client);
+}
+
+static ResultCode server_write(Server *server, ServerClient *client)
+{
+    String *output = client->output;
+    while (client->sent < (size_t)output->length)
+    {
+        const ssize_t sent = send(client->socket, output->buffer + client->sent, output->length - client->sent, MSG_NOSIGNAL);
+        if (sent >= 0)
+        {
+            client->sent += sent;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            return CODE_WRITE_ERROR;
+        }
+    }
+    if (client->sent == (size_t)output->length)
+    {
+        output->length = 0;
+        client->sent = 0;
+    }
+
+    // Wait to read until the client is done, and to write only while there is something left
+    const unsigned events = (client->closing ? 0 : EPOLLIN) | (client->sent < (size_t)output->length ? EPOLLOUT : 0);
+    if (events != client->events)
+    {
+        struct epoll_event event = {.events = events, .data.ptr = client};
+        if (epoll_ctl(server->epoll, EPOLL_CTL_MOD, client->socket, &event) != 0)
+        {
+            return CODE_ERROR;
+        }
+        client->events = events;
+    }
+    return CODE_OK;
+}
+
+static void server_close(Server *server, ServerClient *client)
+{
+    for (size_t i = 0, n = types_vector_size(server->clients); i < n; i++)
+    {
+        if (*(ServerClient **)types_vector_at(server->clients, i) == client)
+        {
+            // Closing the socket also takes it out of epoll
+            Iterator position = types_vector_begin(server->clients);
+            position = types_iterator_increase(position, i);
+            types_vector_erase(server->clients, position, types_iterator_increase(position, 1));
+            return;
+        }
+    }
+}
+
+static ResultCode server_append(String *string, const char *buffer, const size_t length)
+{
+    const String piece = {(char *)buffer, length, length + 1};
+    return types_string_join_in_place(string, &piece);
+}
+
+static long server_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000L + now.tv_nsec / 1000000L;
+}
+
+static ResultCode server_free_client(void *client)
+{
+    ServerClient *server_client = *(ServerClient **)client;
+    close(server_client->socket);
+    if (server_client->input != NULL)
+    {
+        types_string_free(server_client->input);
+        free(server_client->input);
+    }
+    if (server_client->output != NULL)
+    {
+        types_string_free(server_client->output);
+        free(server_client->output);
+    }
+    free(server_client);
+    return CODE_OK;
+}
@@ -0,0 +1,86 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils.h"
+#include "types/types_string.h"
+#include "types/types_vector.h"
+
+/// @brief Longest request a client may send, newline excluded
+#define SERVER_MAX_REQUEST (1024 * 1024)
+
+/// @brief Greatest number of clients connected at once
+#define SERVER_MAX_CLIENTS 1024
+
+/// @brief Answer a request
+/// @param context Context given to the server
+/// @param request Request, a single line without its newline
+/// @param reply Where the reply is written, without a newline, which the server adds
+/// @return Result code. The reply is sent whatever the result
+typedef ResultCode (*ServerHandler)(void *context, const String *request, String *reply);
+
+/// @brief Run some work every interval, for example writing changes to disk
+/// @param context Context given to the server
+/// @return Result code
+typedef ResultCode (*ServerTimer)(void *context);
+
+/// @brief A client connected to the server
+typedef struct ServerClient_st
+{
+    int socket;
+    String *input;   // Bytes received and not yet answered, at most one partial request
+    String *output;  // Replies not yet sent
+    size_t sent;     // Bytes of the output already sent
+    unsigned events; // Events epoll waits for: input until the end, and output while the socket is full
+    bool closing;    // Indicates if the client is closed once the output is sent
+} ServerClient;
+
+/// @brief A server on a Unix domain socket. Requests are lines of text, and each one gets a
+/// line of reply, in order. A single thread serves all the clients through epoll, so requests
+/// are answered one at a time and the handler needs no locking
+typedef struct Server_st
+{
+    int listener;          // Listening socket
+    int epoll;             // Instance of epoll that watches all the sockets
+    String *path;          // Path of the socket in the file system
+    Vector *clients;       // Vector of ServerClient *
+    ServerHandler handler; // Answers the requests
+    ServerTimer timer;     // Runs every interval, or NULL
+    void *context;         // Context given to the handler and the timer
+    long interval;         // Milliseconds between runs of the timer
+    bool stop;             // Indicates if the loop must end
+} Server;
+
+/// @brief Create a server listening on a Unix domain socket. An old socket at the path is replaced
+/// @param path Path of the socket
+/// @param handler Answers the requests
+/// @param context Context given to the handler and the timer
+/// @retval Server
+/// @retval NULL if the socket could not be created or a problem was encountered
+Server *server_create(const char *path, ServerHandler handler, void *context);
+
+/// @brief Run a function at regular intervals while the server runs
+/// @param server Server
+/// @param timer Function to run, or NULL for none
+/// @param interval Milliseconds between runs
+/// @return Result code
+ResultCode server_set_timer(Server *server, ServerTimer timer, const long interval);
+
+/// @brief Serve the clients until server_stop is called, usually by the handler
+/// @param server Server
+/// @return Result code
+ResultCode server_run(Server *server);
+
+/// @brief Make server_run return once the replies of the current round of events are sent
+/// @param server Server
+void server_stop(Server *server);
+
+/// @brief Close all the sockets, remove the socket from the file system and free the memory
+/// used by the server, including the server itself
+/// @param server Server
+/// @return Result code
+ResultCode server_free(Server *server);
+
+#endif
@@ -0,0 +1,277 @@
+#include <string.h>
+#include <sys/mman.h>
+
+#include "snapshot.h"
+
+static const SnapshotHeader *snapshot_header(const Snapshot *snapshot);
+static bool snapshot_in_bounds(const Snapshot *snapshot, const uint64_t offset, const uint64_t count, const size_t size);
+static Node *snapshot_to_node_scalar(const Snapshot *snapshot, const SnapshotValue *value);
+static Node *snapshot_to_node_below(const Snapshot *snapshot, const SnapshotValue *value, const size_t depth);
+static bool snapshot_children_follow(const Snapshot *snapshot, const SnapshotValue *value);
+
+bool snapshot_check(const char *base, const size_t size)
+{
+    if (base == NULL || size < sizeof(SnapshotHeader))
+    {
+        return false;
+    }
+    const SnapshotHeader *header = (const SnapshotHeader *)base;
+    return memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+           header->version == SNAPSHOT_VERSION &&
+           header->byte_order == SNAPSHOT_BYTE_ORDER &&
+           header->size == size &&
+           header->root % sizeof(uint64_t) == 0 &&
+           header->root <= size && size - header->root >= sizeof(SnapshotValue) &&
+           header->strings <= size && size - header->strings >= header->strings_size;
+}
+
+const SnapshotValue *snapshot_root(const Snapshot *snapshot)
+{
+    const SnapshotHeader *header = snapshot_header(snapshot);
+    if (header == NULL)
+    {
+        return NULL;
+    }
+    return (const SnapshotValue *)(snapshot->base + header->root);
+}
+
+const char *snapshot_text(const Snapshot *snapshot, const uint64_t offset, const uint32_t length)
+{
+    // The text is followed by its NULL terminator, which must be inside the table too
+    const SnapshotHeader *header = snapshot_header(snapshot);
+    if (header == NULL || offset >= header->strings_size || header->strings_size - offset <= length)
+    {
+        return NULL;
+    }
+    return snapshot->base + header->strings + offset;
+}
+
+const SnapshotValue *snapshot_array_get(const Snapshot *snapshot, const SnapshotValue *value, const size_t index)
+{
+    if (value == NULL || value->type != NODE_TYPE_ARRAY || index >= value->length ||
+        !snapshot_in_bounds(snapshot, value->data.offset, value->length, sizeof(SnapshotValue)))
+    {
+        return NULL;
+    }
+    return (const SnapshotValue *)(snapshot->base + value->data.offset) + index;
+}
+
+const SnapshotMember *snapshot_member(const Snapshot *snapshot, const SnapshotValue *value, const size_t index)
+{
+    if (value == NULL || value->type != NODE_TYPE_OBJECT || index >= value->length ||
+        !snapshot_in_bounds(snapshot, value->data.offset, value->length, sizeof(SnapshotMember)))
+    {
+        return NULL;
+    }
+    return (const SnapshotMember *)(snapshot->base + value->data.offset) + index;
+}
+
+const SnapshotValue *snapshot_get(const Snapshot *snapshot, const SnapshotValue *value, const String *key)
+{
+    if (key == NULL || value == NULL || value->type != NODE_TYPE_OBJECT || value->length == 0 ||
+        !snapshot_in_bounds(snapshot, value->data.offset, value->length,
+                            sizeof(SnapshotMember) + sizeof(uint32_t)))
+    {
+        return NULL;
+    }
+    const SnapshotMember *members = (const SnapshotMember *)(snapshot->base + value->data.offset);
+    const uint32_t *sorted = (const uint32_t *)(members + value->length);
+
+    // Binary search over the indexes of the members sorted by key
+    size_t low = 0;
+    size_t high = value->length;
+    while (low < high)
+    {
+        const size_t middle = low + (high - low) / 2;
+        if (sorted[middle] >= value->length)
+        {
+            return NULL;
+        }
+        const SnapshotMember *member = &members[sorted[middle]];
+        const char *text = snapshot_text(snapshot, member->key, member->key_length);
+        if (text == NULL)
+        {
+            return NULL;
+        }
+        const int comparison = snapshot_compare_key(text, member->key_length,
+                                                    types_string_c_str(key), types_string_length(key));
+        if (comparison == 0)
+        {
+            return &member->value;
+        }
+        if (comparison < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+Node *snapshot_to_node(const Snapshot *snapshot, const SnapshotValue *value)
+{
+    return snapshot_to_node_below(snapshot, value, 0);
+}
+
+static Node *snapshot_to_node_below(const Snapshot *snapshot, const SnapshotValue *value, const size_t depth)
+{
+    if (value == NULL)
+    {
+        return NULL;
+    }
+    if (value->type != NODE_TYPE_ARRAY && value->type != NODE_TYPE_OBJECT)
+    {
+        return snapshot_to_node_scalar(snapshot, value);
+    }
+
+    // Offsets only ever move forward going down, so the walk ends even in a damaged snapshot
+    if (depth >= SNAPSHOT_MAX_DEPTH || (value->length > 0 && !snapshot_children_follow(snapshot, value)))
+    {
+        return NULL;
+    }
+
+    Node *node = node_create();
+    if (node == NULL)
+    {
+        return NULL;
+    }
+    node->type = value->type;
+    for (size_t i = 0; i < value->length; i++)
+    {
+        ResultCode result = CODE_MEMORY_ERROR;
+        if (value->type == NODE_TYPE_ARRAY)
+        {
+            Node *child = snapshot_to_node_below(snapshot, snapshot_array_get(snapshot, value, i), depth + 1);
+            result = child != NULL ? node_array_push(node, child) : CODE_MEMORY_ERROR;
+            if (result != CODE_OK && child != NULL)
+            {
+                node_destroy(child);
+            }
+        }
+        else
+        {
+            const SnapshotMember *member = snapshot_member(snapshot, value, i);
+            const char *text = member != NULL ? snapshot_text(snapshot, member->key, member->key_length) : NULL;
+            Node *child = text != NULL ? snapshot_to_node_below(snapshot, &member->value, depth + 1) : NULL;
+            if (child != NULL)
+            {
+                String key = {(char *)text, member->key_length, member->key_length + 1};
+                result = node_append(node, &key, child);
+                if (result != CODE_OK)
+                {
+                    node_destroy(child);
+                }
+            }
+        }
+        if (result != CODE_OK)
+        {
+            node_destroy(node);
+            return NULL;
+        }
+    }
+
+    // The tree was not read from a text, so there is nothing to copy it from when writing
+    node->dirty = false;
+    return node;
+}
+
+int snapshot_compare_key(const char *key1, const size_t length1, const char *key2, const size_t length2)
+{
+    const int comparison = memcmp(key1, key2, length1 < length2 ? length1 : length2);
+    if (comparison != 0)
+    {
+        return comparison;
+    }
+    return length1 < length2 ? -1 : (length1 > length2 ? 1 : 0);
+}
+
+ResultCode snapshot_close(Snapshot *snapshot)
+{
+    if (snapshot == NULL)
+    {
+        return CODE_OK;
+    }
+    ResultCode result = CODE_OK;
+    if (snapshot->mapped && munmap((void *)snapshot->base, snapshot->size) != 0)
+    {
+        result = CODE_ERROR;
+    }
+    free(snapshot);
+    return result;
+}
+
+static const SnapshotHeader *snapshot_header(const Snapshot *snapshot)
+{
+    if (snapshot == NULL || !snapshot_check(snapshot->base, snapshot->size))
+    {
+        return NULL;
+    }
+    return (const SnapshotHeader *)snapshot->base;
+}
+
+static bool snapshot_in_bounds(const Snapshot *snapshot, const uint64_t offset, const uint64_t count, const size_t size)
+{
+    // Blocks of values are aligned, so they can be accessed in place
+    return snapshot != NULL && offset % sizeof(uint64_t) == 0 && offset <= snapshot->size &&
+           count <= (snapshot->size - offset) / size;
+}
+
+static bool snapshot_children_follow(const Snapshot *snapshot, const SnapshotValue *value)
+{
+    // write_snapshot claims the block of children of a value only once the value has its own
+    // slot, so the block starts after the value
+    const uintptr_t position = (uintptr_t)value - (uintptr_t)snapshot->base;
+    return (uintptr_t)value >= (uintptr_t)snapshot->base && position < snapshot->size &&
+           value->data.offset >= position + sizeof(SnapshotValue);
+}
+
+static Node *snapshot_to_node_scalar(const Snapshot *snapshot, const SnapshotValue *value)
+{
+    void *data = NULL;
+    switch (value->type)
+    {
+    case NODE_TYPE_NULL:
+    case NODE_TYPE_TRUE:
+    case NODE_TYPE_FALSE:
+        break;
+    case NODE_TYPE_STRING:
+    {
+        const char *text = snapshot_text(snapshot, value->data.offset, value->length);
+        data = text != NULL ? types_string_create_from_buffer(text, value->length) : NULL;
+        if (data == NULL)
+        {
+            return NULL;
+        }
+        break;
+    }
+    case NODE_TYPE_NUMBER:
+    {
+        Node *node = node_create();
+        if (node == NULL || node_set_number(node, value->data.number) != CODE_OK)
+        {
+            node_destroy(node);
+            return NULL;
+        }
+        return node;
+    }
+    default:
+        return NULL;
+    }
+
+    Node *node = node_create();
+    if (node == NULL)
+    {
+        if (value->type == NODE_TYPE_STRING)
+        {
+            types_string_free(data);
+        }
+        free(data);
+        return NULL;
+    }
+    node->type = value->type;
+    node->data = data;
+    return node;
+}
@@ -0,0 +1,139 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "node.h"
+#include "utils.h"
+
+/// @brief First bytes of every snapshot file
+#define SNAPSHOT_MAGIC "JWSNAP\0\0"
+
+/// @brief Version of the layout described below
+#define SNAPSHOT_VERSION 1
+
+/// @brief Value written in the header to detect snapshots made on a machine with another byte order
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/// @brief Deepest nesting of arrays and objects a snapshot may hold, as for CBOR and MessagePack
+#define SNAPSHOT_MAX_DEPTH 1024
+
+/// @brief Header found at the start of a snapshot. A snapshot is a position-independent image of
+/// a tree of nodes: every reference is an offset, so the file can be mapped anywhere in memory
+/// and queried in place. Numbers are native doubles and integers use the native byte order
+typedef struct SnapshotHeader_st
+{
+    char magic[8];       // SNAPSHOT_MAGIC
+    uint32_t version;    // SNAPSHOT_VERSION
+    uint32_t byte_order; // SNAPSHOT_BYTE_ORDER as written by the machine that made the snapshot
+    uint64_t size;       // Size of the whole snapshot in bytes
+    uint64_t root;       // Offset of the root SnapshotValue from the start of the snapshot
+    uint64_t strings;    // Offset of the string table from the start of the snapshot
+    uint64_t strings_size;
+} SnapshotHeader;
+
+/// @brief A value inside a snapshot
+typedef struct SnapshotValue_st
+{
+    uint32_t type;   // NodeType
+    uint32_t length; // Bytes for strings, children for arrays and objects
+    union
+    {
+        double number;   // Numbers
+        uint64_t offset; // Strings: offset in the string table of the NULL-terminated text.
+                         // Arrays: offset from the start of the snapshot of `length` SnapshotValue.
+                         // Objects: offset from the start of the snapshot of `length` SnapshotMember
+                         // in document order, followed by `length` uint32_t indexes of the members
+                         // sorted by key
+    } data;
+} SnapshotValue;
+
+/// @brief A member of an object inside a snapshot
+typedef struct SnapshotMember_st
+{
+    uint64_t key;        // Offset in the string table of the NULL-terminated key
+    uint32_t key_length; // Bytes in the key
+    uint32_t reserved;
+    SnapshotValue value;
+} SnapshotMember;
+
+/// @brief A snapshot opened for reading, usually mapped from a file
+typedef struct Snapshot_st
+{
+    const char *base; // First byte of the snapshot
+    size_t size;      // Bytes in the snapshot
+    bool mapped;      // Set when base was mapped from a file and must be unmapped
+} Snapshot;
+
+/// @brief Check that a buffer holds a snapshot this program can read
+/// @param base First byte of the buffer
+/// @param size Bytes in the buffer
+/// @return True if the header is valid and matches the size of the buffer
+bool snapshot_check(const char *base, const size_t size);
+
+/// @brief Return the root value of a snapshot
+/// @param snapshot Snapshot
+/// @retval Root value
+/// @retval NULL if the snapshot is not valid
+const SnapshotValue *snapshot_root(const Snapshot *snapshot);
+
+/// @brief Return the text of a string value, or the key of a member, without copying it
+/// @param snapshot Snapshot
+/// @param offset Offset in the string table
+/// @param length Bytes in the text
+/// @retval NULL-terminated text inside the snapshot
+/// @retval NULL if the text is out of bounds
+const char *snapshot_text(const Snapshot *snapshot, const uint64_t offset, const uint32_t length);
+
+/// @brief Return a child of an array by position
+/// @param snapshot Snapshot
+/// @param value Array
+/// @param index Position of the child
+/// @retval Child
+/// @retval NULL if the value is not an array or the index is out of bounds
+const SnapshotValue *snapshot_array_get(const Snapshot *snapshot, const SnapshotValue *value, const size_t index);
+
+/// @brief Return a member of an object by position, in document order
+/// @param snapshot Snapshot
+/// @param value Object
+/// @param index Position of the member
+/// @retval Member
+/// @retval NULL if the value is not an object or the index is out of bounds
+const SnapshotMember *snapshot_member(const Snapshot *snapshot, const SnapshotValue *value, const size_t index);
+
+/// @brief Find the child of an object with a given key. The members are searched in place,
+/// through the sorted index stored in the snapshot
+/// @param snapshot Snapshot
+/// @param value Object
+/// @param key Key
+/// @retval Child
+/// @retval NULL if the value is not an object or has no such key
+const SnapshotValue *snapshot_get(const Snapshot *snapshot, const SnapshotValue *value, const String *key);
+
+/// @brief Compare two keys in the order used by the sorted index of an object: by their bytes,
+/// and a key goes before any longer key it is a prefix of
+/// @param key1 First key
+/// @param length1 Bytes in the first key
+/// @param key2 Second key
+/// @param length2 Bytes in the second key
+/// @return Negative, zero or positive, as memcmp
+int snapshot_compare_key(const char *key1, const size_t length1, const char *key2, const size_t length2);
+
+/// @brief Build a tree of nodes holding the same data as a snapshot value, for the commands
+/// that modify the document. The block of children of every array and object must lie after
+/// the value itself, as write_snapshot lays them out, so a damaged offset cannot lead back up
+/// the tree
+/// @param snapshot Snapshot
+/// @param value Value
+/// @retval Root of the new tree
+/// @retval NULL if the snapshot is damaged, nested deeper than SNAPSHOT_MAX_DEPTH, or a problem
+/// was encountered
+Node *snapshot_to_node(const Snapshot *snapshot, const SnapshotValue *value);
+
+/// @brief Release a snapshot returned by read_snapshot, and the snapshot itself
+/// @param snapshot Snapshot
+/// @return Result code
+ResultCode snapshot_close(Snapshot *snapshot);
+
+#endif
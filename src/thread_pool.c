@@ -0,0 +1,162 @@
+#include <stdlib.h>
+
+#include "thread_pool.h"
+
+static void *thread_pool_work(void *pool);
+static void thread_pool_take(ThreadPool *pool);
+
+ThreadPool *thread_pool_create(const size_t size)
+{
+    if (size == 0)
+    {
+        return NULL;
+    }
+    ThreadPool *pool = malloc(sizeof(ThreadPool));
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+    pool->threads = malloc(size * sizeof(pthread_t));
+    pool->size = 1;
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->tasks = 0;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->result = CODE_OK;
+    pool->stop = false;
+    if (pool->threads == NULL)
+    {
+        free(pool);
+        return NULL;
+    }
+    if (pthread_mutex_init(&pool->lock, NULL) != 0)
+    {
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->ready, NULL) != 0 || pthread_cond_init(&pool->done, NULL) != 0)
+    {
+        // The condition that was initialized, if any, owns no memory worth the trouble
+        pthread_mutex_destroy(&pool->lock);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+
+    // The size only counts the threads that really started
+    while (pool->size < size)
+    {
+        if (pthread_create(&pool->threads[pool->size - 1], NULL, thread_pool_work, pool) != 0)
+        {
+            thread_pool_free(pool);
+            return NULL;
+        }
+        pool->size += 1;
+    }
+    return pool;
+}
+
+ResultCode thread_pool_run(ThreadPool *pool, const size_t tasks, ThreadPoolTask task, void *context)
+{
+    if (task == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if (pool == NULL || pool->size == 1 || tasks < 2)
+    {
+        // Nothing to share
+        ResultCode result = CODE_OK;
+        for (size_t i = 0; i < tasks; i++)
+        {
+            const ResultCode task_result = task(context, i);
+            result = result == CODE_OK ? task_result : result;
+        }
+        return result;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->tasks = tasks;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->result = CODE_OK;
+    pthread_cond_broadcast(&pool->ready);
+
+    // This thread takes tasks too, and then waits for those taken by the others
+    thread_pool_take(pool);
+    while (pool->finished < pool->tasks)
+    {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    const ResultCode result = pool->result;
+    pool->tasks = 0;
+    pool->next = 0;
+    pthread_mutex_unlock(&pool->lock);
+    return result;
+}
+
+size_t thread_pool_size(const ThreadPool *pool)
+{
+    return pool != NULL ? pool->size : 1;
+}
+
+ResultCode thread_pool_free(ThreadPool *pool)
+{
+    if (pool == NULL)
+    {
+        return CODE_OK;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i + 1 < pool->size; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->ready);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+    return CODE_OK;
+}
+
+static void *thread_pool_work(void *pool)
+{
+    ThreadPool *thread_pool = pool;
+    pthread_mutex_lock(&thread_pool->lock);
+    while (!thread_pool->stop)
+    {
+        if (thread_pool->next < thread_pool->tasks)
+        {
+            thread_pool_take(thread_pool);
+        }
+        else
+        {
+            pthread_cond_wait(&thread_pool->ready, &thread_pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&thread_pool->lock);
+    return NULL;
+}
+
+static void thread_pool_take(ThreadPool *pool)
+{
+    // Called with the lock held, which is let go while each task runs
+    while (pool->next < pool->tasks)
+    {
+        const size_t index = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        const ResultCode result = pool->task(pool->context, index);
+        pthread_mutex_lock(&pool->lock);
+        pool->result = pool->result == CODE_OK ? result : pool->result;
+        pool->finished += 1;
+        if (pool->finished == pool->tasks)
+        {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "utils.h"
+
+/// @brief Task run by a pool, once for each index of a run
+typedef ResultCode (*ThreadPoolTask)(void *context, const size_t index);
+
+/// @brief Threads that wait to run the tasks of one run at a time. The thread that starts a
+/// run takes tasks as well, so a pool of n threads starts n - 1 of them
+typedef struct ThreadPool_st
+{
+    pthread_t *threads;     // Threads started by the pool
+    size_t size;            // Number of threads that run tasks, counting the one that starts a run
+    pthread_mutex_t lock;   // Protects everything below
+    pthread_cond_t ready;   // Signaled when a run starts or the pool stops
+    pthread_cond_t done;    // Signaled when the last task of a run finishes
+    ThreadPoolTask task;    // Task of the current run
+    void *context;          // Context given to the task
+    size_t tasks;           // Number of tasks of the current run
+    size_t next;            // Next task to be taken
+    size_t finished;        // Number of tasks finished
+    ResultCode result;      // First failure of the current run
+    bool stop;              // Indicates if the threads must exit
+} ThreadPool;
+
+/// @brief Start the threads of a pool
+/// @param size Number of threads that run tasks, counting the one that starts each run
+/// @retval Pool
+/// @retval NULL if a problem was encountered
+ThreadPool *thread_pool_create(const size_t size);
+
+/// @brief Run a task for every index from 0 to tasks - 1 on the threads of a pool, and wait
+/// until all of them finish. Tasks are taken in order but may finish in any order, so each one
+/// must write only to its own part of the context. Only one run at a time is allowed, and a
+/// task must not start another run on the same pool
+/// @param pool Pool, or NULL to run the tasks one after the other in this thread
+/// @param tasks Number of tasks
+/// @param task Task
+/// @param context Context given to the task
+/// @return Result code, CODE_OK if every task succeeded or one of the codes of those that failed
+ResultCode thread_pool_run(ThreadPool *pool, const size_t tasks, ThreadPoolTask task, void *context);
+
+/// @brief Number of threads that run the tasks of a pool
+/// @param pool Pool, or NULL
+/// @return Number of threads, 1 without a pool
+size_t thread_pool_size(const ThreadPool *pool);
+
+/// @brief Stop the threads of a pool and free the memory it uses, including the pool itself
+/// @param pool Pool
+/// @return Result code
+ResultCode thread_pool_free(ThreadPool *pool);
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "trace.h"
+
+/// @brief Everything recorded, shared by all the threads
+typedef struct Trace_st
+{
+    atomic_bool enabled;
+    uint64_t origin;                        // Time tracing was enabled
+    pthread_mutex_t lock;                   // Protects everything below
+    TraceTotals totals[TRACE_PHASE_TOTAL];  // Totals of each phase
+    TraceEvent *events;                     // Runs of the phases, in the order they ended
+    size_t size;                            // Number of events
+    unsigned threads;                       // Threads that recorded an event
+} Trace;
+
+static Trace trace = {false, 0, PTHREAD_MUTEX_INITIALIZER, {{0}}, NULL, 0, 0};
+
+/// @brief Number of the current thread in the trace, or zero until it records an event
+static _Thread_local unsigned trace_thread;
+
+static const char *const trace_names[TRACE_PHASE_TOTAL] = {"command", "read", "lex", "parse", "traverse", "execute", "write"};
+
+static uint64_t trace_now(void);
+
+ResultCode trace_enable(void)
+{
+    pthread_mutex_lock(&trace.lock);
+    if (trace.events == NULL)
+    {
+        trace.events = malloc(TRACE_MAX_EVENTS * sizeof(TraceEvent));
+    }
+    trace.origin = trace_now();
+    pthread_mutex_unlock(&trace.lock);
+    if (trace.events == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    atomic_store(&trace.enabled, true);
+    return CODE_OK;
+}
+
+bool trace_enabled(void)
+{
+    return atomic_load_explicit(&trace.enabled, memory_order_relaxed);
+}
+
+uint64_t trace_begin(void)
+{
+    return trace_enabled() ? trace_now() : 0;
+}
+
+void trace_end(const TracePhase phase, const uint64_t start, const size_t items, const size_t bytes)
+{
+    if (start == 0 || !trace_enabled() || phase >= TRACE_PHASE_TOTAL)
+    {
+        return;
+    }
+    const uint64_t end = trace_now();
+    pthread_mutex_lock(&trace.lock);
+    if (trace_thread == 0)
+    {
+        trace_thread = ++trace.threads;
+    }
+    TraceTotals *totals = &trace.totals[phase];
+    totals->count += 1;
+    totals->nanoseconds += end - start;
+    totals->items += items;
+    totals->bytes += bytes;
+    if (trace.size < TRACE_MAX_EVENTS)
+    {
+        trace.events[trace.size++] = (TraceEvent){phase, start - trace.origin, end - start, items, bytes, trace_thread};
+    }
+    pthread_mutex_unlock(&trace.lock);
+}
+
+TraceTotals trace_get(const TracePhase phase)
+{
+    TraceTotals totals = {0};
+    if (phase < TRACE_PHASE_TOTAL)
+    {
+        pthread_mutex_lock(&trace.lock);
+        totals = trace.totals[phase];
+        pthread_mutex_unlock(&trace.lock);
+    }
+    return totals;
+}
+
+ResultCode trace_write(FILE *file)
+{
+    if (file == NULL)
+    {
+        return CODE_WRITE_ERROR;
+    }
+    pthread_mutex_lock(&trace.lock);
+    fprintf(file, "{\"phases\":{");
+    for (size_t i = 0; i < TRACE_PHASE_TOTAL; i++)
+    {
+        const TraceTotals *totals = &trace.totals[i];
+        fprintf(file, "%s\"%s\":{\"count\":%zu,\"ns\":%llu,\"items\":%zu,\"bytes\":%zu}", i == 0 ? "" : ",",
+                trace_names[i], totals->count, (unsigned long long)totals->nanoseconds, totals->items, totals->bytes);
+    }
+
+    // Complete events, with times in microseconds as the format requires
+    fprintf(file, "},\"traceEvents\":[");
+    for (size_t i = 0; i < trace.size; i++)
+    {
+        const TraceEvent *event = &trace.events[i];
+        fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                      "\"args\":{\"items\":%zu,\"bytes\":%zu}}",
+                i == 0 ? "" : ",", trace_names[event->phase], event->thread, event->start / 1e3,
+                event->nanoseconds / 1e3, event->items, event->bytes);
+    }
+    fprintf(file, "],\"displayTimeUnit\":\"ns\"}\n");
+    pthread_mutex_unlock(&trace.lock);
+    return ferror(file) ? CODE_WRITE_ERROR : CODE_OK;
+}
+
+void trace_reset(void)
+{
+    atomic_store(&trace.enabled, false);
+    pthread_mutex_lock(&trace.lock);
+    free(trace.events);
+    trace.events = NULL;
+    trace.size = 0;
+    trace.threads = 0;
+    for (size_t i = 0; i < TRACE_PHASE_TOTAL; i++)
+    {
+        trace.totals[i] = (TraceTotals){0};
+    }
+    pthread_mutex_unlock(&trace.lock);
+}
+
+static uint64_t trace_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
@@ -0,0 +1,81 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "utils.h"
+
+/// @brief Most events kept for the timeline. Past it, the events still add to the totals
+#define TRACE_MAX_EVENTS 100000
+
+/// @brief Phases of the work of the program that are timed
+typedef enum TracePhase_e
+{
+    TRACE_PHASE_COMMAND,  // Parsing the command
+    TRACE_PHASE_READ,     // Reading a file into memory
+    TRACE_PHASE_LEX,      // Splitting the text into tokens
+    TRACE_PHASE_PARSE,    // Building the tree from the tokens
+    TRACE_PHASE_TRAVERSE, // Finding the nodes selected by a path
+    TRACE_PHASE_EXECUTE,  // Changing the nodes found, finding them included
+    TRACE_PHASE_WRITE,    // Writing the document
+    TRACE_PHASE_TOTAL
+} TracePhase;
+
+/// @brief Totals of a phase over all the times it ran
+typedef struct TraceTotals_st
+{
+    size_t count;         // Times the phase ran
+    uint64_t nanoseconds; // Time taken by all of them
+    size_t items;         // Tokens for the lexer, nodes for the parser and for paths, or zero
+    size_t bytes;         // Bytes processed
+} TraceTotals;
+
+/// @brief A single run of a phase, for the timeline
+typedef struct TraceEvent_st
+{
+    TracePhase phase;
+    uint64_t start;       // Nanoseconds since tracing was enabled
+    uint64_t nanoseconds; // Time taken
+    size_t items;
+    size_t bytes;
+    unsigned thread; // Number of the thread, in the order the threads first recorded an event
+} TraceEvent;
+
+/// @brief Start recording the phases. Until this is called, timing a phase costs a single test
+/// @return Result code
+ResultCode trace_enable(void);
+
+/// @brief Tell if the phases are being recorded, so costly counts are only made for a trace
+/// @return True if the phases are being recorded
+bool trace_enabled(void);
+
+/// @brief Start timing a phase
+/// @return Time to give to trace_end, or zero if the phases are not being recorded
+uint64_t trace_begin(void);
+
+/// @brief Record a run of a phase. May be called from any thread
+/// @param phase Phase
+/// @param start Time returned by trace_begin when the phase started
+/// @param items Tokens or nodes processed, or zero
+/// @param bytes Bytes processed, or zero
+void trace_end(const TracePhase phase, const uint64_t start, const size_t items, const size_t bytes);
+
+/// @brief Return the totals of a phase
+/// @param phase Phase
+/// @return Totals of the phase
+TraceTotals trace_get(const TracePhase phase);
+
+/// @brief Write the recorded phases as a JSON object, with the totals of each phase under
+/// "phases", and every run under "traceEvents" in the Chrome trace event format, so the same
+/// file can be loaded in chrome://tracing or Perfetto
+/// @param file File to write to
+/// @return Result code
+ResultCode trace_write(FILE *file);
+
+/// @brief Stop recording, and forget everything recorded
+void trace_reset(void);
+
+#endif
@@ -34,7 +34,8 @@ Map *types_map_create(const size_t key_size, const size_t value_size,
                       ResultCode (*value_free_callback)(void *key1),
                       bool (*key_compare_callback)(const void *, const void *),
                       void *(*key_copy_callback)(const void *),
-                      void *(*value_copy_callback)(const void *))
+                      void *(*value_copy_callback)(const void *),
+                      size_t (*key_hash_callback)(const void *))
 {
     Map *map = malloc(sizeof(Map));
     if (map == NULL)
@@ -48,6 +49,7 @@ Map *types_map_create(const size_t key_size, const size_t value_size,
     map->key_compare_callback = key_compare_callback;
     map->key_copy_callback = key_copy_callback;
     map->value_copy_callback = value_copy_callback;
+    map->key_hash_callback = key_hash_callback;
     // Create the closure of the map, that stores the two callbacks needed to free
     // the key and the value respectively
     map->closure.key_free_callback = key_free_callback;
@@ -85,15 +87,26 @@ Iterator types_map_find(const Map *map, const void *key)
         return types_iterator_invalid();
     }
 
-    // Iterate over the values of the internal vector
+    return types_map_find_hashed(map, key, map->key_hash_callback != NULL ? map->key_hash_callback(key) : 0);
+}
+
+Iterator types_map_find_hashed(const Map *map, const void *key, const size_t hash)
+{
+    if (map == NULL || key == NULL)
+    {
+        return types_iterator_invalid();
+    }
+
+    // Iterate over the values of the internal vector. Without a hash callback every hash is 0
     Pair *pair;
     Vector *elements = map->elements;
+    const size_t expected = map->key_hash_callback != NULL ? hash : 0;
     for (size_t i = 0, n = types_vector_size(elements); i < n; i++)
     {
         // Access the current pair
         pair = types_vector_at(elements, i);
         // Check if this key is the same as the one provided
-        if (map->key_compare_callback(pair->key, key) == 0)
+        if (pair->hash == expected && map->key_compare_callback(pair->key, key) == 0)
         {
             return types_iterator_create(pair, sizeof(pair));
         }
@@ -163,6 +176,7 @@ Iterator types_map_insert(Map *map, const void *key, const void *value)
     Pair pair;
     pair.key = map->key_copy_callback(key);
     pair.value = map->value_copy_callback(value);
+    pair.hash = map->key_hash_callback != NULL ? map->key_hash_callback(key) : 0;
     // Copy the callbacks in the closure
     pair.closure.key_free_callback = map->closure.key_free_callback;
     pair.closure.value_free_callback = map->closure.value_free_callback;
@@ -186,6 +200,33 @@ ResultCode types_map_erase(Map *map, Iterator first, Iterator last)
     return types_vector_erase(map->elements, first, last);
 }
 
+ResultCode types_map_rekey(Map *map, Iterator position, const void *key)
+{
+    if (map == NULL || key == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    Pair *pair = types_iterator_get(position);
+    if (pair == NULL)
+    {
+        return CODE_LOGIC_ERROR;
+    }
+
+    // Copy the new key before freeing the old one, which may be the same
+    void *new_key = map->key_copy_callback(key);
+    if (new_key == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if (pair->closure.key_free_callback != NULL)
+    {
+        pair->closure.key_free_callback(pair->key);
+    }
+    pair->key = new_key;
+    pair->hash = map->key_hash_callback != NULL ? map->key_hash_callback(key) : 0;
+    return CODE_OK;
+}
+
 ResultCode types_map_free(Map *map)
 {
     if (map == NULL)
@@ -17,6 +17,7 @@ typedef struct Pair_st
 {
     void *key;
     void *value;
+    size_t hash; // Hash of the key, or 0 if the map does not hash its keys
     struct FreeCallbacksClosure closure;
 } Pair;
 
@@ -30,6 +31,7 @@ typedef struct Map_st
     bool (*key_compare_callback)(const void *, const void *);
     void *(*key_copy_callback)(const void *);
     void *(*value_copy_callback)(const void *);
+    size_t (*key_hash_callback)(const void *); // Optional, lets lookups compare hashes before keys
 } Map;
 
 Map *types_map_create(const size_t key_size, const size_t value_size,
@@ -37,12 +39,22 @@ Map *types_map_create(const size_t key_size, const size_t value_size,
                       ResultCode (*value_free_callback)(void *key1),
                       bool (*key_compare_callback)(const void *, const void *),
                       void *(*key_copy_callback)(const void *),
-                      void *(*value_copy_callback)(const void *));
+                      void *(*value_copy_callback)(const void *),
+                      size_t (*key_hash_callback)(const void *));
 
 void *types_map_at(Map *map, const void *key);
 
 Iterator types_map_find(const Map *map, const void *key);
 
+/// @brief Find a key whose hash has already been computed, with the hash callback of the map.
+/// Only the pairs with the same hash have their keys compared
+/// @param map Map
+/// @param key Key to find
+/// @param hash Hash of the key
+/// @retval Iterator to the pair
+/// @retval Invalid iterator if the key is not in the map
+Iterator types_map_find_hashed(const Map *map, const void *key, const size_t hash);
+
 Iterator types_map_begin(const Map *map);
 
 Iterator types_map_end(const Map *map);
@@ -57,6 +69,13 @@ Iterator types_map_insert(Map *map, const void *key, const void *value);
 
 ResultCode types_map_erase(Map *map, Iterator first, Iterator last);
 
+/// @brief Replace the key of a pair with a copy of another key, keeping its position and value
+/// @param map Map
+/// @param position Iterator to the pair
+/// @param key New key
+/// @return Result code
+ResultCode types_map_rekey(Map *map, Iterator position, const void *key);
+
 ResultCode types_map_free(Map *map);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <string.h>
+#include <stdatomic.h>
+
+#include "types_memory.h"
+
+/// @brief Counters updated from any thread. They only count, so no ordering is needed
+typedef struct MemoryAtomicCounters_st
+{
+    atomic_size_t live_bytes;
+    atomic_size_t peak_bytes;
+    atomic_size_t allocations;
+    atomic_size_t frees;
+    atomic_size_t reserved_bytes;
+} MemoryAtomicCounters;
+
+// Counters for each category, plus the global ones
+static MemoryAtomicCounters counters[MEMORY_CATEGORY_TOTAL];
+static MemoryAtomicCounters total;
+
+static void types_memory_add(MemoryAtomicCounters *target, const size_t bytes)
+{
+    const size_t live = atomic_fetch_add_explicit(&target->live_bytes, bytes, memory_order_relaxed) + bytes;
+    size_t peak = atomic_load_explicit(&target->peak_bytes, memory_order_relaxed);
+    while (live > peak &&
+           !atomic_compare_exchange_weak_explicit(&target->peak_bytes, &peak, live, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+static void types_memory_subtract(MemoryAtomicCounters *target, const size_t bytes)
+{
+    // Never wrap around if some memory was given back without being recorded
+    size_t live = atomic_load_explicit(&target->live_bytes, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&target->live_bytes, &live, live - (bytes < live ? bytes : live),
+                                                  memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+static void types_memory_count(atomic_size_t *target)
+{
+    atomic_fetch_add_explicit(target, 1, memory_order_relaxed);
+}
+
+static MemoryCounters types_memory_load(MemoryAtomicCounters *source)
+{
+    MemoryCounters loaded;
+    loaded.live_bytes = atomic_load_explicit(&source->live_bytes, memory_order_relaxed);
+    loaded.peak_bytes = atomic_load_explicit(&source->peak_bytes, memory_order_relaxed);
+    loaded.allocations = atomic_load_explicit(&source->allocations, memory_order_relaxed);
+    loaded.frees = atomic_load_explicit(&source->frees, memory_order_relaxed);
+    loaded.reserved_bytes = atomic_load_explicit(&source->reserved_bytes, memory_order_relaxed);
+    return loaded;
+}
+
+static void types_memory_clear(MemoryAtomicCounters *target)
+{
+    atomic_store_explicit(&target->live_bytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&target->peak_bytes, 0, memory_order_relaxed);
+    atomic_store_explicit(&target->allocations, 0, memory_order_relaxed);
+    atomic_store_explicit(&target->frees, 0, memory_order_relaxed);
+    atomic_store_explicit(&target->reserved_bytes, 0, memory_order_relaxed);
+}
+
+void types_memory_allocate(const MemoryCategory category, const size_t bytes)
+{
+    if (category >= MEMORY_CATEGORY_TOTAL)
+    {
+        return;
+    }
+    types_memory_add(&counters[category], bytes);
+    types_memory_add(&total, bytes);
+    types_memory_count(&counters[category].allocations);
+    types_memory_count(&total.allocations);
+    atomic_fetch_add_explicit(&counters[category].reserved_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total.reserved_bytes, bytes, memory_order_relaxed);
+}
+
+void types_memory_resize(const MemoryCategory category, const size_t old_bytes, const size_t new_bytes)
+{
+    if (category >= MEMORY_CATEGORY_TOTAL)
+    {
+        return;
+    }
+    if (new_bytes >= old_bytes)
+    {
+        types_memory_add(&counters[category], new_bytes - old_bytes);
+        types_memory_add(&total, new_bytes - old_bytes);
+        atomic_fetch_add_explicit(&counters[category].reserved_bytes, new_bytes, memory_order_relaxed);
+        atomic_fetch_add_explicit(&total.reserved_bytes, new_bytes, memory_order_relaxed);
+    }
+    else
+    {
+        types_memory_subtract(&counters[category], old_bytes - new_bytes);
+        types_memory_subtract(&total, old_bytes - new_bytes);
+    }
+    types_memory_count(&counters[category].allocations);
+    types_memory_count(&total.allocations);
+}
+
+void types_memory_release(const MemoryCategory category, const size_t bytes)
+{
+    if (category >= MEMORY_CATEGORY_TOTAL)
+    {
+        return;
+    }
+    types_memory_subtract(&counters[category], bytes);
+    types_memory_subtract(&total, bytes);
+    types_memory_count(&counters[category].frees);
+    types_memory_count(&total.frees);
+}
+
+MemoryCounters types_memory_get(const MemoryCategory category)
+{
+    if (category >= MEMORY_CATEGORY_TOTAL)
+    {
+        MemoryCounters empty;
+        memset(&empty, '\0', sizeof(MemoryCounters));
+        return empty;
+    }
+    return types_memory_load(&counters[category]);
+}
+
+MemoryCounters types_memory_total(void)
+{
+    return types_memory_load(&total);
+}
+
+void types_memory_reset(void)
+{
+    for (size_t i = 0; i < MEMORY_CATEGORY_TOTAL; i++)
+    {
+        types_memory_clear(&counters[i]);
+    }
+    types_memory_clear(&total);
+}
@@ -0,0 +1,58 @@
+#ifndef TYPES_MEMORY_H
+#define TYPES_MEMORY_H
+
+#include <stddef.h>
+
+#include "utils.h"
+
+/// @brief Categories of memory tracked by the accounting layer
+typedef enum MemoryCategory_e
+{
+    MEMORY_CATEGORY_STRING, // Character buffers owned by strings
+    MEMORY_CATEGORY_VECTOR, // Element buffers owned by vectors (and therefore maps)
+    MEMORY_CATEGORY_NODE,   // Node structures
+    MEMORY_CATEGORY_TOTAL
+} MemoryCategory;
+
+/// @brief Counters kept for each of the memory categories. They are updated atomically, so
+/// memory may be recorded from any thread
+typedef struct MemoryCounters_st
+{
+    size_t live_bytes;     // Bytes currently reserved
+    size_t peak_bytes;     // Maximum value reached by live_bytes
+    size_t allocations;    // Number of calls to malloc or realloc
+    size_t frees;          // Number of calls to free
+    size_t reserved_bytes; // Bytes of all the blocks ever reserved, counting the whole block on each growth as
+                           // realloc may copy it, so containers that grow by a constant step show up quadratic
+} MemoryCounters;
+
+/// @brief Record a new block of memory
+/// @param category Category the memory belongs to
+/// @param bytes Number of bytes reserved
+void types_memory_allocate(const MemoryCategory category, const size_t bytes);
+
+/// @brief Record that an already recorded block of memory has changed its size
+/// @param category Category the memory belongs to
+/// @param old_bytes Number of bytes reserved before the change
+/// @param new_bytes Number of bytes reserved after the change
+void types_memory_resize(const MemoryCategory category, const size_t old_bytes, const size_t new_bytes);
+
+/// @brief Record that a block of memory has been given back
+/// @param category Category the memory belongs to
+/// @param bytes Number of bytes given back
+void types_memory_release(const MemoryCategory category, const size_t bytes);
+
+/// @brief Return the counters of a single category
+/// @param category Category
+/// @return Counters of the category
+MemoryCounters types_memory_get(const MemoryCategory category);
+
+/// @brief Return the counters summed over all the categories. The peak is the peak
+/// of the sum, not the sum of the peaks
+/// @return Counters of all the categories
+MemoryCounters types_memory_total(void);
+
+/// @brief Set all the counters back to zero
+void types_memory_reset(void);
+
+#endif
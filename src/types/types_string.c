@@ -1,9 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "utils.h"
 #include "types_string.h"
+#include "types_memory.h"
 
 String *types_string_create(void)
 {
@@ -19,6 +21,7 @@ String *types_string_create(void)
     {
         return NULL;
     }
+    types_memory_allocate(MEMORY_CATEGORY_STRING, 1);
     result->buffer = tmp;
     result->buffer[0] = '\0';
     result->capacity = 1;
@@ -50,6 +53,7 @@ String *types_string_create_from_literal(const char *literal)
     {
         return NULL;
     }
+    types_memory_allocate(MEMORY_CATEGORY_STRING, original_length + 1);
     result->buffer = tmp;
     memcpy(result->buffer, literal, original_length);
     result->buffer[original_length] = '\0';
@@ -81,6 +85,7 @@ String *types_string_create_from_buffer(const char *origin, const size_t size)
     {
         return NULL;
     }
+    types_memory_allocate(MEMORY_CATEGORY_STRING, size + 1);
     result->buffer = tmp;
     memcpy(result->buffer, origin, size);
     result->buffer[size] = '\0';
@@ -126,6 +131,17 @@ int types_string_compare(const String *string1, const String *string2)
     return strcmp(types_string_c_str(string1), types_string_c_str(string2));
 }
 
+size_t types_string_hash(const String *string)
+{
+    uint64_t hash = 14695981039346656037u;
+    for (size_t i = 0, n = types_string_length(string); i < n; i++)
+    {
+        hash ^= (unsigned char)string->buffer[i];
+        hash *= 1099511628211u;
+    }
+    return (size_t)hash;
+}
+
 ResultCode types_string_join_in_place(String *string1, const String *string2)
 {
     if (string1 == NULL || string2 == NULL)
@@ -139,16 +155,13 @@ ResultCode types_string_join_in_place(String *string1, const String *string2)
         return CODE_OK;
     }
 
-    // Check string 1 has enough capacity
+    // Check string 1 has enough capacity. It grows at least to twice its size, so joining
+    // many short strings copies each byte a bounded number of times
     size_t memory_needed = string1->length + string2->length + 1;
-    if (string1->capacity < memory_needed)
+    if (string1->capacity < memory_needed &&
+        types_string_reserve(string1, memory_needed > 2 * string1->capacity ? memory_needed : 2 * string1->capacity) != CODE_OK)
     {
-        void *tmp = realloc(string1->buffer, memory_needed);
-        if (tmp == NULL)
-        {
-            return CODE_MEMORY_ERROR;
-        }
-        string1->buffer = tmp;
+        return CODE_MEMORY_ERROR;
     }
 
     // Copy the second string into the first one
@@ -156,7 +169,6 @@ ResultCode types_string_join_in_place(String *string1, const String *string2)
     size_t final_length = string1->length + string2->length;
     string1->buffer[final_length] = '\0';
     string1->length = final_length;
-    string1->capacity = final_length + 1;
     return CODE_OK;
 }
 
@@ -188,6 +200,7 @@ ResultCode types_string_reserve(String *string, const size_t capacity)
     {
         return CODE_MEMORY_ERROR;
     }
+    types_memory_resize(MEMORY_CATEGORY_STRING, string->capacity, capacity);
     string->buffer = tmp;
     string->capacity = capacity;
     return CODE_OK;
@@ -202,6 +215,7 @@ ResultCode types_string_free(void *string)
     String *my_string = (String *)string;
     if (my_string->buffer != NULL)
     {
+        types_memory_release(MEMORY_CATEGORY_STRING, my_string->capacity);
         free(my_string->buffer);
     }
     my_string->buffer = NULL;
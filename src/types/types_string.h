@@ -61,6 +61,12 @@ String *types_string_copy(const String *original);
 /// @retval Same return value as strcmp
 int types_string_compare(const String *string1, const String *string2);
 
+/// @brief Compute a hash of the bytes of a string (64-bit FNV-1a), so that strings can be
+/// compared by hash before comparing their contents
+/// @param string String
+/// @return Hash of the string. Equal strings have equal hashes
+size_t types_string_hash(const String *string);
+
 /// @brief Join the second string provied to the first one
 /// @param string1 String where the final sum of the two will be stored
 /// @param string2 String to join to the first one
@@ -1,6 +1,7 @@
 #include <string.h>
 
 #include "types_vector.h"
+#include "types_memory.h"
 
 Vector *types_vector_create(const size_t element_size, ResultCode (*free_callback)(void *))
 {
@@ -47,19 +48,15 @@ ResultCode types_vector_push(Vector *vector, const void *data)
         {
             return CODE_MEMORY_ERROR;
         }
+        types_memory_allocate(MEMORY_CATEGORY_VECTOR, vector->element_size);
         vector->capacity += 1;
     }
 
-    // Check if more memory is needed
-    if (vector->size == vector->capacity)
+    // Check if more memory is needed. The capacity doubles, so pushing n elements moves
+    // at most 2n of them in total
+    if (vector->size == vector->capacity && types_vector_reserve(vector, 2 * vector->capacity) != CODE_OK)
     {
-        void *tmp = realloc(vector->data, vector->element_size * (vector->capacity + 1));
-        if (tmp == NULL)
-        {
-            return CODE_MEMORY_ERROR;
-        }
-        vector->data = tmp;
-        vector->capacity += 1;
+        return CODE_MEMORY_ERROR;
     }
 
     // Add element to the end of vector
@@ -69,6 +66,34 @@ ResultCode types_vector_push(Vector *vector, const void *data)
     return CODE_OK;
 }
 
+ResultCode types_vector_reserve(Vector *vector, const size_t capacity)
+{
+    if (vector == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if (capacity <= vector->capacity)
+    {
+        return CODE_OK;
+    }
+    void *tmp = realloc(vector->data, vector->element_size * capacity);
+    if (tmp == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if (vector->data == NULL)
+    {
+        types_memory_allocate(MEMORY_CATEGORY_VECTOR, vector->element_size * capacity);
+    }
+    else
+    {
+        types_memory_resize(MEMORY_CATEGORY_VECTOR, vector->element_size * vector->capacity, vector->element_size * capacity);
+    }
+    vector->data = tmp;
+    vector->capacity = capacity;
+    return CODE_OK;
+}
+
 ResultCode types_vector_clear(Vector *vector)
 {
     if (vector == NULL)
@@ -86,7 +111,10 @@ ResultCode types_vector_clear(Vector *vector)
     }
 
     // All the internal elements have been freed, so fill the vector with zeros but keep the memory reserved
-    memset(vector->data, '\0', vector->size * vector->element_size);
+    if (vector->data != NULL)
+    {
+        memset(vector->data, '\0', vector->size * vector->element_size);
+    }
     vector->size = 0;
     return CODE_OK;
 }
@@ -105,7 +133,11 @@ ResultCode types_vector_free(Vector *vector)
     }
 
     // Free the internal buffer
-    free(vector->data);
+    if (vector->data != NULL)
+    {
+        types_memory_release(MEMORY_CATEGORY_VECTOR, vector->capacity * vector->element_size);
+        free(vector->data);
+    }
 
     // Reset variables
     vector->data = NULL;
@@ -170,32 +202,26 @@ ResultCode types_vector_erase(Vector *vector, Iterator first, Iterator last)
     // Compute the distance between last and end, as these will be the elements to move
     Iterator end = types_vector_end(vector);
     size_t distance;
-    if (types_iterator_distance(last, end, &distance) != CODE_OK)
+    size_t erased;
+    if (types_iterator_distance(last, end, &distance) != CODE_OK ||
+        types_iterator_distance(first, last, &erased) != CODE_OK)
     {
         return CODE_LOGIC_ERROR;
     }
 
-    // Write on the first iterator the contents of the last iterator, advance, and so on
-    Iterator write_iterator = first;
-    Iterator read_iterator = last;
-    for (size_t i = 0; i < distance; i++)
+    // Free every element erased, then move the ones after them into their place
+    for (Iterator current = first; !types_iterator_equal(current, last); current = types_iterator_increase(current, 1))
     {
-        if (vector->free_callback(types_iterator_get(write_iterator)) != CODE_OK)
+        if (vector->free_callback(types_iterator_get(current)) != CODE_OK)
         {
             return CODE_MEMORY_ERROR;
         }
-        memcpy(types_iterator_get(write_iterator), types_iterator_get(read_iterator), vector->element_size);
-        memset(types_iterator_get(read_iterator), '\0', vector->element_size);
-        read_iterator = types_iterator_increase(read_iterator, 1);
-        write_iterator = types_iterator_increase(write_iterator, 1);
     }
+    memmove(types_iterator_get(first), types_iterator_get(last), distance * vector->element_size);
 
-    // Reduce the size of the vector accordingly
-    if (types_iterator_distance(first, last, &distance) != CODE_OK)
-    {
-        return CODE_LOGIC_ERROR;
-    }
-    vector->size -= distance;
+    // Reduce the size of the vector accordingly, leaving zeros where the last elements were
+    vector->size -= erased;
+    memset(types_iterator_get(types_vector_end(vector)), '\0', erased * vector->element_size);
     return CODE_OK;
 }
 
@@ -212,22 +238,29 @@ ResultCode types_vector_insert(Vector *vector, Iterator first, Iterator last, It
     {
         return CODE_MEMORY_ERROR;
     }
-    // Compute the number of elements that will be displaced
-    size_t numElementsDisplaced = 0;
-    if (types_iterator_distance(destination, types_vector_end(vector), &numElementsDisplaced) != CODE_OK)
+    // Compute the number of elements that will be displaced. The destination is kept as a
+    // position, as the buffer may move when it grows. An empty vector has no buffer yet, and
+    // the new elements go at its start
+    size_t position = 0;
+    if (vector->data != NULL && types_iterator_distance(types_vector_begin(vector), destination, &position) != CODE_OK)
     {
         return CODE_MEMORY_ERROR;
     }
+    if (position > vector->size)
+    {
+        return CODE_LOGIC_ERROR;
+    }
+    size_t numElementsDisplaced = vector->size - position;
 
-    // Reallocate the vector to accomodate the new elements
-    void *tmp = realloc(vector->data, (vector->capacity + num_elements_added) * vector->element_size);
-    if (tmp == NULL)
+    // Reallocate the vector to accomodate the new elements, only if they do not fit. As when
+    // pushing, the capacity at least doubles, so inserting at the end stays linear overall
+    size_t capacity = vector->size + num_elements_added;
+    if (capacity > vector->capacity && types_vector_reserve(vector, capacity > 2 * vector->capacity ? capacity : 2 * vector->capacity) != CODE_OK)
     {
         return CODE_MEMORY_ERROR;
     }
-    vector->data = tmp;
     vector->size += num_elements_added;
-    vector->capacity += num_elements_added;
+    destination = types_iterator_increase(types_vector_begin(vector), position);
 
     // Move all the elements between destination and end, to the end of the vector
     // The last element is moved first to prevent overwrites. Then the iterator progresses down
@@ -34,6 +34,13 @@ size_t types_vector_size(const Vector *vector);
 /// @return Result code
 ResultCode types_vector_push(Vector *vector, const void *data);
 
+/// @brief Reserve, ahead of time, room for a number of elements, so pushing up to that
+/// number does not reallocate the buffer
+/// @param vector The vector
+/// @param capacity Final requested capacity of the vector, in elements
+/// @return Result code
+ResultCode types_vector_reserve(Vector *vector, const size_t capacity);
+
 /// @brief Remove all the elements in the vector
 /// @param vector The vector that will be cleared
 /// @return Result code
@@ -22,4 +22,12 @@ typedef enum
     BOOL_UNKNOWN
 } Boolean;
 
+/// @brief Formats a document can be read from and written to
+typedef enum Format_e
+{
+    FORMAT_JSON,
+    FORMAT_CBOR,
+    FORMAT_MSGPACK
+} Format;
+
 #endif
\ No newline at end of file
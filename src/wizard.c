@@ -1,6 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glob.h>
+#include <pthread.h>
 
 #include "utils.h"
 #include "write.h"
@@ -9,24 +15,293 @@
 #include "node.h"
 #include "types/types_vector.h"
 #include "parse.h"
+#include "types/types_memory.h"
+#include "document.h"
+#include "thread_pool.h"
+#include "server.h"
+#include "journal.h"
+#include "trace.h"
 
-ResultCode execute_command(Node *root, const ParsedCommand *parsed_command);
-Node *traverse(Node *node, const Vector *steps, const bool create);
+/// @brief Options of the program, given before or after the command
+typedef struct Options_st
+{
+    bool stats;          // Report the memory used
+    Format from;         // Format of the file read
+    Format to;           // Format of the file written
+    size_t threads;      // Threads that find the nodes of each command
+    const char *batch;   // Script of commands, - for the standard input, or NULL for a single command
+    bool timing;         // Report the time taken by each command of a batch
+    bool serve;          // Serve commands over a socket
+    const char *socket;  // Path of the socket to serve on
+    const char *profile; // File where the time taken by each phase is written, or NULL
+    long flush;          // Seconds between writes of the changed documents while serving, 0 for never
+    glob_t files;        // Files the command is applied to, instead of the one it names
+    size_t jobs;         // Threads that apply the command to the files, 0 for one per processor
+    bool journal;        // Append the command to the journal of the file instead of writing it
+    bool compact;        // Write the file with the changes in its journal, and empty the journal
+    size_t limit;        // Bytes of journal past which it is compacted into the file
+} Options;
+
+/// @brief A line of a batch: a command, or the end of a group of commands
+typedef struct BatchStep_st
+{
+    size_t line;                   // Number of the line in the script
+    ParsedCommand *parsed_command; // Command, or NULL for a save
+} BatchStep;
+
+/// @brief Work shared by the threads that apply a command to many files. Each thread takes the
+/// next file until there are none left
+typedef struct Apply_st
+{
+    const ParsedCommand *parsed_command; // Command applied to every file
+    const Options *options;              // Options of the program
+    pthread_mutex_t lock;                // Protects everything below, and the reports
+    size_t next;                         // Next file to be taken
+    size_t done;                         // Files done, whether they failed or not
+    size_t failed;                       // Files that failed
+    size_t bytes;                        // Bytes of the files done
+    long start;                          // Milliseconds of a monotonic clock when the work started
+    long reported;                       // Milliseconds when progress was last reported
+    ResultCode result;                   // First failure
+} Apply;
+
+/// @brief A document kept in memory by the server, with the file it was read from
+typedef struct ServedDocument_st
+{
+    String *filename;   // File of the document, or NULL for the one commands without a file use
+    Document *document; // Document, with its keys indexed
+    bool snapshot;      // Indicates if the file is a snapshot
+    bool changed;       // Indicates if the document changed since it was last written
+    Vector *commands;   // Vector of String, the commands applied since the document was last written
+} ServedDocument;
+
+/// @brief State of the server, given to the functions that answer its requests
+typedef struct Service_st
+{
+    Vector *documents;      // Vector of ServedDocument, the documents resident in memory
+    const Options *options; // Options of the program
+    ThreadPool *pool;       // Threads that find the nodes of each command, or NULL
+    Server *server;         // Server
+} Service;
+
+ResultCode run_command(const String *command, const Options *options, ThreadPool *pool);
+ResultCode run_batch(FILE *script, const Options *options, ThreadPool *pool);
+ResultCode free_batch_step(void *step);
+ResultCode run_server(const Options *options, ThreadPool *pool);
+ResultCode run_apply(const String *command, const Options *options);
+ResultCode apply_files(void *apply, const size_t index);
+void apply_report(Apply *apply, const long now, const bool last);
+long now_milliseconds(void);
+ResultCode serve_request(void *service, const String *request, String *reply);
+ResultCode serve_flush(void *service);
+ResultCode revert_served_document(Service *service, ServedDocument *served);
+ResultCode free_served_document(void *served);
+Document *load_document(const String *filename, const Format from, bool *snapshot, ReadContext *context);
+ResultCode save_document(const Document *document, const String *filename, const bool snapshot, const Format to);
+ResultCode save_to_journal(const Document *document, const String *filename, const String *command, const Options *options);
+ResultCode replay_journal(Document *document, const String *filename);
+ResultCode replay_command(void *root, const String *record);
+ParsedCommand *parse_command(const String *command);
+ResultCode execute_command(Node *root, const ParsedCommand *parsed_command, ThreadPool *pool, bool *changed);
+ResultCode find_nodes(Node *root, const JsonPath *path, const bool create, ThreadPool *pool, Vector **nodes);
+ResultCode free_nothing(void *element);
+void print_stats(const Node *root);
+ResultCode write_profile(const Options *options);
+bool parse_format(const char *name, Format *format);
 
 int main(int argc, char **argv)
 {
-    // Turn the command provided into a complete string for the parser
+    // Turn the command provided into a complete string for the parser,
+    // leaving out the options that belong to the program itself
+    Options options = {false, FORMAT_JSON, FORMAT_JSON, 1, NULL, false, false, NULL, NULL, 0, {0}, 0, false, false, JOURNAL_DEFAULT_LIMIT};
     String *command = types_string_create();
     for (size_t i = 1; i < argc; i++)
     {
-        if (types_string_join_in_place(command, types_string_create_from_literal(argv[i])) != CODE_OK)
+        if (i == 1 && strcmp(argv[i], "serve") == 0)
+        {
+            options.serve = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--socket") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            options.socket = argv[i + 1];
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--flush") == 0)
+        {
+            // Seconds between writes of the documents changed while serving
+            char *end = NULL;
+            options.flush = i + 1 < argc ? strtol(argv[i + 1], &end, 10) : 0;
+            if (options.flush <= 0 || end == NULL || *end != '\0')
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--profile") == 0)
+        {
+            // Time every phase, and write the totals and the timeline to a file
+            if (i + 1 >= argc || trace_enable() != CODE_OK)
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            options.profile = argv[i + 1];
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--stats") == 0)
+        {
+            options.stats = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--timing") == 0)
+        {
+            options.timing = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0)
+        {
+            if (i + 1 >= argc || !parse_format(argv[i + 1], strcmp(argv[i], "--from") == 0 ? &options.from : &options.to))
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--threads") == 0)
+        {
+            // Number of threads that evaluate the paths over large arrays
+            char *end = NULL;
+            options.threads = i + 1 < argc ? strtoul(argv[i + 1], &end, 10) : 0;
+            if (options.threads == 0 || end == NULL || *end != '\0')
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--each") == 0)
+        {
+            // Files, or patterns for them, the command is applied to. A pattern that matches
+            // nothing is kept as it is, so the missing file is reported
+            const int flags = GLOB_NOCHECK | (options.files.gl_pathc > 0 ? GLOB_APPEND : 0);
+            if (i + 1 >= argc || glob(argv[i + 1], flags, NULL, &options.files) != 0)
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--jobs") == 0)
+        {
+            char *end = NULL;
+            options.jobs = i + 1 < argc ? strtoul(argv[i + 1], &end, 10) : 0;
+            if (options.jobs == 0 || end == NULL || *end != '\0')
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--journal") == 0 || strcmp(argv[i], "--compact") == 0)
+        {
+            *(strcmp(argv[i], "--journal") == 0 ? &options.journal : &options.compact) = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--journal-limit") == 0)
+        {
+            // Bytes the journal may grow to before it is compacted into the file
+            char *end = NULL;
+            options.limit = i + 1 < argc ? strtoul(argv[i + 1], &end, 10) : 0;
+            if (options.limit == 0 || end == NULL || *end != '\0')
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--batch") == 0)
+        {
+            // Script with one command per line, or - for the standard input
+            if (i + 1 >= argc)
+            {
+                return CODE_SYNTAX_ERROR;
+            }
+            options.batch = argv[i + 1];
+            i += 1;
+            continue;
+        }
+        const String word = {argv[i], strlen(argv[i]), strlen(argv[i]) + 1};
+        if (types_string_join_in_place(command, &word) != CODE_OK)
         {
             return CODE_MEMORY_ERROR;
         }
     }
 
+    // The journal holds commands, and is only kept for a single command on a JSON file
+    if ((options.journal || options.compact) &&
+        (options.from != FORMAT_JSON || options.to != FORMAT_JSON || options.batch != NULL || options.serve ||
+         options.files.gl_pathc > 0))
+    {
+        globfree(&options.files);
+        types_string_free(command);
+        free(command);
+        return CODE_SYNTAX_ERROR;
+    }
+
+    // Many files are worked on by threads of their own
+    if (options.files.gl_pathc > 0)
+    {
+        ResultCode result = run_apply(command, &options);
+        const ResultCode profiled = write_profile(&options);
+        result = result == CODE_OK ? profiled : result;
+        globfree(&options.files);
+        types_string_free(command);
+        free(command);
+        return result;
+    }
+
+    // The pool of threads, if any, is shared by all the commands
+    ThreadPool *pool = options.threads > 1 ? thread_pool_create(options.threads) : NULL;
+    ResultCode result = options.threads > 1 && pool == NULL ? CODE_MEMORY_ERROR : CODE_OK;
+    if (result == CODE_OK && options.serve)
+    {
+        result = options.socket != NULL ? run_server(&options, pool) : CODE_SYNTAX_ERROR;
+    }
+    else if (result == CODE_OK && options.batch != NULL)
+    {
+        FILE *script = strcmp(options.batch, "-") == 0 ? stdin : fopen(options.batch, "r");
+        result = script != NULL ? run_batch(script, &options, pool) : CODE_READ_ERROR;
+        if (script != NULL && script != stdin)
+        {
+            fclose(script);
+        }
+    }
+    else if (result == CODE_OK)
+    {
+        result = run_command(command, &options, pool);
+    }
+
+    // The phases are reported even when the command failed, as they may tell why
+    const ResultCode profiled = write_profile(&options);
+    result = result == CODE_OK ? profiled : result;
+    thread_pool_free(pool);
+    globfree(&options.files);
+    types_string_free(command);
+    free(command);
+    return result;
+}
+
+ResultCode run_command(const String *command, const Options *options, ThreadPool *pool)
+{
     // Parse the command
-    ParsedCommand *parsed_command = parse(command);
+    ParsedCommand *parsed_command = parse_command(command);
     if (parsed_command == NULL)
     {
         return CODE_SYNTAX_ERROR;
@@ -34,177 +309,740 @@ int main(int argc, char **argv)
     // Check the json path is valid
     if (!parsed_command->path.valid)
     {
+        parse_free(parsed_command);
         return CODE_SYNTAX_ERROR;
     }
 
     // If the user has provided a filename, we start by loading the JSON
     // inside the file. If not, we begin with an empty JSON
-    Node *root;
-    if (parsed_command->filename != NULL)
+    bool snapshot = false;
+    Document *document = load_document(parsed_command->filename, options->from, &snapshot, NULL);
+    if (!document)
     {
-        root = read_from_file(parsed_command->filename);
-        if (!root)
+        const ResultCode result = parsed_command->filename != NULL ? CODE_READ_ERROR : CODE_MEMORY_ERROR;
+        parse_free(parsed_command);
+        return result;
+    }
+
+    // Execute command, and output to file, or only to its journal
+    ResultCode result = execute_command(document->root, parsed_command, pool, NULL);
+    if (result == CODE_OK)
+    {
+        const bool journaled = (options->journal || options->compact) && parsed_command->filename != NULL && !snapshot;
+        result = journaled ? save_to_journal(document, parsed_command->filename, command, options)
+                           : save_document(document, parsed_command->filename, snapshot, options->to);
+
+        // Report the memory used, if requested
+        if (options->stats)
         {
-            return CODE_READ_ERROR;
+            print_stats(document->root);
         }
     }
-    else
+    document_free(document);
+    parse_free(parsed_command);
+    return result;
+}
+
+ResultCode run_batch(FILE *script, const Options *options, ThreadPool *pool)
+{
+    // The whole script is read and checked before the document is touched, so a mistake on any
+    // line stops the batch before a single change is made
+    Vector *steps = types_vector_create(sizeof(BatchStep), free_batch_step);
+    if (steps == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    const String *filename = NULL;
+    size_t commands = 0;
+    ResultCode result = CODE_OK;
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    for (size_t number = 1; result == CODE_OK && (length = getline(&line, &capacity, script)) >= 0; number++)
     {
-        root = node_create();
-        if (!root)
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
         {
-            return CODE_MEMORY_ERROR;
+            line[--length] = '\0';
+        }
+        size_t first = strspn(line, " \t");
+        if (line[first] == '\0' || line[first] == '#')
+        {
+            // Blank lines and comments
+            continue;
         }
-    }
 
-    // Execute command
-    ResultCode result = execute_command(root, parsed_command);
-    if (result != CODE_OK)
+        // A line with just save ends a group of commands, which is written as a whole
+        BatchStep step = {number, NULL};
+        if (strcmp(line + first, "save") != 0)
+        {
+            String command = {line + first, length - first, capacity - first};
+            step.parsed_command = parse_command(&command);
+            if (step.parsed_command == NULL || !step.parsed_command->path.valid)
+            {
+                fprintf(stderr, "line %zu: syntax error\n", number);
+                parse_free(step.parsed_command);
+                result = CODE_SYNTAX_ERROR;
+                break;
+            }
+
+            // The first command names the file for all of them
+            const String *named = step.parsed_command->filename;
+            if (commands++ == 0)
+            {
+                filename = named;
+            }
+            else if (named != NULL && (filename == NULL || types_string_compare(filename, named) != 0))
+            {
+                fprintf(stderr, "line %zu: a batch works on a single file\n", number);
+                parse_free(step.parsed_command);
+                result = CODE_LOGIC_ERROR;
+                break;
+            }
+        }
+        if (types_vector_push(steps, &step) != CODE_OK)
+        {
+            parse_free(step.parsed_command);
+            result = CODE_MEMORY_ERROR;
+        }
+    }
+    free(line);
+    if (result != CODE_OK || commands == 0)
     {
+        types_vector_free(steps);
+        free(steps);
         return result;
     }
 
-    // Output to file
-    return write_to_file(root, parsed_command->filename);
+    // Batches run many commands, so the index of the keys pays for itself
+    bool snapshot = false;
+    Document *document = load_document(filename, options->from, &snapshot, NULL);
+    result = document == NULL ? CODE_READ_ERROR : document_index(document);
+
+    // Each group of commands is a transaction, written once through a temporary file renamed
+    // over the old one after all of the group has succeeded. The first command that fails stops
+    // the batch, and its group is rolled back by dropping the document before any of it is written
+    bool changed = false;
+    for (size_t i = 0; result == CODE_OK && i < types_vector_size(steps); i++)
+    {
+        const BatchStep *step = types_vector_at(steps, i);
+        if (step->parsed_command == NULL)
+        {
+            result = changed ? save_document(document, filename, snapshot, options->to) : CODE_OK;
+            changed = false;
+            continue;
+        }
+
+        // Time each command on its own, leaving out reading and writing the file
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        result = execute_command(document->root, step->parsed_command, pool, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        changed = true;
+        if (options->timing)
+        {
+            printf("{\"line\":%zu,\"result\":%d,\"ns\":%lld}\n", step->line, result,
+                   (long long)(end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec));
+        }
+        if (result != CODE_OK)
+        {
+            fprintf(stderr, "line %zu: command failed, the changes since the last save are rolled back\n", step->line);
+        }
+    }
+
+    // The last group needs no save of its own
+    if (result == CODE_OK && changed)
+    {
+        result = save_document(document, filename, snapshot, options->to);
+    }
+    if (result == CODE_OK && options->stats)
+    {
+        print_stats(document->root);
+    }
+    document_free(document);
+    types_vector_free(steps);
+    free(steps);
+    return result;
 }
 
-ResultCode execute_command(Node *root, const ParsedCommand *parsed_command)
+ResultCode run_server(const Options *options, ThreadPool *pool)
 {
-    // Decide depending on the type of command
-    switch (parsed_command->command)
+    Service service = {types_vector_create(sizeof(ServedDocument), free_served_document), options, pool, NULL};
+    service.server = service.documents != NULL ? server_create(options->socket, serve_request, &service) : NULL;
+    ResultCode result = service.server != NULL ? CODE_OK : CODE_ERROR;
+    if (result == CODE_OK && options->flush > 0)
     {
-    case COMMAND_SET_KEY:
+        result = server_set_timer(service.server, serve_flush, options->flush * 1000);
+    }
+    if (result == CODE_OK)
+    {
+        result = server_run(service.server);
+    }
+
+    // Nothing changed is lost when the server stops
+    if (service.documents != NULL)
+    {
+        const ResultCode flushed = serve_flush(&service);
+        result = result == CODE_OK ? flushed : result;
+        types_vector_free(service.documents);
+        free(service.documents);
+    }
+    server_free(service.server);
+    return result;
+}
+
+ResultCode serve_request(void *service, const String *request, String *reply)
+{
+    // Requests are the commands parse understands, plus save and shutdown. Each one is answered
+    // with OK, or with ERROR followed by the result code
+    Service *state = service;
+    const char *text = types_string_c_str(request);
+    ResultCode result = CODE_OK;
+    ResultCode reverted = CODE_OK;
+    if (strcmp(text, "save") == 0 || strcmp(text, "shutdown") == 0)
     {
-        // Get the json path that was provided by the user
-        JsonPath json_path = parsed_command->path;
-        // Iterate over all the possible paths returned
-        for (size_t i = 0, n = types_vector_size(json_path.paths); i < n; i++)
+        result = serve_flush(state);
+        if (strcmp(text, "shutdown") == 0)
         {
-            // Get the current path, which is a vector of steps
-            Vector *steps = types_vector_at(json_path.paths, i);
-            // Point to the node at the end of the path, in this case
-            // we are not allowed to create nodes along the way
-            Node *node = traverse(root, steps, false);
-            if (!node)
-            {
-                return CODE_LOGIC_ERROR;
-            }
-            // Now we are pointing to the node we want, so update the key if possible
-            if (node_set_key(node, &parsed_command->data.set_key_data.key) != CODE_OK)
-            {
-                return CODE_LOGIC_ERROR;
-            }
+            server_stop(state->server);
         }
-        return CODE_OK;
     }
-    case COMMAND_SET_VALUE:
+    else
     {
-        // First try to create a new ndoe with the string that has been provided
-        // Create a new node with the string that has been provided
-        Node *new = read_from_string(&parsed_command->data.set_value_data.value);
-        if (!new)
+        ParsedCommand *parsed_command = parse_command(request);
+        result = parsed_command != NULL && parsed_command->path.valid ? CODE_OK : CODE_SYNTAX_ERROR;
+
+        // The document of the file is loaded by the first command that names it, and stays
+        ServedDocument *served = NULL;
+        for (size_t i = 0, n = types_vector_size(state->documents); i < n && result == CODE_OK && served == NULL; i++)
         {
-            return CODE_SYNTAX_ERROR;
+            ServedDocument *candidate = types_vector_at(state->documents, i);
+            if (candidate->filename == NULL ? parsed_command->filename == NULL
+                                            : parsed_command->filename != NULL &&
+                                                  types_string_compare(candidate->filename, parsed_command->filename) == 0)
+            {
+                served = candidate;
+            }
         }
-        // Get the json path that was provided by the user
-        JsonPath json_path = parsed_command->path;
-        // Iterate over all the possible paths returned
-        for (size_t i = 0, n = types_vector_size(json_path.paths); i < n; i++)
+        if (result == CODE_OK && served == NULL)
         {
-            // Get the current path, which is a vector of steps
-            Vector *steps = types_vector_at(json_path.paths, i);
-            // Point to the node at the end of the path, in this case
-            // we are not allowed to create nodes along the way
-            Node *node = traverse(root, steps, true);
-            if (!node)
+            ServedDocument loaded = {NULL, NULL, false, false, NULL};
+            loaded.filename = parsed_command->filename != NULL ? types_string_copy(parsed_command->filename) : NULL;
+            loaded.document = load_document(parsed_command->filename, state->options->from, &loaded.snapshot, NULL);
+            loaded.commands = types_vector_create(sizeof(String), types_string_free);
+            result = loaded.document == NULL || (parsed_command->filename != NULL && loaded.filename == NULL)
+                         ? CODE_READ_ERROR
+                         : loaded.commands == NULL ? CODE_MEMORY_ERROR
+                                                   : document_index(loaded.document);
+            if (result == CODE_OK && types_vector_push(state->documents, &loaded) != CODE_OK)
             {
-                return CODE_LOGIC_ERROR;
+                result = CODE_MEMORY_ERROR;
             }
-            // Now we are pointing to the node we want, so set the value
-            if (node_set_data(node, new) != CODE_OK)
+            if (result != CODE_OK)
             {
-                return CODE_LOGIC_ERROR;
+                free_served_document(&loaded);
             }
+            served = result == CODE_OK ? types_vector_at(state->documents, types_vector_size(state->documents) - 1) : NULL;
         }
-        return CODE_OK;
-    }
-    case COMMAND_ERASE:
-    {
-        // Get the json path that was provided by the user
-        JsonPath json_path = parsed_command->path;
-        // Iterate over all the possible paths returned
-        for (size_t i = 0, n = types_vector_size(json_path.paths); i < n; i++)
+        if (result == CODE_OK)
         {
-            // Get the current path, which is a vector of steps
-            Vector *steps = types_vector_at(json_path.paths, i);
-            // Point to the node at the end of the path, in this case
-            // we are not allowed to create nodes along the way
-            Node *node = traverse(root, steps, false);
-            if (!node)
+            // A command that fails after changing some of its nodes leaves a document that is
+            // rebuilt without it, so the half-made change never reaches the disk
+            bool changed = false;
+            result = execute_command(served->document->root, parsed_command, state->pool, &changed);
+            if (result == CODE_OK)
             {
-                return CODE_LOGIC_ERROR;
+                // The command is kept to rebuild the document, and fails if it cannot be
+                String *applied = types_string_copy(request);
+                result = applied != NULL && types_vector_push(served->commands, applied) == CODE_OK ? CODE_OK : CODE_MEMORY_ERROR;
+                if (result != CODE_OK && applied != NULL)
+                {
+                    types_string_free(applied);
+                }
+                free(applied);
+                served->changed = served->changed || result == CODE_OK;
             }
-            // Now we are pointing to the node we want, so erase it
-            if (node_erase(node) != CODE_OK)
+            if (result != CODE_OK && changed)
             {
-                return CODE_LOGIC_ERROR;
+                reverted = revert_served_document(state, served);
             }
         }
-        return CODE_OK;
+        parse_free(parsed_command);
+    }
+    char answer[48];
+    if (reverted != CODE_OK)
+    {
+        snprintf(answer, sizeof(answer), "ERROR %d REVERT %d", result, reverted);
+    }
+    else
+    {
+        snprintf(answer, sizeof(answer), result == CODE_OK ? "OK" : "ERROR %d", result);
+    }
+    const String piece = {answer, strlen(answer), sizeof(answer)};
+    types_string_join_in_place(reply, &piece);
+    return result;
+}
+
+ResultCode revert_served_document(Service *service, ServedDocument *served)
+{
+    // Read the file as it was last written and apply again the commands that succeeded since.
+    // If that fails, the document is kept as it is, with the commands that succeeded in it
+    bool snapshot = false;
+    Document *document = load_document(served->filename, service->options->from, &snapshot, NULL);
+    ResultCode result = document == NULL ? CODE_READ_ERROR : document_index(document);
+    for (size_t i = 0, n = types_vector_size(served->commands); i < n && result == CODE_OK; i++)
+    {
+        result = replay_command(document->root, types_vector_at(served->commands, i));
     }
+    if (result != CODE_OK)
+    {
+        document_free(document);
+        return result;
     }
+    document_free(served->document);
+    served->document = document;
+    served->snapshot = snapshot;
+    return CODE_OK;
 }
 
-Node *traverse(Node *node, const Vector *steps, const bool create)
+ResultCode serve_flush(void *service)
 {
-    // Iterate over all the steps in this path
-    Node *child = NULL;
-    for (size_t j = 0, m = types_vector_size(steps); j < m; j++)
+    // Write every document changed since it was last written. The one without a file stays in memory
+    Service *state = service;
+    ResultCode result = CODE_OK;
+    for (size_t i = 0, n = types_vector_size(state->documents); i < n; i++)
     {
-        // Point to the current step
-        PathStep *step = types_vector_at(steps, j);
-        // Get the child, if possible
-        if (step->id == PATH_STEP_INDEX)
+        ServedDocument *served = types_vector_at(state->documents, i);
+        if (served->changed && served->filename != NULL)
         {
-            child = node_array_get(node, step->data.index);
+            const ResultCode saved = save_document(served->document, served->filename, served->snapshot, state->options->to);
+            served->changed = saved != CODE_OK;
+            if (saved == CODE_OK)
+            {
+                types_vector_clear(served->commands);
+            }
+            result = result == CODE_OK ? saved : result;
+        }
+    }
+    return result;
+}
+
+ResultCode free_batch_step(void *step)
+{
+    return parse_free(((BatchStep *)step)->parsed_command);
+}
+
+ResultCode free_served_document(void *served)
+{
+    ServedDocument *served_document = served;
+    if (served_document->filename != NULL)
+    {
+        types_string_free(served_document->filename);
+        free(served_document->filename);
+    }
+    if (served_document->commands != NULL)
+    {
+        types_vector_free(served_document->commands);
+        free(served_document->commands);
+    }
+    return document_free(served_document->document);
+}
+
+ResultCode run_apply(const String *command, const Options *options)
+{
+    ParsedCommand *parsed_command = parse_command(command);
+    if (parsed_command == NULL || !parsed_command->path.valid)
+    {
+        parse_free(parsed_command);
+        return CODE_SYNTAX_ERROR;
+    }
+
+    Apply apply = {parsed_command, options, PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, 0, now_milliseconds(), 0, CODE_OK};
+    apply.reported = apply.start;
+    size_t jobs = options->jobs;
+    if (jobs == 0)
+    {
+        const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = processors > 0 ? processors : 1;
+    }
+    jobs = jobs < options->files.gl_pathc ? jobs : options->files.gl_pathc;
+    ThreadPool *pool = jobs > 1 ? thread_pool_create(jobs) : NULL;
+    ResultCode result = jobs > 1 && pool == NULL ? CODE_MEMORY_ERROR : CODE_OK;
+    if (result == CODE_OK)
+    {
+        // Every task is a thread that takes files until there are none left
+        const ResultCode ran = thread_pool_run(pool, jobs, apply_files, &apply);
+        apply_report(&apply, now_milliseconds(), true);
+        result = apply.result == CODE_OK ? ran : apply.result;
+    }
+    thread_pool_free(pool);
+    pthread_mutex_destroy(&apply.lock);
+    parse_free(parsed_command);
+    return result;
+}
+
+ResultCode apply_files(void *apply, const size_t index)
+{
+    // Every thread has its own context, which keeps the tokens, the largest buffer of a read,
+    // from one file to the next, and shares the lexer with the other threads
+    Apply *work = apply;
+    ReadContext *context = read_context_create(NULL);
+    if (context == NULL)
+    {
+        // The files are left to the other threads, if any, and the run fails
+        pthread_mutex_lock(&work->lock);
+        work->result = work->result == CODE_OK ? CODE_MEMORY_ERROR : work->result;
+        pthread_mutex_unlock(&work->lock);
+        return CODE_MEMORY_ERROR;
+    }
+    pthread_mutex_lock(&work->lock);
+    while (work->next < work->options->files.gl_pathc)
+    {
+        const char *name = work->options->files.gl_pathv[work->next++];
+        pthread_mutex_unlock(&work->lock);
+
+        // Every file is read, changed and written on its own, with the same command
+        String *filename = types_string_create_from_literal(name);
+        struct stat file_stat;
+        const size_t bytes = stat(name, &file_stat) == 0 ? file_stat.st_size : 0;
+        bool snapshot = false;
+        Document *document = filename != NULL ? load_document(filename, work->options->from, &snapshot, context) : NULL;
+        ResultCode result = document != NULL ? execute_command(document->root, work->parsed_command, NULL, NULL) : CODE_READ_ERROR;
+        if (result == CODE_OK)
+        {
+            result = save_document(document, filename, snapshot, work->options->to);
         }
-        else
+        document_free(document);
+        if (filename != NULL)
         {
-            child = node_get(node, &step->data.key);
+            types_string_free(filename);
+            free(filename);
         }
 
-        if (!child)
+        pthread_mutex_lock(&work->lock);
+        work->done += 1;
+        work->bytes += bytes;
+        if (result != CODE_OK)
         {
-            if (create)
-            {
-                // If the node was not found, we need to create it here
-                child = node_create();
-                // And then add it to the parent
-                if (step->id == PATH_STEP_INDEX)
-                {
-                    // Create the iterators in order to insert
-                    Iterator begin = types_iterator_create(child, sizeof(Node *));
-                    Iterator end = types_iterator_increase(begin, 1);
-                    Iterator destination = types_iterator_increase(types_vector_begin((Vector *)node->data), step->data.index);
-                    node_array_insert(node, begin, end, destination);
-                }
-                else
-                {
-                    node_append(node, &step->data.key, child);
-                }
-            }
-            else
-            {
-                // We are not allowed to create any node, so we have found a step
-                // were the path does not lead enywhere
-                return NULL;
-            }
+            fprintf(stderr, "%s: error %d\n", name, result);
+            work->failed += 1;
+            work->result = work->result == CODE_OK ? result : work->result;
+        }
+        apply_report(work, now_milliseconds(), false);
+    }
+    pthread_mutex_unlock(&work->lock);
+    read_context_free(context);
+    return CODE_OK;
+}
+
+void apply_report(Apply *apply, const long now, const bool last)
+{
+    // Progress goes to the standard error at most once a second, and once more at the end
+    if (!last && now - apply->reported < 1000)
+    {
+        return;
+    }
+    apply->reported = now;
+    const double seconds = (now - apply->start) / 1000.0;
+    fprintf(stderr, "%s%zu/%zu files, %zu failed, %.1f MB, %.1f files/s, %.1f MB/s\n", last ? "done: " : "",
+            apply->done, apply->options->files.gl_pathc, apply->failed, apply->bytes / 1e6,
+            seconds > 0 ? apply->done / seconds : 0.0, seconds > 0 ? apply->bytes / 1e6 / seconds : 0.0);
+}
+
+long now_milliseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000L + now.tv_nsec / 1000000L;
+}
+
+Document *load_document(const String *filename, const Format from, bool *snapshot, ReadContext *context)
+{
+    // A file saved by write_snapshot is mapped instead of parsed, and saved back the same way
+    *snapshot = false;
+    if (filename == NULL)
+    {
+        return document_create(node_create(), NULL);
+    }
+    Snapshot *mapped = read_snapshot(filename);
+    if (mapped != NULL)
+    {
+        *snapshot = true;
+        Document *document = document_create(snapshot_to_node(mapped, snapshot_root(mapped)), NULL);
+        snapshot_close(mapped);
+        return document;
+    }
+    if (from == FORMAT_JSON)
+    {
+        // The changes waiting in a journal are part of the document
+        Document *document = context != NULL ? read_document_with_context(filename, context) : read_document(filename);
+        if (document != NULL && replay_journal(document, filename) != CODE_OK)
+        {
+            document_free(document);
+            return NULL;
         }
+        return document;
+    }
+    return document_create(read_from_file_format(filename, from), NULL);
+}
+
+ResultCode save_document(const Document *document, const String *filename, const bool snapshot, const Format to)
+{
+    // Only the parts touched by the commands are formatted again, everything else is
+    // copied from the original text
+    const uint64_t start = trace_begin();
+    ResultCode result;
+    if (snapshot)
+    {
+        result = write_snapshot(document->root, filename);
+    }
+    else if (to == FORMAT_JSON)
+    {
+        result = write_document_to_file(document, filename);
+    }
+    else
+    {
+        result = write_to_file_format(document->root, filename, to);
+    }
+    struct stat file_stat;
+    trace_end(TRACE_PHASE_WRITE, start, 0, start != 0 && filename != NULL && stat(types_string_c_str(filename), &file_stat) == 0 ? file_stat.st_size : 0);
+    return result;
+}
 
-        // Now we need to point to the child
-        node = child;
+ResultCode save_to_journal(const Document *document, const String *filename, const String *command, const Options *options)
+{
+    // The journal starts from the text just read, which the changes replayed from it left alone
+    Journal *journal = journal_open(filename, document->source);
+    if (journal == NULL)
+    {
+        return CODE_WRITE_ERROR;
     }
 
-    // Final node
-    return node;
+    // Most commands cost a single small append. Once the journal grows too large, or when
+    // asked, the whole file is written instead, and the journal starts again from its new text
+    ResultCode result = options->compact ? CODE_OK : journal_append(journal, command);
+    if (result == CODE_OK && (options->compact || journal->size > options->limit))
+    {
+        String *text = write_document_to_string(document);
+        result = text != NULL ? write_buffer_to_file(types_string_c_str(text), types_string_length(text), filename) : CODE_MEMORY_ERROR;
+
+        // Were the program to stop before the reset, the journal would not match the new text,
+        // and would be found stale and emptied, rather than applied twice
+        result = result == CODE_OK ? journal_reset(journal, text) : result;
+        if (text != NULL)
+        {
+            types_string_free(text);
+            free(text);
+        }
+    }
+    const ResultCode closed = journal_close(journal);
+    return result != CODE_OK ? result : closed;
+}
+
+ResultCode replay_journal(Document *document, const String *filename)
+{
+    // Most files have no journal, and none is created for them
+    String *path = types_string_copy(filename);
+    const String suffix = {JOURNAL_SUFFIX, strlen(JOURNAL_SUFFIX), strlen(JOURNAL_SUFFIX) + 1};
+    if (path == NULL || types_string_join_in_place(path, &suffix) != CODE_OK)
+    {
+        types_string_free(path);
+        free(path);
+        return CODE_MEMORY_ERROR;
+    }
+    const bool exists = access(types_string_c_str(path), F_OK) == 0;
+    types_string_free(path);
+    free(path);
+    if (!exists || document->source == NULL)
+    {
+        return CODE_OK;
+    }
+    Journal *journal = journal_open(filename, document->source);
+    if (journal == NULL)
+    {
+        return CODE_READ_ERROR;
+    }
+    ResultCode result = journal_replay(journal, replay_command, document->root);
+    const ResultCode closed = journal_close(journal);
+    return result != CODE_OK ? result : closed;
+}
+
+ResultCode replay_command(void *root, const String *record)
+{
+    // Records are commands as given to the program, whose file is the one being loaded
+    ParsedCommand *parsed_command = parse_command(record);
+    ResultCode result = parsed_command != NULL && parsed_command->path.valid ? execute_command(root, parsed_command, NULL, NULL) : CODE_SYNTAX_ERROR;
+    parse_free(parsed_command);
+    return result;
+}
+
+ParsedCommand *parse_command(const String *command)
+{
+    const uint64_t start = trace_begin();
+    ParsedCommand *parsed_command = parse(command);
+    trace_end(TRACE_PHASE_COMMAND, start, 0, command != NULL ? types_string_length(command) : 0);
+    return parsed_command;
+}
+
+ResultCode execute_command(Node *root, const ParsedCommand *parsed_command, ThreadPool *pool, bool *changed)
+{
+    // Find the nodes at the end of all the paths at once. The paths are merged by their
+    // common prefixes, so a prefix shared by many paths is walked only once. Only setting
+    // a value is allowed to create the nodes missing along the way. The changes themselves are
+    // made by this thread alone, once the threads of the pool have found every node
+    const uint64_t start = trace_begin();
+
+    // The value to set is read first, so a value that is not valid fails the command before
+    // the missing nodes of the path are created. A path that fails leaves no node created
+    Node *new = NULL;
+    if (parsed_command->command == COMMAND_SET_VALUE)
+    {
+        new = read_from_string(&parsed_command->data.set_value_data.value);
+        if (new == NULL)
+        {
+            return CODE_SYNTAX_ERROR;
+        }
+    }
+    Vector *nodes;
+    ResultCode result = find_nodes(root, &parsed_command->path, parsed_command->command == COMMAND_SET_VALUE, pool, &nodes);
+    if (result != CODE_OK)
+    {
+        node_destroy(new);
+        return result;
+    }
+
+    // A path that fails changes nothing, and from here on every node found is changed, so the
+    // caller knows whether a command that fails has to be undone
+    if (changed != NULL)
+    {
+        *changed = types_vector_size(nodes) > 0;
+    }
+
+    // The nodes come with the parents before their children, so they are changed from the
+    // last one back, and a change to a node never touches one that is still to be changed
+    switch (parsed_command->command)
+    {
+    case COMMAND_SET_KEY:
+        for (size_t i = types_vector_size(nodes); i > 0 && result == CODE_OK; i--)
+        {
+            // Update the key if possible
+            Node *node = *(Node **)types_vector_at(nodes, i - 1);
+            result = node_set_key(node, &parsed_command->data.set_key_data.key) != CODE_OK ? CODE_LOGIC_ERROR : CODE_OK;
+        }
+        break;
+    case COMMAND_SET_VALUE:
+        // Every node gets a copy of the value
+        for (size_t i = types_vector_size(nodes); i > 0 && result == CODE_OK; i--)
+        {
+            // Set the value
+            Node *node = *(Node **)types_vector_at(nodes, i - 1);
+            result = node_set_data(node, new) != CODE_OK ? CODE_LOGIC_ERROR : CODE_OK;
+        }
+        node_destroy(new);
+        break;
+    case COMMAND_ERASE:
+        for (size_t i = types_vector_size(nodes); i > 0 && result == CODE_OK; i--)
+        {
+            // Erase the node
+            Node *node = *(Node **)types_vector_at(nodes, i - 1);
+            result = node_erase(node) != CODE_OK ? CODE_LOGIC_ERROR : CODE_OK;
+        }
+        break;
+    default:
+        result = CODE_NOT_SUPPORTED;
+        break;
+    }
+    trace_end(TRACE_PHASE_EXECUTE, start, types_vector_size(nodes), 0);
+    types_vector_free(nodes);
+    free(nodes);
+    return result;
+}
+
+ResultCode find_nodes(Node *root, const JsonPath *path, const bool create, ThreadPool *pool, Vector **nodes)
+{
+    const uint64_t start = trace_begin();
+    PathTrie *trie = json_path_trie_create(path);
+    *nodes = types_vector_create(sizeof(Node *), free_nothing);
+    ResultCode result = trie != NULL && *nodes != NULL ? json_path_trie_evaluate_parallel(root, trie, create, pool, *nodes) : CODE_MEMORY_ERROR;
+    trace_end(TRACE_PHASE_TRAVERSE, start, result == CODE_OK ? types_vector_size(*nodes) : 0, 0);
+    if (trie != NULL)
+    {
+        json_path_trie_free(trie);
+        free(trie);
+    }
+    if (result != CODE_OK && *nodes != NULL)
+    {
+        types_vector_free(*nodes);
+        free(*nodes);
+        *nodes = NULL;
+    }
+    return result;
+}
+
+ResultCode free_nothing(void *element)
+{
+    // The vector only points to nodes that belong to the tree
+    return CODE_OK;
+}
+
+void print_stats(const Node *root)
+{
+    static const char *node_type_names[NODE_TYPE_NUMBER_OF_TYPES] = {
+        "null", "string", "number", "true", "false", "array", "object"};
+    static const char *category_names[MEMORY_CATEGORY_TOTAL] = {
+        "string", "vector", "node"};
+
+    // Memory used by the document, found by walking the tree
+    NodeStats node_stats_result;
+    memset(&node_stats_result, '\0', sizeof(NodeStats));
+    node_stats(root, &node_stats_result);
+    fprintf(stderr, "{\"document\":{\"nodes\":{");
+    for (size_t i = 0; i < NODE_TYPE_NUMBER_OF_TYPES; i++)
+    {
+        fprintf(stderr, "%s\"%s\":{\"count\":%zu,\"bytes\":%zu}", i == 0 ? "" : ",", node_type_names[i],
+                node_stats_result.nodes[i], node_stats_result.node_bytes[i]);
+    }
+    fprintf(stderr, "},\"string_bytes\":%zu,\"container_bytes\":%zu,\"container_overhead_bytes\":%zu,\"total_bytes\":%zu},",
+            node_stats_result.string_bytes, node_stats_result.container_bytes,
+            node_stats_result.container_overhead_bytes, node_stats_result.total_bytes);
+
+    // Counters kept by the allocation layer during the whole run
+    fprintf(stderr, "\"memory\":{");
+    for (size_t i = 0; i <= MEMORY_CATEGORY_TOTAL; i++)
+    {
+        MemoryCounters counters = i < MEMORY_CATEGORY_TOTAL ? types_memory_get(i) : types_memory_total();
+        fprintf(stderr, "%s\"%s\":{\"live_bytes\":%zu,\"peak_bytes\":%zu,\"allocations\":%zu,\"frees\":%zu,\"reserved_bytes\":%zu}",
+                i == 0 ? "" : ",", i < MEMORY_CATEGORY_TOTAL ? category_names[i] : "total",
+                counters.live_bytes, counters.peak_bytes, counters.allocations, counters.frees, counters.reserved_bytes);
+    }
+    fprintf(stderr, "}}\n");
+}
+
+ResultCode write_profile(const Options *options)
+{
+    if (options->profile == NULL)
+    {
+        return CODE_OK;
+    }
+    FILE *file = fopen(options->profile, "w");
+    ResultCode result = file != NULL ? trace_write(file) : CODE_WRITE_ERROR;
+    if (file != NULL && fclose(file) != 0)
+    {
+        result = CODE_WRITE_ERROR;
+    }
+    trace_reset();
+    return result;
+}
+
+bool parse_format(const char *name, Format *format)
+{
+    static const char *format_names[] = {"json", "cbor", "msgpack"};
+    for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); i++)
+    {
+        if (strcmp(name, format_names[i]) == 0)
+        {
+            *format = i;
+            return true;
+        }
+    }
+    return false;
 }
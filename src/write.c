@@ -1,16 +1,891 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "write.h"
+#include "write_number.h"
 #include "types/types_vector.h"
+#include "types/types_map.h"
+
+/// @brief Number of bytes buffered before they are flushed to a file descriptor
+#define WRITE_BUFFER_SIZE 65536
+
+/// @brief Position used for the nodes that have no span in the source text
+#define WRITE_NO_SPAN SIZE_MAX
+
+/// @brief Destination of the serializer. It is either a buffer in memory reserved
+/// with the exact size of the output, or a fixed-size buffer flushed to a file descriptor
+typedef struct Writer_st
+{
+    char *buffer;         // Buffer where the output is accumulated
+    size_t length;        // Number of bytes currently in the buffer
+    size_t capacity;      // Number of bytes that fit in the buffer
+    int fd;               // File descriptor to flush to, or -1 when writing to memory
+    ResultCode result;    // First error found, so the serialization can stop early
+    const String *source; // Text the nodes were read from, or NULL
+} Writer;
+
+static ResultCode write_file(const Node *node, const String *source, const String *filename);
+static ResultCode write_fd(const Node *node, const String *source, const int fd);
+static int write_open_temporary(const String *filename, String **temporary);
+static ResultCode write_replace(const int fd, String *temporary, const String *filename, ResultCode result);
+static String *write_string_all(const Node *node, const String *source);
+static void write_root(Writer *writer, const Node *node);
+static size_t write_margin(const Node *node, const String *source, const bool before);
+static bool write_is_verbatim(const Node *node, const String *source);
+static bool write_has_span(const Node *node, const String *source);
+static size_t write_gap(const String *source, const size_t start, const size_t end,
+                        const char opening, const String *key, const char closing);
+static size_t write_skip_whitespace(const char *text, size_t position, const size_t end);
+static size_t write_skip_whitespace_back(const char *text, size_t position);
+static bool write_is_whitespace(const char c);
+static size_t write_key_lexeme(const Node *child, const String *source, size_t *start, size_t *quoted);
+static size_t write_children(const Node *node);
+static const Node *write_child(const Node *node, const size_t index, const String **key);
+static size_t write_size(const Node *node, const String *source);
+static size_t write_size_string(const String *string);
+static size_t write_find_escape(const char *buffer, const size_t length);
+static void write_node(Writer *writer, const Node *node);
+static void write_string(Writer *writer, const String *string);
+static void write_number(Writer *writer, const double *number);
+static void write_append(Writer *writer, const char *buffer, const size_t length);
+static bool write_reserve(Writer *writer, const size_t length);
+static bool write_flush(Writer *writer, const char *extra, const size_t extra_length);
+
+static const char hex_digits[] = "0123456789abcdef";
 
 ResultCode write_to_file(const Node *node, const String *filename)
 {
-    return CODE_NOT_SUPPORTED;
+    return write_file(node, NULL, filename);
+}
+
+ResultCode write_to_fd(const Node *node, const int fd)
+{
+    return write_fd(node, NULL, fd);
 }
 
 String *write_to_string(const Node *node)
 {
-    return NULL;
+    return write_string_all(node, NULL);
+}
+
+ResultCode write_document_to_file(const Document *document, const String *filename)
+{
+    if (document == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    return write_file(document->root, document->source, filename);
+}
+
+String *write_document_to_string(const Document *document)
+{
+    if (document == NULL)
+    {
+        return NULL;
+    }
+    return write_string_all(document->root, document->source);
+}
+
+ResultCode write_to_file_format(const Node *node, const String *filename, const Format format)
+{
+    if (format == FORMAT_JSON)
+    {
+        return write_to_file(node, filename);
+    }
+    String *output = format == FORMAT_CBOR ? write_to_cbor(node) : (format == FORMAT_MSGPACK ? write_to_msgpack(node) : NULL);
+    if (output == NULL)
+    {
+        return node == NULL ? CODE_MEMORY_ERROR : CODE_NOT_SUPPORTED;
+    }
+    ResultCode result = write_buffer_to_file(types_string_c_str(output), types_string_length(output), filename);
+    types_string_free(output);
+    free(output);
+    return result;
+}
+
+ResultCode write_buffer_to_file(const char *buffer, const size_t length, const String *filename)
+{
+    if (buffer == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    String *temporary = NULL;
+    int fd = filename == NULL ? STDOUT_FILENO : write_open_temporary(filename, &temporary);
+    if (fd < 0)
+    {
+        return CODE_WRITE_ERROR;
+    }
+    ResultCode result = CODE_OK;
+    size_t written = 0;
+    while (written < length)
+    {
+        const ssize_t count = write(fd, buffer + written, length - written);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            result = CODE_WRITE_ERROR;
+            break;
+        }
+        written += count;
+    }
+    return filename != NULL ? write_replace(fd, temporary, filename, result) : result;
+}
+
+static ResultCode write_file(const Node *node, const String *source, const String *filename)
+{
+    if (node == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // Without a filename the output goes to the standard output
+    if (filename == NULL)
+    {
+        return write_fd(node, source, STDOUT_FILENO);
+    }
+
+    String *temporary = NULL;
+    int fd = write_open_temporary(filename, &temporary);
+    if (fd < 0)
+    {
+        return CODE_WRITE_ERROR;
+    }
+    return write_replace(fd, temporary, filename, write_fd(node, source, fd));
+}
+
+static int write_open_temporary(const String *filename, String **temporary)
+{
+    // Files are written next to their final name, in the same file system, so they can be
+    // renamed over it. The file keeps the permissions of the one it replaces
+    const String suffix = {".XXXXXX", 7, 8};
+    *temporary = types_string_join(filename, &suffix);
+    if (*temporary == NULL)
+    {
+        return -1;
+    }
+    int fd = mkstemp((*temporary)->buffer);
+    struct stat file_stat;
+    const mode_t mode = stat(types_string_c_str(filename), &file_stat) == 0 ? file_stat.st_mode & 0777 : 0644;
+    if (fd >= 0 && fchmod(fd, mode) != 0)
+    {
+        close(fd);
+        unlink(types_string_c_str(*temporary));
+        fd = -1;
+    }
+    if (fd < 0)
+    {
+        types_string_free(*temporary);
+        free(*temporary);
+        *temporary = NULL;
+    }
+    return fd;
+}
+
+static ResultCode write_replace(const int fd, String *temporary, const String *filename, ResultCode result)
+{
+    // The file only takes the place of the old one once all of it is on disk, so a failure
+    // or a crash at any point leaves either the old file or the new one, never a mix
+    if (result == CODE_OK && fsync(fd) != 0)
+    {
+        result = CODE_WRITE_ERROR;
+    }
+    if (close(fd) != 0 && result == CODE_OK)
+    {
+        result = CODE_WRITE_ERROR;
+    }
+    if (result == CODE_OK && rename(types_string_c_str(temporary), types_string_c_str(filename)) != 0)
+    {
+        result = CODE_WRITE_ERROR;
+    }
+    if (result != CODE_OK)
+    {
+        unlink(types_string_c_str(temporary));
+    }
+    types_string_free(temporary);
+    free(temporary);
+    return result;
+}
+
+static ResultCode write_fd(const Node *node, const String *source, const int fd)
+{
+    if (node == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    if (fd < 0)
+    {
+        return CODE_WRITE_ERROR;
+    }
+
+    // The output goes through a fixed-size buffer, whatever its total size
+    char buffer[WRITE_BUFFER_SIZE];
+    Writer writer;
+    writer.buffer = buffer;
+    writer.length = 0;
+    writer.capacity = WRITE_BUFFER_SIZE;
+    writer.fd = fd;
+    writer.result = CODE_OK;
+    writer.source = source;
+    write_root(&writer, node);
+    if (writer.result == CODE_OK)
+    {
+        write_flush(&writer, NULL, 0);
+    }
+    return writer.result;
+}
+
+static String *write_string_all(const Node *node, const String *source)
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    // First pass: compute the length of the output, so the buffer is reserved only once.
+    // The length is exact except for numbers, which are given their maximum length so
+    // they are formatted a single time
+    const size_t length = write_margin(node, source, true) + write_size(node, source) + write_margin(node, source, false);
+    String *result = types_string_create();
+    if (result == NULL)
+    {
+        return NULL;
+    }
+    if (types_string_reserve(result, length + 1) != CODE_OK)
+    {
+        types_string_free(result);
+        free(result);
+        return NULL;
+    }
+
+    // Second pass: write everything directly into the buffer, which never needs to be flushed
+    Writer writer;
+    writer.buffer = result->buffer;
+    writer.length = 0;
+    writer.capacity = length;
+    writer.fd = -1;
+    writer.result = CODE_OK;
+    writer.source = source;
+    write_root(&writer, node);
+    if (writer.result != CODE_OK)
+    {
+        types_string_free(result);
+        free(result);
+        return NULL;
+    }
+    result->buffer[writer.length] = '\0';
+    result->length = writer.length;
+    return result;
+}
+
+static void write_root(Writer *writer, const Node *node)
+{
+    const size_t before = write_margin(node, writer->source, true);
+    const size_t after = write_margin(node, writer->source, false);
+    if (before > 0)
+    {
+        write_append(writer, types_string_c_str(writer->source), before);
+    }
+    write_node(writer, node);
+    if (after > 0)
+    {
+        write_append(writer, types_string_c_str(writer->source) + node->source_end, after);
+    }
+}
+
+static size_t write_margin(const Node *node, const String *source, const bool before)
+{
+    // The whitespace around the root of a document, such as a final newline, is kept as well
+    if (node->parent != NULL || !write_has_span(node, source))
+    {
+        return 0;
+    }
+    return before ? node->source_start : types_string_length(source) - node->source_end;
+}
+
+static bool write_is_verbatim(const Node *node, const String *source)
+{
+    // A node is copied from the text it was read from when nothing in it has changed since
+    return node_is_clean(node) && write_has_span(node, source);
+}
+
+static bool write_has_span(const Node *node, const String *source)
+{
+    return source != NULL && node->source_end > node->source_start && node->source_end <= types_string_length(source);
+}
+
+static size_t write_gap(const String *source, const size_t start, const size_t end,
+                        const char opening, const String *key, const char closing)
+{
+    // The text of the source between two nodes of a container can be copied instead of the
+    // punctuation it stands for: some whitespace, the opening bracket or the comma, the key and
+    // its colon, and the closing bracket. Anything else in between, such as a child that has
+    // been erased since, means the text cannot be used. Returns the length of the text, or 0
+    if (start == WRITE_NO_SPAN || end == WRITE_NO_SPAN || start > end)
+    {
+        return 0;
+    }
+    const char *text = types_string_c_str(source);
+    size_t position = write_skip_whitespace(text, start, end);
+    if (opening != '\0')
+    {
+        if (position == end || text[position] != opening)
+        {
+            return 0;
+        }
+        position = write_skip_whitespace(text, position + 1, end);
+    }
+    if (key != NULL)
+    {
+        // The key in the source has to be the same, and written without escape sequences
+        const size_t length = types_string_length(key);
+        if (write_find_escape(types_string_c_str(key), length) != length || end - position < length + 2 ||
+            text[position] != '\"' || memcmp(text + position + 1, types_string_c_str(key), length) != 0 ||
+            text[position + length + 1] != '\"')
+        {
+            return 0;
+        }
+        position = write_skip_whitespace(text, position + length + 2, end);
+        if (position == end || text[position] != ':')
+        {
+            return 0;
+        }
+        position = write_skip_whitespace(text, position + 1, end);
+    }
+    if (closing != '\0')
+    {
+        if (position == end || text[position] != closing)
+        {
+            return 0;
+        }
+        position += 1;
+    }
+    return position == end ? end - start : 0;
+}
+
+static size_t write_skip_whitespace(const char *text, size_t position, const size_t end)
+{
+    while (position < end && write_is_whitespace(text[position]))
+    {
+        position += 1;
+    }
+    return position;
+}
+
+static size_t write_skip_whitespace_back(const char *text, size_t position)
+{
+    while (position > 0 && write_is_whitespace(text[position - 1]))
+    {
+        position -= 1;
+    }
+    return position;
+}
+
+static bool write_is_whitespace(const char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+static size_t write_key_lexeme(const Node *child, const String *source, size_t *start, size_t *quoted)
+{
+    // The key of an object member is read right before its value: the quoted key, whitespace,
+    // a colon and more whitespace. Returns the length of all that text up to the value, or 0 if it
+    // cannot be used, and the length of the quoted key alone, which a renamed key replaces
+    if (!write_has_span(child, source))
+    {
+        return 0;
+    }
+    const char *text = types_string_c_str(source);
+    size_t position = child->source_start;
+    position = write_skip_whitespace_back(text, position);
+    if (position == 0 || text[position - 1] != ':')
+    {
+        return 0;
+    }
+    position -= 1;
+    position = write_skip_whitespace_back(text, position);
+    if (position == 0 || text[position - 1] != '\"')
+    {
+        return 0;
+    }
+    const size_t end = position;
+    // The opening quote is the first one found backwards that is not escaped,
+    // that is, preceded by an even number of reverse solidus
+    position -= 1;
+    while (position > 0)
+    {
+        position -= 1;
+        if (text[position] != '\"')
+        {
+            continue;
+        }
+        size_t reverse_solidus = 0;
+        while (reverse_solidus < position && text[position - reverse_solidus - 1] == '\\')
+        {
+            reverse_solidus += 1;
+        }
+        if (reverse_solidus % 2 == 0)
+        {
+            *start = position;
+            *quoted = end - position;
+            return child->source_start - position;
+        }
+    }
+    return 0;
+}
+
+static size_t write_children(const Node *node)
+{
+    return node->type == NODE_TYPE_ARRAY ? node_array_size((Node *)node) : types_map_size(node->data);
+}
+
+static const Node *write_child(const Node *node, const size_t index, const String **key)
+{
+    if (node->type == NODE_TYPE_ARRAY)
+    {
+        *key = NULL;
+        return node_array_get((Node *)node, index);
+    }
+    const Pair *pair = types_vector_at(((Map *)node->data)->elements, index);
+    *key = pair->key;
+    return pair->value;
+}
+
+static size_t write_size(const Node *node, const String *source)
+{
+    if (write_is_verbatim(node, source))
+    {
+        return node->source_end - node->source_start;
+    }
+
+    switch (node->type)
+    {
+    case NODE_TYPE_NULL:
+        return strlen("null");
+    case NODE_TYPE_TRUE:
+        return strlen("true");
+    case NODE_TYPE_FALSE:
+        return strlen("false");
+    case NODE_TYPE_NUMBER:
+        return WRITE_NUMBER_MAX_LENGTH;
+    case NODE_TYPE_STRING:
+        return write_size_string(node->data);
+    case NODE_TYPE_ARRAY:
+    case NODE_TYPE_OBJECT:
+    {
+        // Brackets, one comma between each pair of children, and the keys with their colons.
+        // The same choices between source text and punctuation are made as when writing
+        const char opening = node->type == NODE_TYPE_ARRAY ? '[' : '{';
+        const char closing = node->type == NODE_TYPE_ARRAY ? ']' : '}';
+        const size_t size = write_children(node);
+        size_t previous = write_has_span(node, source) ? node->source_start : WRITE_NO_SPAN;
+        size_t length = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            const String *key;
+            const Node *child = write_child(node, i, &key);
+            const bool spanned = write_has_span(child, source);
+            const size_t gap = write_gap(source, previous, spanned ? child->source_start : WRITE_NO_SPAN,
+                                         i == 0 ? opening : ',', key, '\0');
+            if (gap > 0)
+            {
+                length += gap;
+            }
+            else
+            {
+                size_t key_start;
+                size_t quoted;
+                const size_t key_length = key != NULL ? write_key_lexeme(child, source, &key_start, &quoted) : 0;
+                const size_t before = key_length > 0 ? write_gap(source, previous, key_start, i == 0 ? opening : ',', NULL, '\0') : 0;
+                length += before > 0 ? before : 1;
+                if (key_length > 0)
+                {
+                    length += (child->key_dirty ? write_size_string(key) : quoted) + key_length - quoted;
+                }
+                else if (key != NULL)
+                {
+                    length += write_size_string(key) + 1;
+                }
+            }
+            length += write_size(child, source);
+            previous = spanned ? child->source_end : WRITE_NO_SPAN;
+        }
+        const size_t gap = write_gap(source, previous, write_has_span(node, source) ? node->source_end : WRITE_NO_SPAN,
+                                     size == 0 ? opening : '\0', NULL, closing);
+        return length + (gap > 0 ? gap : (size == 0 ? 2 : 1));
+    }
+    }
+    return 0;
+}
+
+static size_t write_size_string(const String *string)
+{
+    // Quotes, plus each character with its escape sequence if it needs one
+    const char *buffer = types_string_c_str(string);
+    const size_t n = types_string_length(string);
+    size_t length = 2 + n;
+    size_t i = write_find_escape(buffer, n);
+    while (i < n)
+    {
+        const unsigned char c = buffer[i];
+        switch (c)
+        {
+        case '\"':
+        case '\\':
+        case '\b':
+        case '\f':
+        case '\n':
+        case '\r':
+        case '\t':
+            length += 1;
+            break;
+        default:
+            length += 5;
+            break;
+        }
+        i += 1;
+        i += write_find_escape(buffer + i, n - i);
+    }
+    return length;
+}
+
+static size_t write_find_escape(const char *buffer, const size_t length)
+{
+    // Index of the first character that needs to be escaped, or length if there is none.
+    // A character needs it if it is a quote, a reverse solidus or below 0x20. Whole blocks
+    // are checked at once where the instruction set allows it, and the tail byte by byte
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i quote_32 = _mm256_set1_epi8('\"');
+    const __m256i reverse_solidus_32 = _mm256_set1_epi8('\\');
+    const __m256i control_32 = _mm256_set1_epi8(0x1F);
+    for (; i + 32 <= length; i += 32)
+    {
+        const __m256i block = _mm256_loadu_si256((const __m256i *)(buffer + i));
+        // max(c, 0x1F) == 0x1F only for the characters up to 0x1F, compared unsigned
+        const __m256i found = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, quote_32), _mm256_cmpeq_epi8(block, reverse_solidus_32)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(block, control_32), control_32));
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(found);
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i quote_16 = _mm_set1_epi8('\"');
+    const __m128i reverse_solidus_16 = _mm_set1_epi8('\\');
+    const __m128i control_16 = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i block = _mm_loadu_si128((const __m128i *)(buffer + i));
+        const __m128i found = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote_16), _mm_cmpeq_epi8(block, reverse_solidus_16)),
+            _mm_cmpeq_epi8(_mm_max_epu8(block, control_16), control_16));
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(found);
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < length; i++)
+    {
+        const unsigned char c = buffer[i];
+        if (c < 0x20 || c == '\"' || c == '\\')
+        {
+            return i;
+        }
+    }
+    return length;
+}
+
+static void write_node(Writer *writer, const Node *node)
+{
+    if (writer->result != CODE_OK)
+    {
+        return;
+    }
+
+    // Unchanged subtrees are copied as they were read. Large spans go straight from the
+    // source text to the file descriptor, without passing through the buffer
+    if (write_is_verbatim(node, writer->source))
+    {
+        write_append(writer, types_string_c_str(writer->source) + node->source_start, node->source_end - node->source_start);
+        return;
+    }
+
+    switch (node->type)
+    {
+    case NODE_TYPE_NULL:
+        write_append(writer, "null", 4);
+        return;
+    case NODE_TYPE_TRUE:
+        write_append(writer, "true", 4);
+        return;
+    case NODE_TYPE_FALSE:
+        write_append(writer, "false", 5);
+        return;
+    case NODE_TYPE_NUMBER:
+        write_number(writer, node->data);
+        return;
+    case NODE_TYPE_STRING:
+        write_string(writer, node->data);
+        return;
+    case NODE_TYPE_ARRAY:
+    case NODE_TYPE_OBJECT:
+    {
+        // The container has changed, but the text between children that are still next to each
+        // other in the source is copied, so the formatting of the untouched parts is kept
+        const String *source = writer->source;
+        const char *text = types_string_c_str(source);
+        const char opening[2] = {node->type == NODE_TYPE_ARRAY ? '[' : '{', '\0'};
+        const char closing[2] = {node->type == NODE_TYPE_ARRAY ? ']' : '}', '\0'};
+        const size_t size = write_children(node);
+        size_t previous = write_has_span(node, source) ? node->source_start : WRITE_NO_SPAN;
+        for (size_t i = 0; i < size; i++)
+        {
+            const String *key;
+            const Node *child = write_child(node, i, &key);
+            const bool spanned = write_has_span(child, source);
+            const size_t gap = write_gap(source, previous, spanned ? child->source_start : WRITE_NO_SPAN,
+                                         i == 0 ? opening[0] : ',', key, '\0');
+            if (gap > 0)
+            {
+                write_append(writer, text + previous, gap);
+            }
+            else
+            {
+                // Keys keep the text around them, and unchanged ones their own text as well,
+                // escape sequences included. A renamed key only replaces the quoted key
+                size_t key_start;
+                size_t quoted;
+                const size_t key_length = key != NULL ? write_key_lexeme(child, source, &key_start, &quoted) : 0;
+                const size_t before = key_length > 0 ? write_gap(source, previous, key_start, i == 0 ? opening[0] : ',', NULL, '\0') : 0;
+                if (before > 0)
+                {
+                    write_append(writer, text + previous, before);
+                }
+                else
+                {
+                    write_append(writer, i == 0 ? opening : ",", 1);
+                }
+                if (key_length > 0)
+                {
+                    if (child->key_dirty)
+                    {
+                        write_string(writer, key);
+                    }
+                    else
+                    {
+                        write_append(writer, text + key_start, quoted);
+                    }
+                    write_append(writer, text + key_start + quoted, key_length - quoted);
+                }
+                else if (key != NULL)
+                {
+                    write_string(writer, key);
+                    write_append(writer, ":", 1);
+                }
+            }
+            write_node(writer, child);
+            previous = spanned ? child->source_end : WRITE_NO_SPAN;
+        }
+        const size_t gap = write_gap(source, previous, write_has_span(node, source) ? node->source_end : WRITE_NO_SPAN,
+                                     size == 0 ? opening[0] : '\0', NULL, closing[0]);
+        if (gap > 0)
+        {
+            write_append(writer, text + previous, gap);
+        }
+        else
+        {
+            if (size == 0)
+            {
+                write_append(writer, opening, 1);
+            }
+            write_append(writer, closing, 1);
+        }
+        return;
+    }
+    }
+}
+
+static void write_string(Writer *writer, const String *string)
+{
+    const char *buffer = types_string_c_str(string);
+    const size_t n = types_string_length(string);
+
+    write_append(writer, "\"", 1);
+    size_t i = 0;
+    while (i < n)
+    {
+        // Copy the whole run of characters that need no escaping at once
+        const size_t run = write_find_escape(buffer + i, n - i);
+        write_append(writer, buffer + i, run);
+        i += run;
+        if (i == n)
+        {
+            break;
+        }
+
+        // Escape the character that stopped the run
+        const unsigned char c = buffer[i];
+        switch (c)
+        {
+        case '\"':
+            write_append(writer, "\\\"", 2);
+            break;
+        case '\\':
+            write_append(writer, "\\\\", 2);
+            break;
+        case '\b':
+            write_append(writer, "\\b", 2);
+            break;
+        case '\f':
+            write_append(writer, "\\f", 2);
+            break;
+        case '\n':
+            write_append(writer, "\\n", 2);
+            break;
+        case '\r':
+            write_append(writer, "\\r", 2);
+            break;
+        case '\t':
+            write_append(writer, "\\t", 2);
+            break;
+        default:
+        {
+            // Any other control character needs the unicode escape
+            const char escape[6] = {'\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0xf]};
+            write_append(writer, escape, 6);
+            break;
+        }
+        }
+        i += 1;
+    }
+    write_append(writer, "\"", 1);
+}
+
+static void write_number(Writer *writer, const double *number)
+{
+    if (number == NULL)
+    {
+        write_append(writer, "null", 4);
+        return;
+    }
+
+    // Format straight into the buffer
+    if (!write_reserve(writer, WRITE_NUMBER_MAX_LENGTH))
+    {
+        return;
+    }
+    writer->length += write_number_double(writer->buffer + writer->length, *number);
+}
+
+static void write_append(Writer *writer, const char *buffer, const size_t length)
+{
+    if (length == 0 || writer->result != CODE_OK)
+    {
+        return;
+    }
+
+    // Small pieces are copied into the buffer
+    if (length <= writer->capacity - writer->length)
+    {
+        memcpy(writer->buffer + writer->length, buffer, length);
+        writer->length += length;
+        return;
+    }
+
+    // Pieces that do not fit are flushed together with the buffer, without copying them
+    if (writer->fd < 0)
+    {
+        writer->result = CODE_MEMORY_ERROR;
+        return;
+    }
+    write_flush(writer, buffer, length);
+}
+
+static bool write_reserve(Writer *writer, const size_t length)
+{
+    if (writer->result != CODE_OK)
+    {
+        return false;
+    }
+    if (length <= writer->capacity - writer->length)
+    {
+        return true;
+    }
+    if (writer->fd < 0)
+    {
+        writer->result = CODE_MEMORY_ERROR;
+        return false;
+    }
+    return write_flush(writer, NULL, 0);
+}
+
+static bool write_flush(Writer *writer, const char *extra, const size_t extra_length)
+{
+    // Send the buffer and the extra piece in as few system calls as possible
+    struct iovec vectors[2];
+    vectors[0].iov_base = writer->buffer;
+    vectors[0].iov_len = writer->length;
+    vectors[1].iov_base = (void *)extra;
+    vectors[1].iov_len = extra_length;
+    struct iovec *current = vectors;
+    int count = extra_length > 0 ? 2 : 1;
+
+    while (count > 0)
+    {
+        // Skip the parts that have been completely written
+        if (current->iov_len == 0)
+        {
+            current += 1;
+            count -= 1;
+            continue;
+        }
+        const ssize_t written = writev(writer->fd, current, count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            writer->result = CODE_WRITE_ERROR;
+            return false;
+        }
+
+        // Account for partial writes
+        size_t remaining = written;
+        while (count > 0 && remaining >= current->iov_len)
+        {
+            remaining -= current->iov_len;
+            current += 1;
+            count -= 1;
+        }
+        if (count > 0)
+        {
+            current->iov_base = (char *)current->iov_base + remaining;
+            current->iov_len -= remaining;
+        }
+    }
+
+    writer->length = 0;
+    return true;
 }
@@ -2,10 +2,78 @@
 #define WRITE_H
 
 #include "node.h"
+#include "document.h"
 #include "utils.h"
 
+/// @brief Serialize a tree of nodes as compact JSON
+/// @param node Root of the tree
+/// @retval String holding the JSON text
+/// @retval NULL if a problem was encountered
 String *write_to_string(const Node *node);
 
+/// @brief Serialize a tree of nodes as compact JSON into a file. The output is streamed
+/// through a fixed-size buffer, so it is never held in memory as a whole. It goes to a temporary
+/// file that is renamed over the old one once complete, so the file is never left half written
+/// @param node Root of the tree
+/// @param filename Name of the file, or NULL to write to the standard output
+/// @return Result code
 ResultCode write_to_file(const Node *node, const String *filename);
 
+/// @brief Serialize a tree of nodes as compact JSON into an open file descriptor. The output
+/// is streamed through a fixed-size buffer. The file descriptor is not closed
+/// @param node Root of the tree
+/// @param fd File descriptor open for writing
+/// @return Result code
+ResultCode write_to_fd(const Node *node, const int fd);
+
+/// @brief Serialize a document as JSON. Nodes that have not changed since the document was
+/// read are copied from its source text, so only the modified parts are formatted again
+/// @param document Document
+/// @retval String holding the JSON text
+/// @retval NULL if a problem was encountered
+String *write_document_to_string(const Document *document);
+
+/// @brief Serialize a document as JSON into a file, copying the unchanged nodes from the
+/// source text of the document. The output is streamed through a fixed-size buffer
+/// @param document Document
+/// @param filename Name of the file, or NULL to write to the standard output
+/// @return Result code
+ResultCode write_document_to_file(const Document *document, const String *filename);
+
+/// @brief Save a tree of nodes as a binary snapshot, which read_snapshot maps back into memory
+/// and which can be queried in place without parsing. See snapshot.h for the layout. Trees
+/// nested deeper than SNAPSHOT_MAX_DEPTH are not supported
+/// @param node Root of the tree
+/// @param filename Name of the file
+/// @return Result code
+ResultCode write_snapshot(const Node *node, const String *filename);
+
+/// @brief Encode a tree of nodes as CBOR (RFC 8949). Containers have definite lengths, integral
+/// numbers are written as integers and the rest as single or double precision floats,
+/// whichever keeps the value
+/// @param node Root of the tree
+/// @retval String holding the encoded bytes, which may include NULL characters
+/// @retval NULL if a problem was encountered
+String *write_to_cbor(const Node *node);
+
+/// @brief Encode a tree of nodes as MessagePack, with the smallest type that holds each value
+/// @param node Root of the tree
+/// @retval String holding the encoded bytes, which may include NULL characters
+/// @retval NULL if a problem was encountered
+String *write_to_msgpack(const Node *node);
+
+/// @brief Serialize a tree of nodes into a file in the given format
+/// @param node Root of the tree
+/// @param filename Name of the file, or NULL to write to the standard output
+/// @param format Format of the output
+/// @return Result code
+ResultCode write_to_file_format(const Node *node, const String *filename, const Format format);
+
+/// @brief Write a buffer into a file, replacing its contents at once through a temporary file
+/// @param buffer Bytes to write
+/// @param length Number of bytes
+/// @param filename Name of the file, or NULL to write to the standard output
+/// @return Result code
+ResultCode write_buffer_to_file(const char *buffer, const size_t length, const String *filename);
+
 #endif
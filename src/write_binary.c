@@ -0,0 +1,330 @@
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "write.h"
+#include "types/types_map.h"
+#include "types/types_vector.h"
+
+// Every encoder below returns the number of bytes of its output. When the output buffer is NULL
+// nothing is written, so the same code computes the exact size first and fills the buffer after
+
+static String *write_binary_all(const Node *node, size_t (*encode)(const Node *, unsigned char *));
+static size_t write_binary_children(const Node *node);
+static const Node *write_binary_child(const Node *node, const size_t index, const String **key);
+static bool write_binary_integer(const double value);
+static size_t write_binary_big_endian(unsigned char *output, const uint64_t value, const size_t bytes);
+static size_t write_cbor_node(const Node *node, unsigned char *output);
+static size_t write_cbor_head(unsigned char *output, const unsigned char major, const uint64_t argument);
+static size_t write_cbor_string(const String *string, unsigned char *output);
+static size_t write_cbor_number(const double value, unsigned char *output);
+static size_t write_msgpack_node(const Node *node, unsigned char *output);
+static size_t write_msgpack_head(unsigned char *output, const unsigned char fix, const unsigned char first, const uint64_t length);
+static size_t write_msgpack_string(const String *string, unsigned char *output);
+static size_t write_msgpack_number(const double value, unsigned char *output);
+
+String *write_to_cbor(const Node *node)
+{
+    return write_binary_all(node, write_cbor_node);
+}
+
+String *write_to_msgpack(const Node *node)
+{
+    return write_binary_all(node, write_msgpack_node);
+}
+
+static String *write_binary_all(const Node *node, size_t (*encode)(const Node *, unsigned char *))
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    // First pass: exact length. Second pass: encode into the reserved buffer
+    const size_t length = encode(node, NULL);
+    if (length >= INT_MAX)
+    {
+        return NULL;
+    }
+    String *result = types_string_create();
+    if (result == NULL)
+    {
+        return NULL;
+    }
+    if (types_string_reserve(result, length + 1) != CODE_OK)
+    {
+        types_string_free(result);
+        free(result);
+        return NULL;
+    }
+    encode(node, (unsigned char *)result->buffer);
+    result->buffer[length] = '\0';
+    result->length = length;
+    return result;
+}
+
+static size_t write_binary_children(const Node *node)
+{
+    if (node->data == NULL)
+    {
+        return 0;
+    }
+    return node->type == NODE_TYPE_ARRAY ? types_vector_size(node->data) : types_map_size(node->data);
+}
+
+static const Node *write_binary_child(const Node *node, const size_t index, const String **key)
+{
+    if (node->type == NODE_TYPE_ARRAY)
+    {
+        *key = NULL;
+        return node_array_get((Node *)node, index);
+    }
+    const Pair *pair = types_vector_at(((Map *)node->data)->elements, index);
+    *key = pair->key;
+    return pair->value;
+}
+
+static bool write_binary_integer(const double value)
+{
+    // Integral values that fit in 64 bits are written as integers, which both formats encode
+    // in fewer bytes. Negative zero is not an integer, or it would read back as zero
+    return value >= -9223372036854775808.0 && value < 18446744073709551616.0 &&
+           value == floor(value) && !(value == 0 && signbit(value));
+}
+
+static size_t write_binary_big_endian(unsigned char *output, const uint64_t value, const size_t bytes)
+{
+    if (output != NULL)
+    {
+        for (size_t i = 0; i < bytes; i++)
+        {
+            output[i] = (unsigned char)(value >> (8 * (bytes - 1 - i)));
+        }
+    }
+    return bytes;
+}
+
+static size_t write_cbor_node(const Node *node, unsigned char *output)
+{
+    switch (node->type)
+    {
+    case NODE_TYPE_NULL:
+        return write_cbor_head(output, 7, 22);
+    case NODE_TYPE_TRUE:
+        return write_cbor_head(output, 7, 21);
+    case NODE_TYPE_FALSE:
+        return write_cbor_head(output, 7, 20);
+    case NODE_TYPE_NUMBER:
+        return write_cbor_number(*(const double *)node->data, output);
+    case NODE_TYPE_STRING:
+        return write_cbor_string(node->data, output);
+    case NODE_TYPE_ARRAY:
+    case NODE_TYPE_OBJECT:
+        break;
+    }
+
+    // Containers always have a definite length
+    const size_t size = write_binary_children(node);
+    size_t length = write_cbor_head(output, node->type == NODE_TYPE_ARRAY ? 4 : 5, size);
+    for (size_t i = 0; i < size; i++)
+    {
+        const String *key;
+        const Node *child = write_binary_child(node, i, &key);
+        if (key != NULL)
+        {
+            length += write_cbor_string(key, output != NULL ? output + length : NULL);
+        }
+        length += write_cbor_node(child, output != NULL ? output + length : NULL);
+    }
+    return length;
+}
+
+static size_t write_cbor_head(unsigned char *output, const unsigned char major, const uint64_t argument)
+{
+    // The argument goes in the first byte when it is small, or in the 1, 2, 4 or 8 bytes after it
+    const size_t bytes = argument < 24 ? 0 : (argument <= UINT8_MAX ? 1 : (argument <= UINT16_MAX ? 2 : (argument <= UINT32_MAX ? 4 : 8)));
+    if (output != NULL)
+    {
+        output[0] = (unsigned char)(major << 5) |
+                    (bytes == 0 ? (unsigned char)argument : (bytes == 1 ? 24 : (bytes == 2 ? 25 : (bytes == 4 ? 26 : 27))));
+    }
+    return 1 + write_binary_big_endian(output != NULL ? output + 1 : NULL, argument, bytes);
+}
+
+static size_t write_cbor_string(const String *string, unsigned char *output)
+{
+    const size_t length = types_string_length(string);
+    const size_t head = write_cbor_head(output, 3, length);
+    if (output != NULL)
+    {
+        memcpy(output + head, types_string_c_str(string), length);
+    }
+    return head + length;
+}
+
+static size_t write_cbor_number(const double value, unsigned char *output)
+{
+    if (write_binary_integer(value))
+    {
+        if (value >= 0)
+        {
+            return write_cbor_head(output, 0, (uint64_t)value);
+        }
+        const int64_t integer = (int64_t)value;
+        return write_cbor_head(output, 1, (uint64_t)(-(integer + 1)));
+    }
+
+    // Single precision when nothing is lost, double precision otherwise
+    uint64_t bits;
+    const float single = (float)value;
+    if ((double)single == value)
+    {
+        uint32_t single_bits;
+        memcpy(&single_bits, &single, sizeof(single_bits));
+        if (output != NULL)
+        {
+            output[0] = 0xfa;
+        }
+        return 1 + write_binary_big_endian(output != NULL ? output + 1 : NULL, single_bits, 4);
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    if (output != NULL)
+    {
+        output[0] = 0xfb;
+    }
+    return 1 + write_binary_big_endian(output != NULL ? output + 1 : NULL, bits, 8);
+}
+
+static size_t write_msgpack_node(const Node *node, unsigned char *output)
+{
+    switch (node->type)
+    {
+    case NODE_TYPE_NULL:
+    case NODE_TYPE_TRUE:
+    case NODE_TYPE_FALSE:
+        if (output != NULL)
+        {
+            output[0] = node->type == NODE_TYPE_NULL ? 0xc0 : (node->type == NODE_TYPE_TRUE ? 0xc3 : 0xc2);
+        }
+        return 1;
+    case NODE_TYPE_NUMBER:
+        return write_msgpack_number(*(const double *)node->data, output);
+    case NODE_TYPE_STRING:
+        return write_msgpack_string(node->data, output);
+    case NODE_TYPE_ARRAY:
+    case NODE_TYPE_OBJECT:
+        break;
+    }
+
+    const size_t size = write_binary_children(node);
+    size_t length = node->type == NODE_TYPE_ARRAY ? write_msgpack_head(output, 0x90, 0xdc, size)
+                                                  : write_msgpack_head(output, 0x80, 0xde, size);
+    for (size_t i = 0; i < size; i++)
+    {
+        const String *key;
+        const Node *child = write_binary_child(node, i, &key);
+        if (key != NULL)
+        {
+            length += write_msgpack_string(key, output != NULL ? output + length : NULL);
+        }
+        length += write_msgpack_node(child, output != NULL ? output + length : NULL);
+    }
+    return length;
+}
+
+static size_t write_msgpack_head(unsigned char *output, const unsigned char fix, const unsigned char first, const uint64_t length)
+{
+    // Containers: a fix type up to 15 elements, then 16 and 32 bit lengths.
+    // Strings: a fix type up to 31 bytes, then 8, 16 and 32 bit lengths
+    const uint64_t fix_limit = fix == 0xa0 ? 32 : 16;
+    if (length < fix_limit)
+    {
+        if (output != NULL)
+        {
+            output[0] = fix | (unsigned char)length;
+        }
+        return 1;
+    }
+    const size_t bytes = fix == 0xa0 && length <= UINT8_MAX ? 1 : (length <= UINT16_MAX ? 2 : 4);
+    if (output != NULL)
+    {
+        output[0] = first + (fix == 0xa0 ? (bytes == 1 ? 0 : (bytes == 2 ? 1 : 2)) : (bytes == 2 ? 0 : 1));
+    }
+    return 1 + write_binary_big_endian(output != NULL ? output + 1 : NULL, length, bytes);
+}
+
+static size_t write_msgpack_string(const String *string, unsigned char *output)
+{
+    const size_t length = types_string_length(string);
+    const size_t head = write_msgpack_head(output, 0xa0, 0xd9, length);
+    if (output != NULL)
+    {
+        memcpy(output + head, types_string_c_str(string), length);
+    }
+    return head + length;
+}
+
+static size_t write_msgpack_number(const double value, unsigned char *output)
+{
+    if (write_binary_integer(value))
+    {
+        // Fix integers, then the smallest of the unsigned or signed types
+        if (value >= 0 && value < 128)
+        {
+            if (output != NULL)
+            {
+                output[0] = (unsigned char)value;
+            }
+            return 1;
+        }
+        if (value < 0 && value >= -32)
+        {
+            if (output != NULL)
+            {
+                output[0] = (unsigned char)(int8_t)value;
+            }
+            return 1;
+        }
+        unsigned char first;
+        size_t bytes;
+        uint64_t bits;
+        if (value >= 0)
+        {
+            bits = (uint64_t)value;
+            bytes = bits <= UINT8_MAX ? 1 : (bits <= UINT16_MAX ? 2 : (bits <= UINT32_MAX ? 4 : 8));
+            first = bytes == 1 ? 0xcc : (bytes == 2 ? 0xcd : (bytes == 4 ? 0xce : 0xcf));
+        }
+        else
+        {
+            const int64_t integer = (int64_t)value;
+            bits = (uint64_t)integer;
+            bytes = integer >= INT8_MIN ? 1 : (integer >= INT16_MIN ? 2 : (integer >= INT32_MIN ? 4 : 8));
+            first = bytes == 1 ? 0xd0 : (bytes == 2 ? 0xd1 : (bytes == 4 ? 0xd2 : 0xd3));
+        }
+        if (output != NULL)
+        {
+            output[0] = first;
+        }
+        return 1 + write_binary_big_endian(output != NULL ? output + 1 : NULL, bits, bytes);
+    }
+
+    const float single = (float)value;
+    if ((double)single == value)
+    {
+        uint32_t single_bits;
+        memcpy(&single_bits, &single, sizeof(single_bits));
+        if (output != NULL)
+        {
+            output[0] = 0xca;
+        }
+        return 1 + write_binary_big_endian(output != NULL ? output + 1 : NULL, single_bits, 4);
+    }
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (output != NULL)
+    {
+        output[0] = 0xcb;
+    }
+    return 1 + write_binary_big_endian(output != NULL ? output + 1 : NULL, bits, 8);
+}
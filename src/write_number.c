@@ -0,0 +1,419 @@
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "write_number.h"
+
+// Shortest round-trip formatting of doubles with the Grisu2 algorithm, described in
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers" (Loitsch, 2010).
+// The value is scaled by a cached power of ten so that its digits can be generated with
+// 64 bit integer arithmetic, and the digits stop as soon as they identify the value
+
+/// @brief Floating point number with a 64 bit significand: f * 2^e
+typedef struct DiyFp_st
+{
+    uint64_t f;
+    int e;
+} DiyFp;
+
+/// @brief Normalized approximation of a power of ten: f * 2^e ~= 10^k
+typedef struct CachedPower_st
+{
+    uint64_t f;
+    int e;
+    int k;
+} CachedPower;
+
+// Binary exponent range the scaled values need to fall into
+#define WRITE_NUMBER_ALPHA -60
+#define WRITE_NUMBER_GAMMA -32
+
+// Cached powers of ten, from 10^-300 to 10^324 in steps of 8
+#define WRITE_NUMBER_CACHED_POWERS_LENGTH 79
+#define WRITE_NUMBER_CACHED_POWERS_MIN_EXPONENT -300
+#define WRITE_NUMBER_CACHED_POWERS_STEP 8
+static const CachedPower cached_powers[WRITE_NUMBER_CACHED_POWERS_LENGTH] = {
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C, -980, -276},
+    {0xD3515C2831559A83, -954, -268},
+    {0x9D71AC8FADA6C9B5, -927, -260},
+    {0xEA9C227723EE8BCB, -901, -252},
+    {0xAECC49914078536D, -874, -244},
+    {0x823C12795DB6CE57, -847, -236},
+    {0xC21094364DFB5637, -821, -228},
+    {0x9096EA6F3848984F, -794, -220},
+    {0xD77485CB25823AC7, -768, -212},
+    {0xA086CFCD97BF97F4, -741, -204},
+    {0xEF340A98172AACE5, -715, -196},
+    {0xB23867FB2A35B28E, -688, -188},
+    {0x84C8D4DFD2C63F3B, -661, -180},
+    {0xC5DD44271AD3CDBA, -635, -172},
+    {0x936B9FCEBB25C996, -608, -164},
+    {0xDBAC6C247D62A584, -582, -156},
+    {0xA3AB66580D5FDAF6, -555, -148},
+    {0xF3E2F893DEC3F126, -529, -140},
+    {0xB5B5ADA8AAFF80B8, -502, -132},
+    {0x87625F056C7C4A8B, -475, -124},
+    {0xC9BCFF6034C13053, -449, -116},
+    {0x964E858C91BA2655, -422, -108},
+    {0xDFF9772470297EBD, -396, -100},
+    {0xA6DFBD9FB8E5B88F, -369, -92},
+    {0xF8A95FCF88747D94, -343, -84},
+    {0xB94470938FA89BCF, -316, -76},
+    {0x8A08F0F8BF0F156B, -289, -68},
+    {0xCDB02555653131B6, -263, -60},
+    {0x993FE2C6D07B7FAC, -236, -52},
+    {0xE45C10C42A2B3B06, -210, -44},
+    {0xAA242499697392D3, -183, -36},
+    {0xFD87B5F28300CA0E, -157, -28},
+    {0xBCE5086492111AEB, -130, -20},
+    {0x8CBCCC096F5088CC, -103, -12},
+    {0xD1B71758E219652C, -77, -4},
+    {0x9C40000000000000, -50, 4},
+    {0xE8D4A51000000000, -24, 12},
+    {0xAD78EBC5AC620000, 3, 20},
+    {0x813F3978F8940984, 30, 28},
+    {0xC097CE7BC90715B3, 56, 36},
+    {0x8F7E32CE7BEA5C70, 83, 44},
+    {0xD5D238A4ABE98068, 109, 52},
+    {0x9F4F2726179A2245, 136, 60},
+    {0xED63A231D4C4FB27, 162, 68},
+    {0xB0DE65388CC8ADA8, 189, 76},
+    {0x83C7088E1AAB65DB, 216, 84},
+    {0xC45D1DF942711D9A, 242, 92},
+    {0x924D692CA61BE758, 269, 100},
+    {0xDA01EE641A708DEA, 295, 108},
+    {0xA26DA3999AEF774A, 322, 116},
+    {0xF209787BB47D6B85, 348, 124},
+    {0xB454E4A179DD1877, 375, 132},
+    {0x865B86925B9BC5C2, 402, 140},
+    {0xC83553C5C8965D3D, 428, 148},
+    {0x952AB45CFA97A0B3, 455, 156},
+    {0xDE469FBD99A05FE3, 481, 164},
+    {0xA59BC234DB398C25, 508, 172},
+    {0xF6C69A72A3989F5C, 534, 180},
+    {0xB7DCBF5354E9BECE, 561, 188},
+    {0x88FCF317F22241E2, 588, 196},
+    {0xCC20CE9BD35C78A5, 614, 204},
+    {0x98165AF37B2153DF, 641, 212},
+    {0xE2A0B5DC971F303A, 667, 220},
+    {0xA8D9D1535CE3B396, 694, 228},
+    {0xFB9B7CD9A4A7443C, 720, 236},
+    {0xBB764C4CA7A44410, 747, 244},
+    {0x8BAB8EEFB6409C1A, 774, 252},
+    {0xD01FEF10A657842C, 800, 260},
+    {0x9B10A4E5E9913129, 827, 268},
+    {0xE7109BFBA19C0C9D, 853, 276},
+    {0xAC2820D9623BF429, 880, 284},
+    {0x80444B5E7AA7CF85, 907, 292},
+    {0xBF21E44003ACDD2D, 933, 300},
+    {0x8E679C2F5E44FF8F, 960, 308},
+    {0xD433179D9C8CB841, 986, 316},
+    {0x9E19DB92B4E31BA9, 1013, 324},
+};
+
+// Decimal exponents outside this range use the scientific notation
+#define WRITE_NUMBER_MIN_EXPONENT -4
+#define WRITE_NUMBER_MAX_EXPONENT 15
+
+// All the pairs of digits from 00 to 99, to write integers two digits at a time
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static DiyFp write_number_diyfp(const uint64_t f, const int e)
+{
+    DiyFp result;
+    result.f = f;
+    result.e = e;
+    return result;
+}
+
+static DiyFp write_number_multiply(const DiyFp x, const DiyFp y)
+{
+    // Upper 64 bits of the 128 bit product, rounded
+    const uint64_t x_lo = x.f & 0xFFFFFFFFu;
+    const uint64_t x_hi = x.f >> 32;
+    const uint64_t y_lo = y.f & 0xFFFFFFFFu;
+    const uint64_t y_hi = y.f >> 32;
+    const uint64_t p0 = x_lo * y_lo;
+    const uint64_t p1 = x_lo * y_hi;
+    const uint64_t p2 = x_hi * y_lo;
+    const uint64_t p3 = x_hi * y_hi;
+    uint64_t middle = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+    middle += 1u << 31;
+    return write_number_diyfp(p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32), x.e + y.e + 64);
+}
+
+static DiyFp write_number_normalize(DiyFp x)
+{
+    while ((x.f >> 63) == 0)
+    {
+        x.f <<= 1;
+        x.e -= 1;
+    }
+    return x;
+}
+
+static size_t write_number_largest_power_of_ten(const uint32_t n, uint32_t *power)
+{
+    // Number of digits of n and the power of ten of its first digit
+    uint32_t value = 1000000000;
+    size_t digits = 10;
+    while (digits > 1 && n < value)
+    {
+        value /= 10;
+        digits -= 1;
+    }
+    *power = value;
+    return digits;
+}
+
+static void write_number_round(char *buffer, const size_t length, const uint64_t distance,
+                               const uint64_t delta, uint64_t rest, const uint64_t ten_k)
+{
+    // Move the last digit down while the result gets closer to the exact value
+    // and stays inside the rounding interval
+    while (rest < distance && delta - rest >= ten_k &&
+           (rest + ten_k < distance || distance - rest > rest + ten_k - distance))
+    {
+        buffer[length - 1] -= 1;
+        rest += ten_k;
+    }
+}
+
+static size_t write_number_generate_digits(char *buffer, int *decimal_exponent,
+                                           const DiyFp low, const DiyFp w, const DiyFp high)
+{
+    uint64_t delta = high.f - low.f;
+    uint64_t distance = high.f - w.f;
+
+    // Split the upper boundary into integral and fractional parts
+    const DiyFp one = write_number_diyfp((uint64_t)1 << -high.e, high.e);
+    uint32_t integral = (uint32_t)(high.f >> -one.e);
+    uint64_t fractional = high.f & (one.f - 1);
+
+    // Digits of the integral part
+    size_t length = 0;
+    uint32_t power;
+    size_t digits = write_number_largest_power_of_ten(integral, &power);
+    while (digits > 0)
+    {
+        const uint32_t digit = integral / power;
+        integral %= power;
+        buffer[length++] = (char)('0' + digit);
+        digits -= 1;
+
+        const uint64_t rest = ((uint64_t)integral << -one.e) + fractional;
+        if (rest <= delta)
+        {
+            *decimal_exponent += digits;
+            write_number_round(buffer, length, distance, delta, rest, (uint64_t)power << -one.e);
+            return length;
+        }
+        power /= 10;
+    }
+
+    // Digits of the fractional part
+    int fractional_digits = 0;
+    while (true)
+    {
+        fractional *= 10;
+        buffer[length++] = (char)('0' + (fractional >> -one.e));
+        fractional &= one.f - 1;
+        fractional_digits += 1;
+        delta *= 10;
+        distance *= 10;
+        if (fractional <= delta)
+        {
+            break;
+        }
+    }
+    *decimal_exponent -= fractional_digits;
+    write_number_round(buffer, length, distance, delta, fractional, one.f);
+    return length;
+}
+
+static size_t write_number_grisu2(char *buffer, int *decimal_exponent, const double value)
+{
+    // Decompose the (positive) value
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t hidden_bit = (uint64_t)1 << 52;
+    const uint64_t significand = bits & (hidden_bit - 1);
+    const int exponent = (int)(bits >> 52);
+    const DiyFp v = exponent == 0 ? write_number_diyfp(significand, 1 - 1075)
+                                  : write_number_diyfp(significand + hidden_bit, exponent - 1075);
+
+    // Boundaries of the interval of numbers that read back as the value. The lower one
+    // is closer when the significand is a power of two
+    const DiyFp high = write_number_normalize(write_number_diyfp(2 * v.f + 1, v.e - 1));
+    DiyFp low = significand == 0 && exponent > 1 ? write_number_diyfp(4 * v.f - 1, v.e - 2)
+                                                 : write_number_diyfp(2 * v.f - 1, v.e - 1);
+    low = write_number_diyfp(low.f << (low.e - high.e), high.e);
+    const DiyFp w = write_number_normalize(v);
+
+    // Choose the cached power that moves the exponent into [alpha, gamma]
+    const int f = WRITE_NUMBER_ALPHA - high.e - 1;
+    const int k = (f * 78913) / (1 << 18) + (f > 0);
+    const int index = (-WRITE_NUMBER_CACHED_POWERS_MIN_EXPONENT + k + (WRITE_NUMBER_CACHED_POWERS_STEP - 1)) /
+                      WRITE_NUMBER_CACHED_POWERS_STEP;
+    const CachedPower cached = cached_powers[index];
+    const DiyFp power = write_number_diyfp(cached.f, cached.e);
+
+    // Scale, leaving a safety margin of one unit on each side
+    const DiyFp scaled_w = write_number_multiply(w, power);
+    DiyFp scaled_low = write_number_multiply(low, power);
+    DiyFp scaled_high = write_number_multiply(high, power);
+    scaled_low.f += 1;
+    scaled_high.f -= 1;
+
+    *decimal_exponent = -cached.k;
+    return write_number_generate_digits(buffer, decimal_exponent, scaled_low, scaled_w, scaled_high);
+}
+
+static size_t write_number_exponent(char *buffer, int exponent)
+{
+    size_t length = 0;
+    buffer[length++] = 'e';
+    if (exponent < 0)
+    {
+        buffer[length++] = '-';
+        exponent = -exponent;
+    }
+    if (exponent >= 100)
+    {
+        buffer[length++] = (char)('0' + exponent / 100);
+        exponent %= 100;
+        memcpy(buffer + length, digit_pairs + 2 * exponent, 2);
+        return length + 2;
+    }
+    if (exponent >= 10)
+    {
+        memcpy(buffer + length, digit_pairs + 2 * exponent, 2);
+        return length + 2;
+    }
+    buffer[length++] = (char)('0' + exponent);
+    return length;
+}
+
+static size_t write_number_place_point(char *buffer, const size_t length, const int decimal_exponent)
+{
+    // The digits are d1...dn and the value is d1...dn * 10^decimal_exponent.
+    // point is the position of the decimal point counted from the first digit
+    const int digits = (int)length;
+    const int point = digits + decimal_exponent;
+
+    if (digits <= point && point <= WRITE_NUMBER_MAX_EXPONENT)
+    {
+        // Integer: d1...dn000
+        memset(buffer + digits, '0', point - digits);
+        return point;
+    }
+    if (0 < point && point <= WRITE_NUMBER_MAX_EXPONENT)
+    {
+        // Point inside the digits: d1.d2...dn
+        memmove(buffer + point + 1, buffer + point, digits - point);
+        buffer[point] = '.';
+        return digits + 1;
+    }
+    if (WRITE_NUMBER_MIN_EXPONENT < point && point <= 0)
+    {
+        // Small number: 0.000d1...dn
+        memmove(buffer + 2 - point, buffer, digits);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        memset(buffer + 2, '0', -point);
+        return 2 - point + digits;
+    }
+
+    // Scientific notation: d1.d2...dne-x
+    size_t result = 1;
+    if (digits > 1)
+    {
+        memmove(buffer + 2, buffer + 1, digits - 1);
+        buffer[1] = '.';
+        result = digits + 1;
+    }
+    return result + write_number_exponent(buffer + result, point - 1);
+}
+
+size_t write_number_integer(char *buffer, const int64_t value)
+{
+    // Work with the magnitude, which does not overflow for the minimum value
+    uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+    size_t length = 0;
+    if (value < 0)
+    {
+        buffer[length++] = '-';
+    }
+
+    // Write backwards from the end of a scratch area, two digits at a time
+    char digits[20];
+    size_t position = sizeof(digits);
+    while (magnitude >= 100)
+    {
+        const size_t pair = (size_t)(magnitude % 100) * 2;
+        magnitude /= 100;
+        position -= 2;
+        memcpy(digits + position, digit_pairs + pair, 2);
+    }
+    if (magnitude >= 10)
+    {
+        position -= 2;
+        memcpy(digits + position, digit_pairs + magnitude * 2, 2);
+    }
+    else
+    {
+        digits[--position] = (char)('0' + magnitude);
+    }
+
+    memcpy(buffer + length, digits + position, sizeof(digits) - position);
+    return length + sizeof(digits) - position;
+}
+
+size_t write_number_double(char *buffer, const double value)
+{
+    // JSON has no representation for these
+    if (isnan(value) || isinf(value))
+    {
+        memcpy(buffer, "null", 4);
+        return 4;
+    }
+
+    // Integers that a double represents exactly take the fast path
+    if (value == 0)
+    {
+        if (signbit(value))
+        {
+            memcpy(buffer, "-0", 2);
+            return 2;
+        }
+        buffer[0] = '0';
+        return 1;
+    }
+    if (fabs(value) < 9007199254740992.0 && value == (double)(int64_t)value)
+    {
+        return write_number_integer(buffer, (int64_t)value);
+    }
+
+    // Everything else goes through Grisu2
+    size_t length = 0;
+    if (value < 0)
+    {
+        buffer[length++] = '-';
+    }
+    int decimal_exponent;
+    const size_t digits = write_number_grisu2(buffer + length, &decimal_exponent, fabs(value));
+    return length + write_number_place_point(buffer + length, digits, decimal_exponent);
+}
@@ -0,0 +1,24 @@
+#ifndef WRITE_NUMBER_H
+#define WRITE_NUMBER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Number of bytes that a buffer needs to hold any formatted number
+#define WRITE_NUMBER_MAX_LENGTH 32
+
+/// @brief Write the shortest representation of a double that reads back as the same value.
+/// Integral values are written without fraction or exponent. Values that JSON cannot
+/// represent (infinities and NaN) are written as null
+/// @param buffer Buffer of at least WRITE_NUMBER_MAX_LENGTH bytes. It is not NULL-terminated
+/// @param value Number to write
+/// @return Number of characters written
+size_t write_number_double(char *buffer, const double value);
+
+/// @brief Write an integer in base ten
+/// @param buffer Buffer of at least WRITE_NUMBER_MAX_LENGTH bytes. It is not NULL-terminated
+/// @param value Number to write
+/// @return Number of characters written
+size_t write_number_integer(char *buffer, const int64_t value);
+
+#endif
@@ -0,0 +1,245 @@
+#include <string.h>
+
+#include "write.h"
+#include "snapshot.h"
+#include "types/types_map.h"
+#include "types/types_vector.h"
+
+/// @brief State of the snapshot writer. The snapshot is laid out in a single buffer of the
+/// exact size: the header, then the blocks of values, then the string table
+typedef struct SnapshotWriter_st
+{
+    char *buffer;
+    size_t values;  // Offset of the next free byte for values
+    size_t strings; // Offset of the next free byte in the string table, from the start of the table
+    size_t strings_start;
+} SnapshotWriter;
+
+/// @brief Key of a member, together with its position, used to sort the members of an object
+typedef struct SnapshotKey_st
+{
+    const String *key;
+    uint32_t index;
+} SnapshotKey;
+
+static ResultCode write_snapshot_size(const Node *node, const size_t depth, size_t *values, size_t *strings);
+static size_t write_snapshot_block(const NodeType type, const size_t length);
+static size_t write_snapshot_length(const Node *node);
+static ResultCode write_snapshot_value(SnapshotWriter *writer, const Node *node, SnapshotValue *value);
+static uint64_t write_snapshot_text(SnapshotWriter *writer, const String *string);
+static int write_snapshot_compare(const void *key1, const void *key2);
+
+ResultCode write_snapshot(const Node *node, const String *filename)
+{
+    if (node == NULL || filename == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+
+    // First pass: measure the values and the strings, so the snapshot is allocated once
+    size_t values = sizeof(SnapshotHeader) + sizeof(SnapshotValue);
+    size_t strings = 0;
+    ResultCode result = write_snapshot_size(node, 0, &values, &strings);
+    if (result != CODE_OK)
+    {
+        return result;
+    }
+    const size_t size = values + strings;
+    SnapshotWriter writer;
+    writer.buffer = calloc(1, size);
+    if (writer.buffer == NULL)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    writer.values = sizeof(SnapshotHeader) + sizeof(SnapshotValue);
+    writer.strings = 0;
+    writer.strings_start = values;
+
+    // Second pass: fill the header, the root and everything below it
+    SnapshotHeader *header = (SnapshotHeader *)writer.buffer;
+    memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->version = SNAPSHOT_VERSION;
+    header->byte_order = SNAPSHOT_BYTE_ORDER;
+    header->size = size;
+    header->root = sizeof(SnapshotHeader);
+    header->strings = values;
+    header->strings_size = strings;
+    result = write_snapshot_value(&writer, node, (SnapshotValue *)(writer.buffer + header->root));
+
+    // The file is written in one go
+    if (result == CODE_OK)
+    {
+        result = write_buffer_to_file(writer.buffer, size, filename);
+    }
+    free(writer.buffer);
+    return result;
+}
+
+static ResultCode write_snapshot_size(const Node *node, const size_t depth, size_t *values, size_t *strings)
+{
+    switch (node->type)
+    {
+    case NODE_TYPE_NULL:
+    case NODE_TYPE_TRUE:
+    case NODE_TYPE_FALSE:
+    case NODE_TYPE_NUMBER:
+        return CODE_OK;
+    case NODE_TYPE_STRING:
+        *strings += types_string_length(node->data) + 1;
+        return CODE_OK;
+    case NODE_TYPE_ARRAY:
+    case NODE_TYPE_OBJECT:
+    {
+        // Nothing is written that snapshot_to_node would refuse to read
+        const size_t length = write_snapshot_length(node);
+        if (length > UINT32_MAX || depth >= SNAPSHOT_MAX_DEPTH)
+        {
+            return CODE_NOT_SUPPORTED;
+        }
+        *values += write_snapshot_block(node->type, length);
+        for (size_t i = 0; i < length; i++)
+        {
+            const Node *child;
+            if (node->type == NODE_TYPE_ARRAY)
+            {
+                child = node_array_get((Node *)node, i);
+            }
+            else
+            {
+                const Pair *pair = types_vector_at(((Map *)node->data)->elements, i);
+                *strings += types_string_length(pair->key) + 1;
+                child = pair->value;
+            }
+            ResultCode result = write_snapshot_size(child, depth + 1, values, strings);
+            if (result != CODE_OK)
+            {
+                return result;
+            }
+        }
+        return CODE_OK;
+    }
+    }
+    return CODE_NOT_SUPPORTED;
+}
+
+static size_t write_snapshot_block(const NodeType type, const size_t length)
+{
+    // Objects keep their sorted index after the members, padded so the next block stays aligned
+    if (type == NODE_TYPE_ARRAY)
+    {
+        return length * sizeof(SnapshotValue);
+    }
+    const size_t index = length * sizeof(uint32_t);
+    return length * sizeof(SnapshotMember) + (index + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+}
+
+static size_t write_snapshot_length(const Node *node)
+{
+    if (node->data == NULL)
+    {
+        return 0;
+    }
+    return node->type == NODE_TYPE_ARRAY ? types_vector_size(node->data) : types_map_size(node->data);
+}
+
+static ResultCode write_snapshot_value(SnapshotWriter *writer, const Node *node, SnapshotValue *value)
+{
+    value->type = node->type;
+    value->length = 0;
+    value->data.offset = 0;
+    switch (node->type)
+    {
+    case NODE_TYPE_NULL:
+    case NODE_TYPE_TRUE:
+    case NODE_TYPE_FALSE:
+        return CODE_OK;
+    case NODE_TYPE_NUMBER:
+        value->data.number = *(const double *)node->data;
+        return CODE_OK;
+    case NODE_TYPE_STRING:
+        value->length = types_string_length(node->data);
+        value->data.offset = write_snapshot_text(writer, node->data);
+        return CODE_OK;
+    case NODE_TYPE_ARRAY:
+    case NODE_TYPE_OBJECT:
+        break;
+    }
+
+    // The block of children is claimed before going down, so each child has its slot
+    const size_t length = write_snapshot_length(node);
+    value->length = length;
+    value->data.offset = writer->values;
+    writer->values += write_snapshot_block(node->type, length);
+    if (node->type == NODE_TYPE_ARRAY)
+    {
+        SnapshotValue *children = (SnapshotValue *)(writer->buffer + value->data.offset);
+        for (size_t i = 0; i < length; i++)
+        {
+            ResultCode result = write_snapshot_value(writer, node_array_get((Node *)node, i), &children[i]);
+            if (result != CODE_OK)
+            {
+                return result;
+            }
+        }
+        return CODE_OK;
+    }
+
+    SnapshotMember *members = (SnapshotMember *)(writer->buffer + value->data.offset);
+    SnapshotKey *keys = malloc(length * sizeof(SnapshotKey));
+    if (keys == NULL && length > 0)
+    {
+        return CODE_MEMORY_ERROR;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        const Pair *pair = types_vector_at(((Map *)node->data)->elements, i);
+        members[i].key_length = types_string_length(pair->key);
+        members[i].key = write_snapshot_text(writer, pair->key);
+        keys[i].key = pair->key;
+        keys[i].index = i;
+        ResultCode result = write_snapshot_value(writer, pair->value, &members[i].value);
+        if (result != CODE_OK)
+        {
+            free(keys);
+            return result;
+        }
+    }
+
+    // Index of the members sorted by key, for lookups in place
+    if (length > 0)
+    {
+        qsort(keys, length, sizeof(SnapshotKey), write_snapshot_compare);
+    }
+    uint32_t *sorted = (uint32_t *)(members + length);
+    for (size_t i = 0; i < length; i++)
+    {
+        sorted[i] = keys[i].index;
+    }
+    free(keys);
+    return CODE_OK;
+}
+
+static uint64_t write_snapshot_text(SnapshotWriter *writer, const String *string)
+{
+    // The buffer was zeroed, so the text is already NULL-terminated
+    const uint64_t offset = writer->strings;
+    const size_t length = types_string_length(string);
+    memcpy(writer->buffer + writer->strings_start + offset, types_string_c_str(string), length);
+    writer->strings += length + 1;
+    return offset;
+}
+
+static int write_snapshot_compare(const void *key1, const void *key2)
+{
+    const SnapshotKey *first = key1;
+    const SnapshotKey *second = key2;
+    const int comparison = snapshot_compare_key(types_string_c_str(first->key), types_string_length(first->key),
+                                                types_string_c_str(second->key), types_string_length(second->key));
+    if (comparison != 0)
+    {
+        return comparison;
+    }
+
+    // Repeated keys keep their order, so the sort is stable
+    return first->index < second->index ? -1 : (first->index > second->index ? 1 : 0);
+}
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "types/types_string.h"
+#include "types/types_vector.h"
+#include "read/read.h"
+#include "write.h"
+#include "node.h"
+
+// The test runner is linked with `-Wl,--wrap=malloc` and the like, so every call to the
+// allocator made by the library, or by the tests, goes through the functions below first
+
+/// @brief Calls to the allocator and bytes asked for, between the start and the end of a measure
+typedef struct TestAllocations_st
+{
+    size_t allocations; // Calls to malloc, calloc, and realloc
+    size_t frees;       // Calls to free with a block
+    size_t bytes;       // Bytes asked for by all the allocations
+} TestAllocations;
+
+static atomic_bool test_allocations_counting;
+static atomic_size_t test_allocations_calls;
+static atomic_size_t test_allocations_frees;
+static atomic_size_t test_allocations_bytes;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+void __real_free(void *pointer);
+
+static void test_allocations_count(const size_t bytes)
+{
+    if (atomic_load(&test_allocations_counting))
+    {
+        atomic_fetch_add(&test_allocations_calls, 1);
+        atomic_fetch_add(&test_allocations_bytes, bytes);
+    }
+}
+
+void *__wrap_malloc(size_t size)
+{
+    test_allocations_count(size);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    test_allocations_count(count * size);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    test_allocations_count(size);
+    return __real_realloc(pointer, size);
+}
+
+void __wrap_free(void *pointer)
+{
+    if (pointer != NULL && atomic_load(&test_allocations_counting))
+    {
+        atomic_fetch_add(&test_allocations_frees, 1);
+    }
+    __real_free(pointer);
+}
+
+/// @brief Start counting the calls to the allocator from zero
+static void test_allocations_start(void)
+{
+    atomic_store(&test_allocations_calls, 0);
+    atomic_store(&test_allocations_frees, 0);
+    atomic_store(&test_allocations_bytes, 0);
+    atomic_store(&test_allocations_counting, true);
+}
+
+/// @brief Stop counting the calls to the allocator
+/// @return Calls counted since test_allocations_start
+static TestAllocations test_allocations_stop(void)
+{
+    atomic_store(&test_allocations_counting, false);
+    return (TestAllocations){atomic_load(&test_allocations_calls), atomic_load(&test_allocations_frees),
+                             atomic_load(&test_allocations_bytes)};
+}
+
+static String *test_allocations_array(const size_t elements)
+{
+    String *text = types_string_create_from_literal("[");
+    char element[32];
+    for (size_t i = 0; i < elements; i++)
+    {
+        snprintf(element, sizeof(element), "%s%zu", i == 0 ? "" : ",", i);
+        types_string_join_in_place(text, &(String){element, strlen(element), sizeof(element)});
+    }
+    types_string_join_in_place(text, &(String){"]", 1, 2});
+    return text;
+}
+
+static ResultCode test_allocations_free_nothing(void *element)
+{
+    return CODE_OK;
+}
+
+static void test_allocations_budget(void **state)
+{
+    // Reading an array of 1000 numbers
+    String *text = test_allocations_array(1000);
+    test_allocations_start();
+    Node *root = read_from_string(text);
+    TestAllocations read = test_allocations_stop();
+    assert_non_null(root);
+    // The tokens, then a node and its data for each number
+    assert_true(read.allocations <= 2 * 1000 + 32);
+    assert_true(read.frees <= 8);
+
+    // Writing it back
+    test_allocations_start();
+    String *written = write_to_string(root);
+    TestAllocations write = test_allocations_stop();
+    assert_non_null(written);
+    // A single buffer, grown a few times
+    assert_true(write.allocations <= 16);
+
+    // Pushing 1000 elements
+    test_allocations_start();
+    Vector *vector = types_vector_create(sizeof(size_t), test_allocations_free_nothing);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        assert_int_equal(types_vector_push(vector, &i), CODE_OK);
+    }
+    TestAllocations push = test_allocations_stop();
+    // The vector, then a growth each time the capacity doubles
+    assert_true(push.allocations <= 16);
+    assert_int_equal(push.frees, 0);
+    assert_true(push.bytes <= 4 * 1000 * sizeof(size_t) + 256);
+
+    types_vector_free(vector);
+    free(vector);
+    types_string_free(written);
+    free(written);
+    node_destroy(root);
+    types_string_free(text);
+    free(text);
+}
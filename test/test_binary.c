@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "read/read.h"
+#include "write.h"
+
+// Turn a string of hexadecimal digits into the bytes it spells
+static String *test_binary_bytes(const char *hex)
+{
+    const size_t length = strlen(hex) / 2;
+    char *bytes = malloc(length + 1);
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned int byte;
+        sscanf(hex + 2 * i, "%2x", &byte);
+        bytes[i] = (char)byte;
+    }
+    String *string = types_string_create_from_buffer(bytes, length);
+    free(bytes);
+    return string;
+}
+
+// Encode a JSON text and compare with the expected bytes, then decode them back
+static void test_binary_check(const char *text, const char *hex,
+                              String *(*encode)(const Node *), Node *(*decode)(const String *))
+{
+    String *string = types_string_create_from_literal(text);
+    Node *node = read_from_string(string);
+    assert_ptr_not_equal(node, NULL);
+    String *encoded = encode(node);
+    assert_ptr_not_equal(encoded, NULL);
+    String *expected = test_binary_bytes(hex);
+    assert_int_equal(types_string_length(encoded), types_string_length(expected));
+    assert_memory_equal(types_string_c_str(encoded), types_string_c_str(expected), types_string_length(expected));
+
+    Node *decoded = decode(encoded);
+    assert_ptr_not_equal(decoded, NULL);
+    String *output = write_to_string(decoded);
+    assert_string_equal(types_string_c_str(output), text);
+
+    types_string_free(output);
+    free(output);
+    node_destroy(decoded);
+    types_string_free(expected);
+    free(expected);
+    types_string_free(encoded);
+    free(encoded);
+    node_destroy(node);
+    types_string_free(string);
+    free(string);
+}
+
+// Decode some bytes and compare with the JSON text expected, or with NULL if they are not valid
+static void test_binary_decode(const char *hex, const char *text, Node *(*decode)(const String *))
+{
+    String *bytes = test_binary_bytes(hex);
+    Node *node = decode(bytes);
+    if (text == NULL)
+    {
+        assert_ptr_equal(node, NULL);
+    }
+    else
+    {
+        assert_ptr_not_equal(node, NULL);
+        String *output = write_to_string(node);
+        assert_string_equal(types_string_c_str(output), text);
+        types_string_free(output);
+        free(output);
+        node_destroy(node);
+    }
+    types_string_free(bytes);
+    free(bytes);
+}
+
+static void test_binary_cbor(void **state)
+{
+    // Examples from appendix A of RFC 8949
+    test_binary_check("0", "00", write_to_cbor, read_from_cbor);
+    test_binary_check("23", "17", write_to_cbor, read_from_cbor);
+    test_binary_check("24", "1818", write_to_cbor, read_from_cbor);
+    test_binary_check("1000", "1903e8", write_to_cbor, read_from_cbor);
+    test_binary_check("1000000000000", "1b000000e8d4a51000", write_to_cbor, read_from_cbor);
+    test_binary_check("-1", "20", write_to_cbor, read_from_cbor);
+    test_binary_check("-1000", "3903e7", write_to_cbor, read_from_cbor);
+    test_binary_check("1.5", "fa3fc00000", write_to_cbor, read_from_cbor);
+    test_binary_check("1.1", "fb3ff199999999999a", write_to_cbor, read_from_cbor);
+    test_binary_check("[false,true,null]", "83f4f5f6", write_to_cbor, read_from_cbor);
+    test_binary_check("\"\xc3\xbc\"", "62c3bc", write_to_cbor, read_from_cbor);
+    test_binary_check("{\"a\":1,\"b\":[2,3]}", "a26161016162820203", write_to_cbor, read_from_cbor);
+
+    // Forms the encoder does not produce
+    test_binary_decode("f93e00", "1.5", read_from_cbor);
+    test_binary_decode("f98000", "-0", read_from_cbor);
+    test_binary_decode("f97c00", "null", read_from_cbor);
+    test_binary_decode("f7", "null", read_from_cbor);
+    test_binary_decode("c11a514b67b0", "1363896240", read_from_cbor);
+    test_binary_decode("9f018202039f0405ffff", "[1,[2,3],[4,5]]", read_from_cbor);
+    test_binary_decode("bf6346756ef563416d7421ff", "{\"Fun\":true,\"Amt\":-2}", read_from_cbor);
+    test_binary_decode("7f657374726561646d696e67ff", "\"streaming\"", read_from_cbor);
+
+    // Invalid, or without a JSON equivalent
+    test_binary_decode("", NULL, read_from_cbor);
+    test_binary_decode("1903", NULL, read_from_cbor);
+    test_binary_decode("0000", NULL, read_from_cbor);
+    test_binary_decode("4161", NULL, read_from_cbor);
+    test_binary_decode("a10102", NULL, read_from_cbor);
+    test_binary_decode("9b00000000ffffffff", NULL, read_from_cbor);
+    test_binary_decode("9f01", NULL, read_from_cbor);
+    test_binary_decode("ff", NULL, read_from_cbor);
+}
+
+static void test_binary_msgpack(void **state)
+{
+    test_binary_check("127", "7f", write_to_msgpack, read_from_msgpack);
+    test_binary_check("128", "cc80", write_to_msgpack, read_from_msgpack);
+    test_binary_check("65536", "ce00010000", write_to_msgpack, read_from_msgpack);
+    test_binary_check("-1", "ff", write_to_msgpack, read_from_msgpack);
+    test_binary_check("-33", "d0df", write_to_msgpack, read_from_msgpack);
+    test_binary_check("-40000", "d2ffff63c0", write_to_msgpack, read_from_msgpack);
+    test_binary_check("1.5", "ca3fc00000", write_to_msgpack, read_from_msgpack);
+    test_binary_check("-0", "ca80000000", write_to_msgpack, read_from_msgpack);
+    test_binary_check("[false,true,null]", "93c2c3c0", write_to_msgpack, read_from_msgpack);
+    test_binary_check("{\"a\":[1]}", "81a1619101", write_to_msgpack, read_from_msgpack);
+    test_binary_check("\"abcdefghijklmnopqrstuvwxyz012345\"",
+                      "d9206162636465666768696a6b6c6d6e6f707172737475767778797a303132333435",
+                      write_to_msgpack, read_from_msgpack);
+
+    // Wider forms than needed are accepted
+    test_binary_decode("d3ffffffffffffffff", "-1", read_from_msgpack);
+    test_binary_decode("dc0001da000161", "[\"a\"]", read_from_msgpack);
+    test_binary_decode("df00000001a16101", "{\"a\":1}", read_from_msgpack);
+
+    // Invalid, or without a JSON equivalent
+    test_binary_decode("cd01", NULL, read_from_msgpack);
+    test_binary_decode("c40161", NULL, read_from_msgpack);
+    test_binary_decode("d40100", NULL, read_from_msgpack);
+    test_binary_decode("810101", NULL, read_from_msgpack);
+    test_binary_decode("c1", NULL, read_from_msgpack);
+    test_binary_decode("9101", "[1]", read_from_msgpack);
+    test_binary_decode("910101", NULL, read_from_msgpack);
+}
+
+static void test_binary_round_trip(void **state)
+{
+    // The same tree goes through both formats
+    const char *text = "{\"name\":\"wizard\",\"list\":[0,-5,3.25,1e300,-2.5e-8,9007199254740993,\"\",\"long text "
+                       "that needs more than thirty one bytes\"],\"nested\":{\"a\":{\"b\":[[],{}]}},\"t\":true}";
+    String *string = types_string_create_from_literal(text);
+    Node *node = read_from_string(string);
+    String *expected = write_to_string(node);
+    String *encoded[2] = {write_to_cbor(node), write_to_msgpack(node)};
+    Node *decoded[2] = {read_from_cbor(encoded[0]), read_from_msgpack(encoded[1])};
+    for (size_t i = 0; i < 2; i++)
+    {
+        assert_ptr_not_equal(decoded[i], NULL);
+        assert_true(types_string_length(encoded[i]) < types_string_length(expected));
+        String *output = write_to_string(decoded[i]);
+        assert_string_equal(types_string_c_str(output), types_string_c_str(expected));
+        types_string_free(output);
+        free(output);
+        node_destroy(decoded[i]);
+        types_string_free(encoded[i]);
+        free(encoded[i]);
+    }
+    types_string_free(expected);
+    free(expected);
+    node_destroy(node);
+    types_string_free(string);
+    free(string);
+}
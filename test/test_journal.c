@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "journal.h"
+
+// Joins every record replayed, one per line
+static ResultCode test_journal_collect(void *lines, const String *record)
+{
+    ResultCode result = types_string_join_in_place(lines, record);
+    return result == CODE_OK ? types_string_join_in_place(lines, &(String){"\n", 1, 2}) : result;
+}
+
+static void test_journal_expect(const String *filename, const String *base, const char *expected)
+{
+    Journal *journal = journal_open(filename, base);
+    assert_non_null(journal);
+    String *lines = types_string_create();
+    assert_int_equal(journal_replay(journal, test_journal_collect, lines), CODE_OK);
+    assert_string_equal(types_string_c_str(lines), expected);
+    types_string_free(lines);
+    free(lines);
+    assert_int_equal(journal_close(journal), CODE_OK);
+}
+
+static void test_journal_replay(void **state)
+{
+    char name[64];
+    char path[80];
+    snprintf(name, sizeof(name), "/tmp/test_journal_%ld.json", (long)getpid());
+    snprintf(path, sizeof(path), "%s" JOURNAL_SUFFIX, name);
+    String *filename = types_string_create_from_literal(name);
+    String *base = types_string_create_from_literal("{\"a\": 1}");
+    unlink(path);
+
+    // Records come back in the order they were appended
+    Journal *journal = journal_open(filename, base);
+    assert_non_null(journal);
+    assert_int_equal(journal->size, JOURNAL_HEADER_SIZE);
+    assert_int_equal(journal_append(journal, &(String){"set $.a 2", 9, 10}), CODE_OK);
+    assert_int_equal(journal_append(journal, &(String){"erase $.b", 9, 10}), CODE_OK);
+    assert_int_equal(journal->size, JOURNAL_HEADER_SIZE + 2 * (JOURNAL_RECORD_HEADER_SIZE + 9));
+    assert_int_equal(journal_close(journal), CODE_OK);
+    test_journal_expect(filename, base, "set $.a 2\nerase $.b\n");
+
+    // A record cut short is left out, and removed so later records follow the whole ones
+    FILE *file = fopen(path, "ab");
+    assert_non_null(file);
+    fwrite("\x09\0\0\0\1\2\3\4set", 1, 11, file);
+    fclose(file);
+    test_journal_expect(filename, base, "set $.a 2\nerase $.b\n");
+    journal = journal_open(filename, base);
+    assert_int_equal(journal->size, JOURNAL_HEADER_SIZE + 2 * (JOURNAL_RECORD_HEADER_SIZE + 9));
+    assert_int_equal(journal_close(journal), CODE_OK);
+
+    // Once the file is written again, the journal no longer applies to it
+    String *compacted = types_string_create_from_literal("{\"a\": 2}");
+    test_journal_expect(filename, compacted, "");
+    test_journal_expect(filename, base, "");
+
+    // Reset to a new text, the journal starts empty and takes new records
+    journal = journal_open(filename, base);
+    assert_int_equal(journal_append(journal, &(String){"set $.a 3", 9, 10}), CODE_OK);
+    assert_int_equal(journal_reset(journal, compacted), CODE_OK);
+    assert_int_equal(journal_append(journal, &(String){"set $.a 4", 9, 10}), CODE_OK);
+    assert_int_equal(journal_close(journal), CODE_OK);
+    test_journal_expect(filename, compacted, "set $.a 4\n");
+
+    unlink(path);
+    types_string_free(compacted);
+    free(compacted);
+    types_string_free(base);
+    free(base);
+    types_string_free(filename);
+    free(filename);
+}
@@ -0,0 +1,499 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "json_path.h"
+#include "json_filter.h"
+#include "read/read.h"
+#include "document.h"
+#include "write.h"
+
+// Compile a path, which must be valid and stand for the given number of paths
+static JsonPath *test_json_path_compile(const char *text, const size_t paths)
+{
+    String *string = types_string_create_from_literal(text);
+    JsonPath *path = json_path_parse(string);
+    types_string_free(string);
+    free(string);
+    assert_ptr_not_equal(path, NULL);
+    assert_true(path->valid);
+    assert_int_equal(types_vector_size(path->paths), paths);
+    return path;
+}
+
+static void test_json_path_release(JsonPath *path)
+{
+    assert_int_equal(json_path_free(path), CODE_OK);
+    free(path);
+}
+
+// The nodes found belong to the tree, so there is nothing to free
+static ResultCode test_json_path_free_node(void *node)
+{
+    return CODE_OK;
+}
+
+static void test_json_path_parse(void **state)
+{
+    // Names and indexes become steps, and keys carry their hash
+    JsonPath *path = test_json_path_compile("$.store.book[12]", 1);
+    const Vector *steps = types_vector_at(path->paths, 0);
+    assert_int_equal(types_vector_size(steps), 3);
+    const PathStep *step = types_vector_at(steps, 1);
+    assert_int_equal(step->id, PATH_STEP_KEY);
+    assert_string_equal(types_string_c_str(&step->data.key), "book");
+    assert_int_equal(step->hash, types_string_hash(&step->data.key));
+    step = types_vector_at(steps, 2);
+    assert_int_equal(step->id, PATH_STEP_INDEX);
+    assert_int_equal(step->data.index, 12);
+    assert_string_equal(types_string_c_str(path->original), "$.store.book[12]");
+    test_json_path_release(path);
+
+    // Unions expand into every combination, the last one changing fastest
+    path = test_json_path_compile("$['a', \"b\"][0,1]", 4);
+    const char *keys[] = {"a", "a", "b", "b"};
+    for (size_t i = 0; i < 4; i++)
+    {
+        steps = types_vector_at(path->paths, i);
+        assert_string_equal(types_string_c_str(&((PathStep *)types_vector_at(steps, 0))->data.key), keys[i]);
+        assert_int_equal(((PathStep *)types_vector_at(steps, 1))->data.index, i % 2);
+    }
+    test_json_path_release(path);
+
+    // Quoted keys may hold any character
+    path = test_json_path_compile("$['it\\'s [a].b']", 1);
+    step = types_vector_at(types_vector_at(path->paths, 0), 0);
+    assert_string_equal(types_string_c_str(&step->data.key), "it's [a].b");
+    test_json_path_release(path);
+
+    // Wildcards and descendants
+    path = test_json_path_compile("$..book[*].*..['price',*]", 2);
+    steps = types_vector_at(path->paths, 1);
+    const enum PathStepId ids[] = {PATH_STEP_DESCENDANT, PATH_STEP_WILDCARD, PATH_STEP_WILDCARD, PATH_STEP_DESCENDANTS};
+    for (size_t i = 0; i < 4; i++)
+    {
+        assert_int_equal(((PathStep *)types_vector_at(steps, i))->id, ids[i]);
+    }
+    step = types_vector_at(steps, 0);
+    assert_string_equal(types_string_c_str(&step->data.key), "book");
+    assert_int_equal(step->hash, types_string_hash(&step->data.key));
+    test_json_path_release(path);
+
+    // The root alone
+    path = test_json_path_compile("$", 1);
+    assert_int_equal(types_vector_size(types_vector_at(path->paths, 0)), 0);
+    test_json_path_release(path);
+
+    // Invalid syntax
+    const char *invalid[] = {"", "a", "$.", "$..", "$[", "$[]", "$[a]", "$['x'", "$[-1]", "$[1,]", "$.a b", "$...a", "$..[0]", "$[**]",
+                             "$[99999999999]", "$[0,1,2,3,4,5][0,1,2,3,4,5][0,1,2,3,4,5][0,1,2,3,4,5][0,1,2,3,4,5]"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        String *string = types_string_create_from_literal(invalid[i]);
+        path = json_path_parse(string);
+        assert_ptr_not_equal(path, NULL);
+        assert_false(path->valid);
+        assert_int_equal(types_vector_size(path->paths), 0);
+        test_json_path_release(path);
+        types_string_free(string);
+        free(string);
+    }
+}
+
+static void test_json_path_evaluate(void **state)
+{
+    // The same compiled path runs over many documents
+    JsonPath *path = test_json_path_compile("$.items[1].name", 1);
+    const Vector *steps = types_vector_at(path->paths, 0);
+    char text[128];
+    for (size_t i = 0; i < 100; i++)
+    {
+        snprintf(text, sizeof(text), "{\"id\":%zu,\"items\":[{\"name\":\"first\"},{\"name\":\"item %zu\"}]}", i, i);
+        String *string = types_string_create_from_literal(text);
+        Node *root = read_from_string(string);
+        Node *found = json_path_evaluate(root, steps);
+        assert_ptr_not_equal(found, NULL);
+        snprintf(text, sizeof(text), "item %zu", i);
+        assert_string_equal(types_string_c_str(found->data), text);
+        node_destroy(root);
+        types_string_free(string);
+        free(string);
+    }
+    test_json_path_release(path);
+
+    // Paths that do not lead anywhere
+    String *string = types_string_create_from_literal("{\"a\":[1],\"k\\u0000\":2}");
+    Node *root = read_from_string(string);
+    const char *missing[] = {"$.b", "$.a[1]", "$.a.b", "$[0]", "$['k']"};
+    for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++)
+    {
+        path = test_json_path_compile(missing[i], 1);
+        assert_ptr_equal(json_path_evaluate(root, types_vector_at(path->paths, 0)), NULL);
+        test_json_path_release(path);
+    }
+
+    // Renamed keys are found by their new hash
+    assert_int_equal(node_set_key(node_get(root, &(String){"a", 1, 2}), &(String){"renamed", 7, 8}), CODE_OK);
+    path = test_json_path_compile("$.renamed[0]", 1);
+    Node *found = json_path_evaluate(root, types_vector_at(path->paths, 0));
+    assert_ptr_not_equal(found, NULL);
+    assert_true(*(double *)found->data == 1);
+    test_json_path_release(path);
+
+    node_destroy(root);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_json_path_trie(void **state)
+{
+    // Shared prefixes become a single branch of the trie, and repeated selectors a single path
+    JsonPath *path = test_json_path_compile("$.a.b['x','y','x'][0,1]", 4);
+    PathTrie *trie = json_path_trie_create(path);
+    assert_ptr_not_equal(trie, NULL);
+    assert_false(trie->end);
+    const PathTrie *branch = trie;
+    for (size_t i = 0; i < 2; i++)
+    {
+        assert_int_equal(types_vector_size(branch->children), 1);
+        branch = types_vector_at(branch->children, 0);
+        assert_false(branch->end);
+    }
+    assert_int_equal(types_vector_size(branch->children), 2);
+    branch = types_vector_at(branch->children, 1);
+    assert_string_equal(types_string_c_str(&branch->step.data.key), "y");
+    assert_int_equal(types_vector_size(branch->children), 2);
+    assert_true(((PathTrie *)types_vector_at(branch->children, 1))->end);
+
+    // The nodes are found in the order of the paths
+    String *string = types_string_create_from_literal("{\"a\":{\"b\":{\"x\":[1,2,3],\"y\":[4,5]}}}");
+    Node *root = read_from_string(string);
+    Vector *nodes = types_vector_create(sizeof(Node *), test_json_path_free_node);
+    assert_int_equal(json_path_trie_evaluate(root, trie, false, nodes), CODE_OK);
+    assert_int_equal(types_vector_size(nodes), 4);
+    for (size_t i = 0; i < 4; i++)
+    {
+        const double expected[] = {1, 2, 4, 5};
+        assert_true(*(double *)(*(Node **)types_vector_at(nodes, i))->data == expected[i]);
+    }
+    json_path_trie_free(trie);
+    free(trie);
+    test_json_path_release(path);
+
+    // A missing step is an error unless nodes can be created, and then only at the end of arrays
+    path = test_json_path_compile("$.a.b['y','z'][2]", 2);
+    trie = json_path_trie_create(path);
+    types_vector_clear(nodes);
+    assert_int_equal(json_path_trie_evaluate(root, trie, false, nodes), CODE_LOGIC_ERROR);
+    types_vector_clear(nodes);
+    assert_int_equal(json_path_trie_evaluate(root, trie, true, nodes), CODE_LOGIC_ERROR);
+    json_path_trie_free(trie);
+    free(trie);
+    test_json_path_release(path);
+
+    path = test_json_path_compile("$.a['b','c']", 2);
+    trie = json_path_trie_create(path);
+    types_vector_clear(nodes);
+    assert_int_equal(json_path_trie_evaluate(root, trie, true, nodes), CODE_OK);
+    assert_int_equal(types_vector_size(nodes), 2);
+    assert_int_equal((*(Node **)types_vector_at(nodes, 1))->type, NODE_TYPE_NULL);
+    assert_ptr_equal(node_get(node_get(root, &(String){"a", 1, 2}), &(String){"c", 1, 2}), *(Node **)types_vector_at(nodes, 1));
+    json_path_trie_free(trie);
+    free(trie);
+    test_json_path_release(path);
+
+    // Several missing steps are created at once, as the containers the next steps need
+    path = test_json_path_compile("$.n.m[0].k", 1);
+    trie = json_path_trie_create(path);
+    types_vector_clear(nodes);
+    assert_int_equal(json_path_trie_evaluate(root, trie, true, nodes), CODE_OK);
+    assert_int_equal(types_vector_size(nodes), 1);
+    Node *n = node_get(root, &(String){"n", 1, 2});
+    assert_int_equal(n->type, NODE_TYPE_OBJECT);
+    Node *m = node_get(n, &(String){"m", 1, 2});
+    assert_int_equal(m->type, NODE_TYPE_ARRAY);
+    assert_int_equal(node_array_get(m, 0)->type, NODE_TYPE_OBJECT);
+    assert_ptr_equal(node_get(node_array_get(m, 0), &(String){"k", 1, 2}), *(Node **)types_vector_at(nodes, 0));
+    assert_int_equal((*(Node **)types_vector_at(nodes, 0))->type, NODE_TYPE_NULL);
+    json_path_trie_free(trie);
+    free(trie);
+    test_json_path_release(path);
+
+    types_vector_free(nodes);
+    free(nodes);
+    node_destroy(root);
+    types_string_free(string);
+    free(string);
+}
+
+// Find the nodes at the end of a path, through a trie, as the commands do
+static Vector *test_json_path_find(Node *root, const char *text, const size_t paths)
+{
+    JsonPath *path = test_json_path_compile(text, paths);
+    PathTrie *trie = json_path_trie_create(path);
+    Vector *nodes = types_vector_create(sizeof(Node *), test_json_path_free_node);
+    assert_int_equal(json_path_trie_evaluate(root, trie, false, nodes), CODE_OK);
+    json_path_trie_free(trie);
+    free(trie);
+    test_json_path_release(path);
+    return nodes;
+}
+
+// Compare the nodes found by a path with the texts expected for them, in any order
+static void test_json_path_expect(Node *root, const char *text, const char **expected, const size_t count)
+{
+    Vector *nodes = test_json_path_find(root, text, 1);
+    assert_int_equal(types_vector_size(nodes), count);
+    bool *seen = calloc(count + 1, sizeof(bool));
+    for (size_t i = 0; i < count; i++)
+    {
+        String *written = write_to_string(*(Node **)types_vector_at(nodes, i));
+        size_t j = 0;
+        while (j < count && (seen[j] || strcmp(types_string_c_str(written), expected[j]) != 0))
+        {
+            j++;
+        }
+        assert_true(j < count);
+        seen[j] = true;
+        types_string_free(written);
+        free(written);
+    }
+    free(seen);
+    types_vector_free(nodes);
+    free(nodes);
+}
+
+static void test_json_path_descendant(void **state)
+{
+    String *string = types_string_create_from_literal(
+        "{\"store\":{\"book\":[{\"price\":8,\"tags\":[\"a\"]},{\"price\":12,\"info\":{\"price\":1}}],"
+        "\"bicycle\":{\"price\":20}},\"price\":{\"price\":0}}");
+    Document *document = document_create(read_from_string(string), NULL);
+
+    // The same answers are found by walking the tree and through the index
+    for (size_t indexed = 0; indexed < 2; indexed++)
+    {
+        if (indexed)
+        {
+            assert_int_equal(document_index(document), CODE_OK);
+        }
+        Node *root = document->root;
+        test_json_path_expect(root, "$..price", (const char *[]){"8", "12", "1", "20", "{\"price\":0}", "0"}, 6);
+        test_json_path_expect(root, "$.store..price", (const char *[]){"8", "12", "1", "20"}, 4);
+        test_json_path_expect(root, "$.store.book[*].price", (const char *[]){"8", "12"}, 2);
+        test_json_path_expect(root, "$.store.*", (const char *[]){"{\"price\":20}",
+            "[{\"price\":8,\"tags\":[\"a\"]},{\"price\":12,\"info\":{\"price\":1}}]"}, 2);
+        test_json_path_expect(root, "$..book..tags[0]", (const char *[]){"\"a\""}, 1);
+        test_json_path_expect(root, "$.store.book[1]..*", (const char *[]){"12", "{\"price\":1}", "1"}, 3);
+        test_json_path_expect(root, "$..missing", NULL, 0);
+
+        // A node found through several paths is found once, and after its ancestors
+        Vector *nodes = test_json_path_find(root, "$..price..price", 1);
+        assert_int_equal(types_vector_size(nodes), 1);
+        types_vector_free(nodes);
+        free(nodes);
+        nodes = test_json_path_find(root, "$['price',*]..*", 2);
+        assert_int_equal(types_vector_size(nodes), 12);
+        for (size_t i = 1; i < types_vector_size(nodes); i++)
+        {
+            for (const Node *ancestor = *(Node **)types_vector_at(nodes, i); ancestor != NULL; ancestor = ancestor->parent)
+            {
+                for (size_t j = i + 1; j < types_vector_size(nodes); j++)
+                {
+                    assert_ptr_not_equal(*(Node **)types_vector_at(nodes, j), ancestor);
+                }
+            }
+        }
+        types_vector_free(nodes);
+        free(nodes);
+    }
+    document_free(document);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_json_path_filter(void **state)
+{
+    String *string = types_string_create_from_literal(
+        "{\"files\":[{\"name\":\"a\",\"status\":\"active\",\"size\":2048,\"tags\":[\"x\"]},"
+        "{\"size\":4096,\"status\":\"active\",\"name\":\"b\"},"
+        "{\"name\":\"c\",\"status\":\"deleted\",\"size\":8192,\"hidden\":true},"
+        "{\"name\":\"d\",\"status\":\"active\",\"size\":10,\"hidden\":false},"
+        "{\"name\":\"e\",\"status\":\"active\",\"owner\":null},7],"
+        "\"sizes\":{\"small\":1,\"large\":5000}}");
+    Node *root = read_from_string(string);
+
+    // Comparisons and logical operators, with keys found in any order
+    test_json_path_expect(root, "$.files[?(@.status == \"active\" && @.size > 1024)].name",
+                          (const char *[]){"\"a\"", "\"b\""}, 2);
+    test_json_path_expect(root, "$.files[?(@.size <= 10 || @.status != 'active')].name",
+                          (const char *[]){"\"c\"", "\"d\""}, 2);
+    test_json_path_expect(root, "$.files[?(!(@.size >= 2048) && @.name)].name",
+                          (const char *[]){"\"d\"", "\"e\""}, 2);
+
+    // A node alone is true unless missing, false or null
+    test_json_path_expect(root, "$.files[?(@.hidden)].name", (const char *[]){"\"c\""}, 1);
+    test_json_path_expect(root, "$.files[?(@.owner == null)].name", (const char *[]){"\"e\""}, 1);
+    test_json_path_expect(root, "$.files[?(@.tags[0] == 'x')].size", (const char *[]){"2048"}, 1);
+    test_json_path_expect(root, "$.files[?(@ == 7)]", (const char *[]){"7"}, 1);
+    test_json_path_expect(root, "$.files[?(@['name'] < 'b')].name", (const char *[]){"\"a\""}, 1);
+    test_json_path_expect(root, "$.files[?(@.size == 8.192e3)].name", (const char *[]){"\"c\""}, 1);
+
+    // Values of an object are filtered too, and filters may be combined with other selectors
+    test_json_path_expect(root, "$.sizes[?(@ > -1.5 && @ < 100)]", (const char *[]){"1"}, 1);
+    Vector *nodes = test_json_path_find(root, "$.files[?(@.size > 4000), 0].name", 2);
+    assert_int_equal(types_vector_size(nodes), 3);
+    types_vector_free(nodes);
+    free(nodes);
+
+    // The same filter tests single nodes
+    size_t end = 0;
+    const char *text = "?(@.status == 'active' && !@.hidden)]";
+    JsonFilter *filter = json_filter_compile(text, strlen(text), 0, &end);
+    assert_ptr_not_equal(filter, NULL);
+    assert_int_equal(end, strlen(text) - 1);
+    assert_true(json_filter_match(filter, node_array_get(node_get(root, &(String){"files", 5, 6}), 3)));
+    assert_false(json_filter_match(filter, node_array_get(node_get(root, &(String){"files", 5, 6}), 2)));
+    assert_int_equal(json_filter_free(filter), CODE_OK);
+
+    // Invalid filters
+    const char *invalid[] = {"$[?]", "$[?()]", "$[?(@.a ==)]", "$[?(@.a == 1]", "$[?(@. == 1)]", "$[?(@.a === 1)]",
+                             "$[?(@.a == 'x)]", "$[?(@.a == 1.)]", "$[?(@.a == tru)]", "$..[?(@.a)]", "$[?(1 2)]"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        String *path_string = types_string_create_from_literal(invalid[i]);
+        JsonPath *path = json_path_parse(path_string);
+        assert_ptr_not_equal(path, NULL);
+        assert_false(path->valid);
+        test_json_path_release(path);
+        types_string_free(path_string);
+        free(path_string);
+    }
+    node_destroy(root);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_json_path_parallel(void **state)
+{
+    // Records large enough to be split among the threads
+    const size_t records = 3 * JSON_PATH_PARALLEL_MIN + 7;
+    String *string = types_string_create_from_literal("{\"records\":[");
+    char record[128];
+    for (size_t i = 0; i < records; i++)
+    {
+        snprintf(record, sizeof(record), "%s{\"id\":%zu,\"even\":%s,\"tags\":[%zu,%zu]}", i == 0 ? "" : ",", i,
+                 i % 2 == 0 ? "true" : "false", i, i + 1);
+        types_string_join_in_place(string, &(String){record, strlen(record), strlen(record) + 1});
+    }
+    types_string_join_in_place(string, &(String){"]}", 2, 3});
+    Node *root = read_from_string(string);
+    ThreadPool *pool = thread_pool_create(4);
+    assert_ptr_not_equal(pool, NULL);
+
+    // The same nodes are found, in the same order, with and without the pool
+    const char *queries[] = {"$.records[*].id", "$.records[?(@.even)].tags[*]", "$.records[*]", "$.records[?(@.id > 100000)]"};
+    const size_t counts[] = {records, records + 1, records, 0};
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++)
+    {
+        JsonPath *path = test_json_path_compile(queries[i], 1);
+        PathTrie *trie = json_path_trie_create(path);
+        Vector *serial = types_vector_create(sizeof(Node *), test_json_path_free_node);
+        Vector *parallel = types_vector_create(sizeof(Node *), test_json_path_free_node);
+        assert_int_equal(json_path_trie_evaluate(root, trie, false, serial), CODE_OK);
+        assert_int_equal(json_path_trie_evaluate_parallel(root, trie, false, pool, parallel), CODE_OK);
+        assert_int_equal(types_vector_size(serial), counts[i]);
+        assert_int_equal(types_vector_size(parallel), counts[i]);
+        assert_memory_equal(serial->data, parallel->data, counts[i] * sizeof(Node *));
+        types_vector_free(serial);
+        free(serial);
+        types_vector_free(parallel);
+        free(parallel);
+        json_path_trie_free(trie);
+        free(trie);
+        test_json_path_release(path);
+    }
+
+    // Missing steps are created below each record by the thread that walks it
+    Vector *nodes = types_vector_create(sizeof(Node *), test_json_path_free_node);
+    JsonPath *path = test_json_path_compile("$.records[*].seen", 1);
+    PathTrie *trie = json_path_trie_create(path);
+    assert_int_equal(json_path_trie_evaluate_parallel(root, trie, true, pool, nodes), CODE_OK);
+    assert_int_equal(types_vector_size(nodes), records);
+    for (size_t i = 0; i < records; i++)
+    {
+        Node *created = *(Node **)types_vector_at(nodes, i);
+        assert_int_equal(created->type, NODE_TYPE_NULL);
+        assert_ptr_equal(created->parent, node_array_get(node_get(root, &(String){"records", 7, 8}), i));
+    }
+    types_vector_free(nodes);
+    free(nodes);
+    json_path_trie_free(trie);
+    free(trie);
+    test_json_path_release(path);
+
+    thread_pool_free(pool);
+    node_destroy(root);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_json_path_set_each(void **state)
+{
+    // Every node found by a wildcard gets its own copy of the value, as the set command does
+    String *string = types_string_create_from_literal("{\"a\":1,\"b\":[1,2,3]}");
+    Node *root = read_from_string(string);
+    String *value_text = types_string_create_from_literal("{\"x\":[1,\"y\"]}");
+    Node *value = read_from_string(value_text);
+    Vector *nodes = test_json_path_find(root, "$.b[*]", 1);
+    assert_int_equal(types_vector_size(nodes), 3);
+    for (size_t i = 0; i < 3; i++)
+    {
+        assert_int_equal(node_set_data(*(Node **)types_vector_at(nodes, i), value), CODE_OK);
+    }
+    node_destroy(value);
+
+    // The copies are apart: changing one leaves the others alone
+    Node *first = node_array_get(node_get(node_array_get(node_get(root, &(String){"b", 1, 2}), 0), &(String){"x", 1, 2}), 1);
+    assert_int_equal(node_erase(first), CODE_OK);
+    String *written = write_to_string(root);
+    assert_string_equal(types_string_c_str(written), "{\"a\":1,\"b\":[{\"x\":[1]},{\"x\":[1,\"y\"]},{\"x\":[1,\"y\"]}]}");
+    assert_ptr_equal(node_get_parent(node_array_get(node_get(root, &(String){"b", 1, 2}), 2)), node_get(root, &(String){"b", 1, 2}));
+
+    types_string_free(written);
+    free(written);
+    types_vector_free(nodes);
+    free(nodes);
+    node_destroy(root);
+    types_string_free(value_text);
+    free(value_text);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_json_path_create_undo(void **state)
+{
+    // A walk that fails after creating nodes takes them back, and the tree is as it was
+    const char *text = "{\"a\":{},\"l\":[],\"n\":1}";
+    String *string = types_string_create_from_literal(text);
+    Node *root = read_from_string(string);
+    const char *failing[] = {"$.a.b[1]", "$.a.b.c[0][2]", "$['a','l'].x", "$['a','n'].x", "$.l[0][1]"};
+    for (size_t i = 0; i < sizeof(failing) / sizeof(failing[0]); i++)
+    {
+        JsonPath *path = test_json_path_compile(failing[i], strchr(failing[i], ',') != NULL ? 2 : 1);
+        PathTrie *trie = json_path_trie_create(path);
+        Vector *nodes = types_vector_create(sizeof(Node *), test_json_path_free_node);
+        assert_int_equal(json_path_trie_evaluate(root, trie, true, nodes), CODE_LOGIC_ERROR);
+        String *written = write_to_string(root);
+        assert_string_equal(types_string_c_str(written), text);
+        types_string_free(written);
+        free(written);
+        types_vector_free(nodes);
+        free(nodes);
+        json_path_trie_free(trie);
+        free(trie);
+        test_json_path_release(path);
+    }
+    node_destroy(root);
+    types_string_free(string);
+    free(string);
+}
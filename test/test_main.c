@@ -7,6 +7,20 @@
 #include "test_types_iterator.c"
 #include "test_types_vector.c"
 #include "test_parser_sm_string.c"
+#include "test_types_memory.c"
+#include "test_write.c"
+#include "test_write_number.c"
+#include "test_read.c"
+#include "test_snapshot.c"
+#include "test_binary.c"
+#include "test_json_path.c"
+#include "test_node_index.c"
+#include "test_thread_pool.c"
+#include "test_server.c"
+#include "test_journal.c"
+#include "test_trace.c"
+#include "test_scaling.c"
+#include "test_allocations.c"
 
 int main(void)
 {
@@ -49,6 +63,59 @@ int main(void)
         cmocka_unit_test(test_types_vector_empty),
         // read
         cmocka_unit_test(test_read_sm),
+        cmocka_unit_test(test_read_from_string_scalars),
+        cmocka_unit_test(test_read_from_string_containers),
+        cmocka_unit_test(test_read_from_string_invalid),
+        cmocka_unit_test(test_read_spans),
+        cmocka_unit_test(test_read_lex_spans),
+        cmocka_unit_test(test_read_context),
+        // memory
+        cmocka_unit_test(test_types_memory_counters),
+        cmocka_unit_test(test_types_memory_string),
+        cmocka_unit_test(test_types_memory_vector),
+        cmocka_unit_test(test_node_stats),
+        // write
+        cmocka_unit_test(test_write_to_string_scalars),
+        cmocka_unit_test(test_write_to_string_containers),
+        cmocka_unit_test(test_write_to_string_allocations),
+        cmocka_unit_test(test_write_to_fd),
+        cmocka_unit_test(test_write_to_string_escape_blocks),
+        cmocka_unit_test(test_write_document_verbatim),
+        cmocka_unit_test(test_write_document_to_file),
+        cmocka_unit_test(test_write_number_double),
+        cmocka_unit_test(test_write_number_round_trip),
+        cmocka_unit_test(test_write_number_integer),
+        // snapshot
+        cmocka_unit_test(test_snapshot_round_trip),
+        cmocka_unit_test(test_snapshot_invalid),
+        // binary formats
+        cmocka_unit_test(test_binary_cbor),
+        cmocka_unit_test(test_binary_msgpack),
+        cmocka_unit_test(test_binary_round_trip),
+        // json path
+        cmocka_unit_test(test_json_path_parse),
+        cmocka_unit_test(test_json_path_evaluate),
+        cmocka_unit_test(test_json_path_trie),
+        cmocka_unit_test(test_json_path_descendant),
+        cmocka_unit_test(test_json_path_filter),
+        cmocka_unit_test(test_json_path_parallel),
+        cmocka_unit_test(test_json_path_set_each),
+        cmocka_unit_test(test_json_path_create_undo),
+        // node index
+        cmocka_unit_test(test_node_index_update),
+        // thread pool
+        cmocka_unit_test(test_thread_pool_run),
+        // server
+        cmocka_unit_test(test_server_lines),
+        // journal
+        cmocka_unit_test(test_journal_replay),
+        // trace
+        cmocka_unit_test(test_trace_phases),
+        // scaling
+        cmocka_unit_test(test_scaling_read),
+        cmocka_unit_test(test_scaling_containers),
+        // allocations
+        cmocka_unit_test(test_allocations_budget),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "node_index.h"
+#include "read/read.h"
+
+// Number of nodes the index holds for a key
+static size_t test_node_index_count(const NodeIndex *index, const char *key)
+{
+    String string = {(char *)key, strlen(key), strlen(key) + 1};
+    return types_vector_size(node_index_find(index, &string, types_string_hash(&string)));
+}
+
+// Read a text into a tree that does not belong to any index yet
+static Node *test_node_index_read(const char *text)
+{
+    String *string = types_string_create_from_literal(text);
+    Node *node = read_from_string(string);
+    types_string_free(string);
+    free(string);
+    assert_ptr_not_equal(node, NULL);
+    return node;
+}
+
+static void test_node_index_update(void **state)
+{
+    Node *root = test_node_index_read("{\"a\":{\"b\":1,\"c\":[{\"b\":2}]},\"d\":[]}");
+    NodeIndex *index = node_index_create(root);
+    assert_ptr_not_equal(index, NULL);
+    assert_int_equal(test_node_index_count(index, "a"), 1);
+    assert_int_equal(test_node_index_count(index, "b"), 2);
+    assert_ptr_equal(node_index_find(index, &(String){"x", 1, 2}, types_string_hash(&(String){"x", 1, 2})), NULL);
+
+    // Subtrees that join the tree bring their keys with them
+    Node *a = node_get(root, &(String){"a", 1, 2});
+    assert_int_equal(node_append(a, &(String){"e", 1, 2}, test_node_index_read("{\"b\":3,\"f\":{\"b\":4}}")), CODE_OK);
+    assert_int_equal(test_node_index_count(index, "b"), 4);
+    assert_int_equal(test_node_index_count(index, "e"), 1);
+    assert_int_equal(node_array_push(node_get(root, &(String){"d", 1, 2}), test_node_index_read("{\"b\":5}")), CODE_OK);
+    assert_int_equal(test_node_index_count(index, "b"), 5);
+
+    // Keys that change move their node
+    Node *e = node_get(a, &(String){"e", 1, 2});
+    assert_int_equal(node_set_key(e, &(String){"g", 1, 2}), CODE_OK);
+    assert_int_equal(test_node_index_count(index, "e"), 0);
+    assert_int_equal(test_node_index_count(index, "g"), 1);
+    assert_ptr_equal(*(Node **)types_vector_at(node_index_find(index, &(String){"g", 1, 2}, types_string_hash(&(String){"g", 1, 2})), 0), e);
+
+    // New data replaces the keys of the old one
+    Node *value = test_node_index_read("{\"h\":{\"b\":6}}");
+    assert_int_equal(node_set_data(e, value), CODE_OK);
+    node_destroy(value);
+    assert_int_equal(test_node_index_count(index, "f"), 0);
+    assert_int_equal(test_node_index_count(index, "h"), 1);
+    assert_int_equal(test_node_index_count(index, "b"), 4);
+
+    // Erased nodes leave with everything below them
+    assert_int_equal(node_erase(e), CODE_OK);
+    assert_int_equal(test_node_index_count(index, "g"), 0);
+    assert_int_equal(test_node_index_count(index, "h"), 0);
+    assert_int_equal(test_node_index_count(index, "b"), 3);
+    assert_int_equal(node_erase(node_get(root, &(String){"a", 1, 2})), CODE_OK);
+    assert_int_equal(test_node_index_count(index, "a"), 0);
+    assert_int_equal(test_node_index_count(index, "c"), 0);
+    assert_int_equal(test_node_index_count(index, "b"), 1);
+
+    // Many different keys make the table grow
+    for (size_t i = 0; i < 1000; i++)
+    {
+        char key[16];
+        const int length = snprintf(key, sizeof(key), "k%zu", i);
+        assert_int_equal(node_append(root, &(String){key, length, length + 1}, node_create()), CODE_OK);
+    }
+    assert_true(index->capacity >= 2 * index->size);
+    assert_int_equal(test_node_index_count(index, "k999"), 1);
+    assert_int_equal(test_node_index_count(index, "b"), 1);
+
+    node_destroy(root);
+    node_index_free(index);
+}
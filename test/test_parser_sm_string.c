@@ -1,7 +1,55 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "read/read_sm.h"
+#include "read/read_sm_define.h"
+
+static void test_read_sm_check(const StateMachine *sm, const char *text, const bool expected_success, const size_t expected_offset)
+{
+    bool success;
+    size_t offset;
+    assert_int_equal(read_sm_execute(sm, text, strlen(text), &success, &offset), CODE_OK);
+    assert_int_equal(success, expected_success);
+    assert_int_equal(offset, expected_offset);
+}
 
 static void test_read_sm(void **state)
 {
-}
\ No newline at end of file
+    // Strings stop right after the closing quote
+    StateMachine *sm = read_sm_define_string();
+    assert_ptr_not_equal(sm, NULL);
+    test_read_sm_check(sm, "\"abc\", 1", true, 5);
+    test_read_sm_check(sm, "\"\"", true, 2);
+    test_read_sm_check(sm, "\"a\\\"b\\\\\\n\"", true, 10);
+    test_read_sm_check(sm, "\"\\u00e9\\uD83D\\ude00\"", true, 20);
+    test_read_sm_check(sm, "\"\xc3\xb1\"", true, 4);
+    test_read_sm_check(sm, "\"abc", false, 4);
+    test_read_sm_check(sm, "\"\\u00g0\"", false, 5);
+    test_read_sm_check(sm, "\"\\x\"", false, 2);
+    test_read_sm_check(sm, "\"a\nb\"", false, 2);
+    test_read_sm_check(sm, "abc", false, 0);
+    assert_int_equal(read_sm_free(sm), CODE_OK);
+    free(sm);
+
+    // Numbers take as many characters as they can
+    sm = read_sm_define_number();
+    test_read_sm_check(sm, "0", true, 1);
+    test_read_sm_check(sm, "-12.5e+3,", true, 8);
+    test_read_sm_check(sm, "10E2]", true, 4);
+    test_read_sm_check(sm, "0.25}", true, 4);
+    test_read_sm_check(sm, "1.", false, 2);
+    test_read_sm_check(sm, "-", false, 1);
+    test_read_sm_check(sm, "1e", false, 2);
+    assert_int_equal(read_sm_free(sm), CODE_OK);
+    free(sm);
+
+    // Literals
+    sm = read_sm_define_null();
+    test_read_sm_check(sm, "null,", true, 4);
+    test_read_sm_check(sm, "nul", false, 3);
+    assert_int_equal(read_sm_free(sm), CODE_OK);
+    free(sm);
+
+    // Invalid arguments
+    assert_int_equal(read_sm_execute(NULL, "1", 1, NULL, NULL), CODE_MEMORY_ERROR);
+}
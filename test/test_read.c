@@ -0,0 +1,220 @@
+#include <string.h>
+
+#include "read/read.h"
+#include "read/read_lex.h"
+#include "thread_pool.h"
+#include "write.h"
+#include "types/types_memory.h"
+
+// Read a text and check it is written back as expected
+static void test_read_check(const char *text, const char *expected)
+{
+    String *string = types_string_create_from_literal(text);
+    Node *node = read_from_string(string);
+    assert_ptr_not_equal(node, NULL);
+    String *output = write_to_string(node);
+    assert_ptr_not_equal(output, NULL);
+    assert_string_equal(types_string_c_str(output), expected);
+    types_string_free(output);
+    free(output);
+    node_destroy(node);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_read_check_invalid(const char *text)
+{
+    String *string = types_string_create_from_literal(text);
+    assert_ptr_equal(read_from_string(string), NULL);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_read_from_string_scalars(void **state)
+{
+    test_read_check("null", "null");
+    test_read_check(" true ", "true");
+    test_read_check("\tfalse\n", "false");
+    test_read_check("-12.5e3", "-12500");
+    test_read_check("0", "0");
+    test_read_check("\"hello\"", "\"hello\"");
+
+    // Escape sequences are decoded, and encoded again when writing
+    test_read_check("\"a\\\"b\\\\c\\/d\\n\"", "\"a\\\"b\\\\c/d\\n\"");
+    test_read_check("\"\\u00e9\\u20AC\\ud83d\\ude00\\u0001\"", "\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\\u0001\"");
+    test_read_check("\"\\udc00\"", "\"\xef\xbf\xbd\"");
+}
+
+static void test_read_from_string_containers(void **state)
+{
+    test_read_check("[]", "[]");
+    test_read_check("{ }", "{}");
+    test_read_check("[1, 2 ,3]", "[1,2,3]");
+    test_read_check("{\"a\": 1, \"b\": [true, {\"c\": null}], \"d\": {\"e\": [], \"f\": \"x\"}}",
+                    "{\"a\":1,\"b\":[true,{\"c\":null}],\"d\":{\"e\":[],\"f\":\"x\"}}");
+    test_read_check("[[1, [2, 3]], [], [[4]]]", "[[1,[2,3]],[],[[4]]]");
+    test_read_check("{\"k\\n\": \"v\"}", "{\"k\\n\":\"v\"}");
+
+    // Parents are set all the way down
+    String *string = types_string_create_from_literal("{\"a\": [1, {\"b\": 2}]}");
+    Node *root = read_from_string(string);
+    Node *array = node_get(root, &(String){"a", 1, 2});
+    assert_ptr_equal(node_get_parent(array), root);
+    Node *object = node_array_get(array, 1);
+    assert_ptr_equal(node_get_parent(object), array);
+    assert_ptr_equal(node_get_parent(node_get(object, &(String){"b", 1, 2})), object);
+    node_destroy(root);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_read_from_string_invalid(void **state)
+{
+    test_read_check_invalid("");
+    test_read_check_invalid("nul");
+    test_read_check_invalid("[1, 2");
+    test_read_check_invalid("[1, 2,]");
+    test_read_check_invalid("[1 2]");
+    test_read_check_invalid("{\"a\" 1}");
+    test_read_check_invalid("{\"a\": }");
+    test_read_check_invalid("{1: 2}");
+    test_read_check_invalid("{\"a\": 1,}");
+    test_read_check_invalid("[1] [2]");
+    test_read_check_invalid("\"abc");
+    test_read_check_invalid("[1, @]");
+
+    // Nothing is left behind by the failures
+    types_memory_reset();
+    test_read_check_invalid("{\"a\": [1, 2, {\"b\": \"c\"}], \"d\": }");
+    assert_int_equal(types_memory_total().live_bytes, 0);
+}
+
+static void test_read_spans(void **state)
+{
+    const char *text = " {\"a\": [1, 2.50], \"b\" : \"x\\ty\"} ";
+    String *string = types_string_create_from_literal(text);
+    Node *root = read_from_string(string);
+    assert_ptr_not_equal(root, NULL);
+
+    // Every node knows the part of the text it was read from
+    assert_int_equal(root->source_start, 1);
+    assert_int_equal(root->source_end, strlen(text) - 1);
+    Node *array = node_get(root, &(String){"a", 1, 2});
+    assert_int_equal(array->source_start, 7);
+    assert_int_equal(array->source_end, 16);
+    Node *number = node_array_get(array, 1);
+    assert_memory_equal(text + number->source_start, "2.50", number->source_end - number->source_start);
+    Node *value = node_get(root, &(String){"b", 1, 2});
+    assert_memory_equal(text + value->source_start, "\"x\\ty\"", value->source_end - value->source_start);
+
+    // Nothing has changed yet
+    assert_true(node_is_clean(root));
+    assert_true(node_is_clean(array));
+    assert_true(node_is_clean(number));
+
+    // Changing a node marks it and all its ancestors, but not its siblings
+    Node *new = node_create();
+    node_set_data(node_array_get(array, 0), new);
+    node_destroy(new);
+    assert_false(node_is_clean(node_array_get(array, 0)));
+    assert_false(node_is_clean(array));
+    assert_false(node_is_clean(root));
+    assert_true(node_is_clean(number));
+    assert_true(node_is_clean(value));
+
+    node_destroy(root);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_read_lex_spans(void **state)
+{
+    const char *text = "{\"k\\\"\": [-1.5e3, null]}";
+    String *string = types_string_create_from_literal(text);
+    Vector *tokens = types_vector_create(sizeof(Token), read_lex_free_token);
+    assert_int_equal(read_lex(read_lex_default(), string, tokens), CODE_OK);
+    assert_int_equal(types_vector_size(tokens), 9);
+
+    // Tokens only locate their text, quotes included for strings
+    const Token *key = types_vector_at(tokens, 1);
+    assert_int_equal(key->id, TOKEN_ID_STRING);
+    assert_memory_equal(text + key->start, "\"k\\\"\"", key->end - key->start);
+    const Token *number = types_vector_at(tokens, 4);
+    assert_int_equal(number->id, TOKEN_ID_NUMBER);
+    assert_memory_equal(text + number->start, "-1.5e3", number->end - number->start);
+    const Token *null = types_vector_at(tokens, 6);
+    assert_int_equal(null->id, TOKEN_ID_NULL);
+    assert_int_equal(null->end - null->start, 4);
+
+    types_vector_free(tokens);
+    free(tokens);
+    types_string_free(string);
+    free(string);
+}
+
+// Every task reads its own text with its own context, and checks what it read
+typedef struct TestReadContexts_st
+{
+    ReadContext *contexts[4];
+    String *texts[4];
+    size_t read[4];
+} TestReadContexts;
+
+static ResultCode test_read_context_task(void *contexts, const size_t index)
+{
+    TestReadContexts *test = contexts;
+    for (size_t i = 0; i < 100; i++)
+    {
+        Node *node = read_from_string_with_context(test->texts[index], test->contexts[index]);
+        if (node == NULL || node_array_size(node) != index + 1)
+        {
+            node_destroy(node);
+            return CODE_LOGIC_ERROR;
+        }
+        node_destroy(node);
+        test->read[index] += 1;
+    }
+    return CODE_OK;
+}
+
+static void test_read_context(void **state)
+{
+    // Contexts share a lexer, and keep the memory of their tokens from one read to the next
+    ReadLexer *lexer = read_lex_create();
+    assert_non_null(lexer);
+    TestReadContexts test = {0};
+    const char *texts[4] = {"[1]", "[\"a\", 2]", "[true, false, null]", "[{}, [], {\"k\": 1}, 4.5]"};
+    for (size_t i = 0; i < 4; i++)
+    {
+        test.contexts[i] = read_context_create(lexer);
+        assert_non_null(test.contexts[i]);
+        assert_ptr_equal(test.contexts[i]->lexer, lexer);
+        test.texts[i] = types_string_create_from_literal(texts[i]);
+    }
+    Node *node = read_from_string_with_context(test.texts[3], test.contexts[0]);
+    const size_t capacity = test.contexts[0]->tokens->capacity;
+    node_destroy(node);
+    node = read_from_string_with_context(test.texts[0], test.contexts[0]);
+    assert_int_equal(types_vector_size(test.contexts[0]->tokens), 3);
+    assert_int_equal(test.contexts[0]->tokens->capacity, capacity);
+    node_destroy(node);
+
+    // Threads read at the same time, each with its own context
+    ThreadPool *pool = thread_pool_create(4);
+    assert_non_null(pool);
+    assert_int_equal(thread_pool_run(pool, 4, test_read_context_task, &test), CODE_OK);
+    for (size_t i = 0; i < 4; i++)
+    {
+        assert_int_equal(test.read[i], 100);
+        assert_int_equal(read_context_free(test.contexts[i]), CODE_OK);
+        types_string_free(test.texts[i]);
+        free(test.texts[i]);
+    }
+    thread_pool_free(pool);
+
+    // Without a lexer, a context takes the shared one
+    ReadContext *context = read_context_create(NULL);
+    assert_ptr_equal(context->lexer, read_lex_default());
+    assert_int_equal(read_context_free(context), CODE_OK);
+    assert_int_equal(read_lex_free(lexer), CODE_OK);
+}
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "types/types_memory.h"
+#include "types/types_vector.h"
+#include "types/types_map.h"
+#include "types/types_string.h"
+#include "read/read.h"
+#include "read/read_lex.h"
+#include "read/read_parse.h"
+
+/// @brief Records, or elements, in the smallest input of the scaling tests
+#define TEST_SCALING_SIZE 1000
+
+/// @brief Most the counters may grow when the input doubles. Linear work doubles them, give
+/// or take the rounding of the growth of the buffers, and quadratic work quadruples them
+#define TEST_SCALING_RATIO 2.5
+
+/// @brief Work done on an input of a given size, of which the memory counters are compared
+/// @param size Size of the input
+typedef void (*TestScalingWork)(const size_t size);
+
+/// @brief Run some work on inputs of size n, 2n and 4n, and check the allocations and the bytes
+/// reserved grow no faster than the input. Counters are used instead of the time taken, so the
+/// test gives the same answer on any machine and under any load
+/// @param work Work
+static void test_scaling_assert_linear(TestScalingWork work)
+{
+    MemoryCounters counters[3];
+    for (size_t i = 0; i < 3; i++)
+    {
+        types_memory_reset();
+        work(TEST_SCALING_SIZE << i);
+        counters[i] = types_memory_total();
+    }
+    for (size_t i = 1; i < 3; i++)
+    {
+        assert_true(counters[i - 1].allocations > 0);
+        assert_true(counters[i].allocations <= TEST_SCALING_RATIO * counters[i - 1].allocations);
+        assert_true(counters[i].reserved_bytes <= TEST_SCALING_RATIO * counters[i - 1].reserved_bytes);
+    }
+}
+
+static String *test_scaling_text(const size_t records)
+{
+    String *text = types_string_create_from_literal("[");
+    char record[128];
+    for (size_t i = 0; i < records; i++)
+    {
+        snprintf(record, sizeof(record), "%s{\"id\":%zu,\"name\":\"say \\\"%zu\\\"\",\"values\":[1.5,true,null]}", i == 0 ? "" : ",", i, i);
+        types_string_join_in_place(text, &(String){record, strlen(record), sizeof(record)});
+    }
+    types_string_join_in_place(text, &(String){"]", 1, 2});
+    return text;
+}
+
+static ResultCode test_scaling_free_nothing(void *element)
+{
+    return CODE_OK;
+}
+
+static ResultCode test_scaling_free_pointer(void *element)
+{
+    free(element);
+    return CODE_OK;
+}
+
+static bool test_scaling_compare(const void *key1, const void *key2)
+{
+    return *(const size_t *)key1 != *(const size_t *)key2;
+}
+
+static void *test_scaling_copy(const void *key)
+{
+    size_t *copy = malloc(sizeof(size_t));
+    *copy = *(const size_t *)key;
+    return copy;
+}
+
+static void test_scaling_lex(const size_t size)
+{
+    // The text is made before the counters are reset, so only the lexer is measured
+    String *text = test_scaling_text(size);
+    Vector *tokens = read_tokens_create();
+    types_memory_reset();
+    assert_int_equal(read_lex(read_lex_default(), text, tokens), CODE_OK);
+    assert_true(types_vector_size(tokens) > 10 * size);
+    types_vector_free(tokens);
+    free(tokens);
+    types_string_free(text);
+    free(text);
+}
+
+static void test_scaling_parse(const size_t size)
+{
+    // The lexer runs before the counters are reset, so only the parser is measured
+    String *text = test_scaling_text(size);
+    Vector *tokens = read_tokens_create();
+    assert_int_equal(read_lex(read_lex_default(), text, tokens), CODE_OK);
+    types_memory_reset();
+    Node *root = read_parse(text, tokens);
+    assert_non_null(root);
+    assert_int_equal(node_array_size(root), size);
+    node_destroy(root);
+    types_vector_free(tokens);
+    free(tokens);
+    types_string_free(text);
+    free(text);
+}
+
+static void test_scaling_vector(const size_t size)
+{
+    // Pushing, then inserting at the end
+    Vector *vector = types_vector_create(sizeof(size_t), test_scaling_free_nothing);
+    for (size_t i = 0; i < size; i++)
+    {
+        assert_int_equal(types_vector_push(vector, &i), CODE_OK);
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        Iterator element = types_iterator_create(&i, sizeof(size_t));
+        assert_int_equal(types_vector_insert(vector, element, types_iterator_increase(element, 1), types_vector_end(vector)), CODE_OK);
+    }
+    assert_int_equal(types_vector_size(vector), 2 * size);
+    types_vector_free(vector);
+    free(vector);
+}
+
+static void test_scaling_map(const size_t size)
+{
+    Map *map = types_map_create(sizeof(size_t), sizeof(size_t), test_scaling_free_pointer, test_scaling_free_pointer,
+                                test_scaling_compare, test_scaling_copy, test_scaling_copy, NULL);
+    for (size_t i = 0; i < size; i++)
+    {
+        types_map_insert(map, &i, &i);
+    }
+    assert_int_equal(types_map_size(map), size);
+    types_map_free(map);
+    free(map);
+}
+
+static void test_scaling_string(const size_t size)
+{
+    String *string = types_string_create();
+    for (size_t i = 0; i < size; i++)
+    {
+        assert_int_equal(types_string_join_in_place(string, &(String){"0123456789", 10, 11}), CODE_OK);
+    }
+    assert_int_equal(types_string_length(string), 10 * size);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_scaling_read(void **state)
+{
+    test_scaling_assert_linear(test_scaling_lex);
+    test_scaling_assert_linear(test_scaling_parse);
+}
+
+static void test_scaling_containers(void **state)
+{
+    test_scaling_assert_linear(test_scaling_vector);
+    test_scaling_assert_linear(test_scaling_map);
+    test_scaling_assert_linear(test_scaling_string);
+}
@@ -0,0 +1,96 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server.h"
+
+// Answers every request with its length, and stops the server on request
+static ResultCode test_server_handler(void *server, const String *request, String *reply)
+{
+    char answer[32];
+    if (strcmp(types_string_c_str(request), "stop") == 0)
+    {
+        server_stop(*(Server **)server);
+    }
+    snprintf(answer, sizeof(answer), "%d", request->length);
+    return types_string_join_in_place(reply, &(String){answer, strlen(answer), sizeof(answer)});
+}
+
+static void *test_server_run(void *server)
+{
+    server_run(server);
+    return NULL;
+}
+
+static int test_server_connect(const char *path)
+{
+    struct sockaddr_un address;
+    memset(&address, '\0', sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    const int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert_true(client >= 0);
+    assert_int_equal(connect(client, (struct sockaddr *)&address, sizeof(address)), 0);
+    return client;
+}
+
+// Read from a socket until the expected text has arrived
+static void test_server_expect(const int client, const char *expected)
+{
+    char buffer[256];
+    size_t received = 0;
+    while (received < strlen(expected))
+    {
+        const ssize_t size = recv(client, buffer + received, sizeof(buffer) - received - 1, 0);
+        assert_true(size > 0);
+        received += size;
+    }
+    buffer[received] = '\0';
+    assert_string_equal(buffer, expected);
+}
+
+static void test_server_lines(void **state)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/test_server_%ld.sock", (long)getpid());
+    Server *server = NULL;
+    server = server_create(path, test_server_handler, &server);
+    assert_ptr_not_equal(server, NULL);
+    pthread_t thread;
+    assert_int_equal(pthread_create(&thread, NULL, test_server_run, server), 0);
+
+    // Requests split across writes, or sent together, are answered in order
+    const int first = test_server_connect(path);
+    const int second = test_server_connect(path);
+    assert_int_equal(send(first, "abc\nde", 6, 0), 6);
+    test_server_expect(first, "3\n");
+    assert_int_equal(send(second, "x\r\n\n", 4, 0), 4);
+    test_server_expect(second, "1\n0\n");
+    assert_int_equal(send(first, "f\n", 2, 0), 2);
+    test_server_expect(first, "3\n");
+
+    // A request that keeps growing without a line end closes its client once past the limit
+    const int third = test_server_connect(path);
+    char chunk[65536];
+    memset(chunk, 'x', sizeof(chunk));
+    size_t total = 0;
+    while (total <= 4 * SERVER_MAX_REQUEST && send(third, chunk, sizeof(chunk), MSG_NOSIGNAL) > 0)
+    {
+        total += sizeof(chunk);
+    }
+    assert_true(total <= 4 * SERVER_MAX_REQUEST);
+    test_server_expect(third, "ERROR request too long\n");
+    close(third);
+
+    // A client that leaves does not bother the others
+    close(second);
+    assert_int_equal(send(first, "stop\n", 5, 0), 5);
+    test_server_expect(first, "4\n");
+    assert_int_equal(pthread_join(thread, NULL), 0);
+    close(first);
+    assert_int_equal(server_free(server), CODE_OK);
+    assert_int_equal(access(path, F_OK), -1);
+}
@@ -0,0 +1,148 @@
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "snapshot.h"
+#include "write.h"
+#include "read/read.h"
+
+static void test_snapshot_round_trip(void **state)
+{
+    const char *text = "{\"name\":\"wizard\",\"list\":[1,2.5,-3e+20,true,false,null,\"\"],"
+                       "\"b\":{},\"a\":[],\"nested\":{\"z\":1,\"y\":\"two\",\"x\\u0000\":[{}]}}";
+    String *string = types_string_create_from_literal(text);
+    Node *root = read_from_string(string);
+    assert_ptr_not_equal(root, NULL);
+
+    char filename[] = "/tmp/test_snapshot_XXXXXX";
+    int fd = mkstemp(filename);
+    assert_true(fd >= 0);
+    close(fd);
+    String *name = types_string_create_from_literal(filename);
+    assert_int_equal(write_snapshot(root, name), CODE_OK);
+    Snapshot *snapshot = read_snapshot(name);
+    assert_ptr_not_equal(snapshot, NULL);
+
+    // Values are found in place
+    const SnapshotValue *value = snapshot_root(snapshot);
+    assert_int_equal(value->type, NODE_TYPE_OBJECT);
+    assert_int_equal(value->length, 5);
+    const SnapshotValue *found = snapshot_get(snapshot, value, &(String){"name", 4, 5});
+    assert_int_equal(found->type, NODE_TYPE_STRING);
+    assert_string_equal(snapshot_text(snapshot, found->data.offset, found->length), "wizard");
+    const SnapshotValue *list = snapshot_get(snapshot, value, &(String){"list", 4, 5});
+    assert_int_equal(list->length, 7);
+    assert_true(snapshot_array_get(snapshot, list, 1)->data.number == 2.5);
+    assert_int_equal(snapshot_array_get(snapshot, list, 3)->type, NODE_TYPE_TRUE);
+    assert_ptr_equal(snapshot_array_get(snapshot, list, 7), NULL);
+    const SnapshotValue *nested = snapshot_get(snapshot, value, &(String){"nested", 6, 7});
+    assert_int_equal(snapshot_get(snapshot, nested, &(String){"x\0", 2, 3})->type, NODE_TYPE_ARRAY);
+    assert_ptr_equal(snapshot_get(snapshot, nested, &(String){"x", 1, 2}), NULL);
+    assert_ptr_equal(snapshot_get(snapshot, value, &(String){"missing", 7, 8}), NULL);
+    assert_ptr_equal(snapshot_get(snapshot, list, &(String){"name", 4, 5}), NULL);
+    const SnapshotMember *member = snapshot_member(snapshot, value, 1);
+    assert_string_equal(snapshot_text(snapshot, member->key, member->key_length), "list");
+
+    // Members keep the order of the document
+    Node *copy = snapshot_to_node(snapshot, value);
+    assert_ptr_not_equal(copy, NULL);
+    String *output = write_to_string(copy);
+    assert_string_equal(types_string_c_str(output), "{\"name\":\"wizard\",\"list\":[1,2.5,-3e20,true,false,null,\"\"],"
+                                                    "\"b\":{},\"a\":[],\"nested\":{\"z\":1,\"y\":\"two\",\"x\\u0000\":[{}]}}");
+
+    types_string_free(output);
+    free(output);
+    node_destroy(copy);
+    assert_int_equal(snapshot_close(snapshot), CODE_OK);
+    unlink(filename);
+    types_string_free(name);
+    free(name);
+    node_destroy(root);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_snapshot_invalid(void **state)
+{
+    Node *root = node_create();
+    char filename[] = "/tmp/test_snapshot_XXXXXX";
+    int fd = mkstemp(filename);
+    assert_true(fd >= 0);
+    close(fd);
+    String *name = types_string_create_from_literal(filename);
+    assert_int_equal(write_snapshot(root, name), CODE_OK);
+
+    // A valid header
+    _Alignas(uint64_t) char buffer[sizeof(SnapshotHeader) + sizeof(SnapshotValue)];
+    fd = open(filename, O_RDONLY);
+    assert_int_equal(read(fd, buffer, sizeof(buffer)), sizeof(buffer));
+    close(fd);
+    assert_true(snapshot_check(buffer, sizeof(buffer)));
+
+    // Any other size, version or text is rejected
+    assert_false(snapshot_check(buffer, sizeof(buffer) - 1));
+    ((SnapshotHeader *)buffer)->version += 1;
+    assert_false(snapshot_check(buffer, sizeof(buffer)));
+    Snapshot snapshot = {buffer, sizeof(buffer), false};
+    assert_ptr_equal(snapshot_root(&snapshot), NULL);
+    String *text = types_string_create_from_literal("null");
+    fd = open(filename, O_WRONLY | O_TRUNC);
+    assert_int_equal(write(fd, types_string_c_str(text), 4), 4);
+    close(fd);
+    assert_ptr_equal(read_snapshot(name), NULL);
+
+
+    // Offsets that lead back to a value or to one of its ancestors are refused instead of
+    // being followed around forever
+    String *nested = types_string_create_from_literal("[[1, [2]], 3]");
+    Node *tree = read_from_string(nested);
+    assert_int_equal(write_snapshot(tree, name), CODE_OK);
+    fd = open(filename, O_RDONLY);
+    const size_t size = lseek(fd, 0, SEEK_END);
+    char *image = malloc(size);
+    assert_int_equal(pread(fd, image, size, 0), size);
+    close(fd);
+    Snapshot damaged = {image, size, false};
+    SnapshotValue *top = (SnapshotValue *)(image + ((SnapshotHeader *)image)->root);
+    SnapshotValue *inner = (SnapshotValue *)snapshot_array_get(&damaged, top, 0);
+    const uint64_t offset = inner->data.offset;
+    inner->data.offset = top->data.offset;
+    assert_ptr_equal(snapshot_to_node(&damaged, top), NULL);
+    inner->data.offset = ((SnapshotHeader *)image)->root;
+    assert_ptr_equal(snapshot_to_node(&damaged, top), NULL);
+    const uint64_t children = top->data.offset;
+    top->data.offset = ((SnapshotHeader *)image)->root;
+    assert_ptr_equal(snapshot_to_node(&damaged, top), NULL);
+
+    // Put back, the same image is read again
+    inner->data.offset = offset;
+    top->data.offset = children;
+    Node *copy = snapshot_to_node(&damaged, top);
+    assert_ptr_not_equal(copy, NULL);
+    node_destroy(copy);
+    free(image);
+    node_destroy(tree);
+
+    // Nesting is limited, as in the other binary formats
+    tree = node_create();
+    tree->type = NODE_TYPE_ARRAY;
+    Node *deepest = tree;
+    for (size_t i = 0; i < SNAPSHOT_MAX_DEPTH; i++)
+    {
+        Node *child = node_create();
+        child->type = NODE_TYPE_ARRAY;
+        assert_int_equal(node_array_push(deepest, child), CODE_OK);
+        deepest = child;
+    }
+    assert_int_equal(write_snapshot(tree, name), CODE_NOT_SUPPORTED);
+    node_destroy(tree);
+
+    unlink(filename);
+    types_string_free(nested);
+    free(nested);
+    types_string_free(text);
+    free(text);
+    types_string_free(name);
+    free(name);
+    node_destroy(root);
+}
@@ -0,0 +1,52 @@
+#include "thread_pool.h"
+
+// Every task writes to its own element, and fails for the multiples of the divisor
+typedef struct TestThreadPoolContext_st
+{
+    size_t *ran;
+    size_t divisor;
+} TestThreadPoolContext;
+
+static ResultCode test_thread_pool_task(void *context, const size_t index)
+{
+    TestThreadPoolContext *test_context = context;
+    test_context->ran[index] += 1;
+    return test_context->divisor != 0 && index % test_context->divisor == 0 ? CODE_LOGIC_ERROR : CODE_OK;
+}
+
+static void test_thread_pool_run(void **state)
+{
+    size_t ran[1000];
+    TestThreadPoolContext context = {ran, 0};
+    ThreadPool *pool = thread_pool_create(4);
+    assert_ptr_not_equal(pool, NULL);
+    assert_int_equal(thread_pool_size(pool), 4);
+    assert_int_equal(thread_pool_size(NULL), 1);
+    assert_ptr_equal(thread_pool_create(0), NULL);
+
+    // Every task runs exactly once, run after run, with or without a pool
+    ThreadPool *pools[] = {pool, NULL};
+    for (size_t p = 0; p < 2; p++)
+    {
+        for (size_t run = 0; run < 20; run++)
+        {
+            memset(ran, '\0', sizeof(ran));
+            assert_int_equal(thread_pool_run(pools[p], 1000, test_thread_pool_task, &context), CODE_OK);
+            for (size_t i = 0; i < 1000; i++)
+            {
+                assert_int_equal(ran[i], 1);
+            }
+        }
+    }
+
+    // A failed task does not stop the others
+    memset(ran, '\0', sizeof(ran));
+    context.divisor = 250;
+    assert_int_equal(thread_pool_run(pool, 1000, test_thread_pool_task, &context), CODE_LOGIC_ERROR);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        assert_int_equal(ran[i], 1);
+    }
+    assert_int_equal(thread_pool_run(pool, 0, test_thread_pool_task, &context), CODE_OK);
+    assert_int_equal(thread_pool_free(pool), CODE_OK);
+}
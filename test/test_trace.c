@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+#include "read/read.h"
+
+static void test_trace_phases(void **state)
+{
+    // Nothing is recorded until tracing is enabled
+    String *text = types_string_create_from_literal("{\"a\": [1, 2, {\"b\": null}], \"c\": \"d\"}");
+    node_destroy(read_from_string(text));
+    assert_int_equal(trace_get(TRACE_PHASE_LEX).count, 0);
+
+    // The lexer counts its tokens, and the parser the nodes it builds
+    assert_int_equal(trace_enable(), CODE_OK);
+    node_destroy(read_from_string(text));
+    TraceTotals lex = trace_get(TRACE_PHASE_LEX);
+    assert_int_equal(lex.count, 1);
+    assert_int_equal(lex.items, 19);
+    assert_int_equal(lex.bytes, types_string_length(text));
+    TraceTotals parse = trace_get(TRACE_PHASE_PARSE);
+    assert_int_equal(parse.count, 1);
+    assert_int_equal(parse.items, 7);
+    trace_end(TRACE_PHASE_WRITE, trace_begin(), 0, 42);
+    assert_int_equal(trace_get(TRACE_PHASE_WRITE).bytes, 42);
+
+    // The report holds the totals and a complete event for every run
+    FILE *file = tmpfile();
+    assert_non_null(file);
+    assert_int_equal(trace_write(file), CODE_OK);
+    char report[2048];
+    rewind(file);
+    const size_t length = fread(report, 1, sizeof(report) - 1, file);
+    report[length] = '\0';
+    fclose(file);
+    assert_non_null(strstr(report, "\"lex\":{\"count\":1,"));
+    assert_non_null(strstr(report, "\"items\":7,"));
+    assert_non_null(strstr(report, "\"traceEvents\":[\n{\"name\":\"lex\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"));
+    assert_non_null(strstr(report, "{\"name\":\"write\","));
+
+    // Resetting forgets everything and stops recording
+    trace_reset();
+    assert_false(trace_enabled());
+    assert_int_equal(trace_get(TRACE_PHASE_LEX).count, 0);
+    types_string_free(text);
+    free(text);
+}
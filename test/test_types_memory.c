@@ -0,0 +1,159 @@
+#include <string.h>
+
+#include "types/types_memory.h"
+#include "types/types_string.h"
+#include "types/types_vector.h"
+#include "node.h"
+
+static ResultCode test_types_memory_int_free(void *data)
+{
+    return CODE_OK;
+}
+
+static void test_types_memory_counters(void **state)
+{
+    types_memory_reset();
+
+    // Allocate in two categories
+    types_memory_allocate(MEMORY_CATEGORY_STRING, 10);
+    types_memory_allocate(MEMORY_CATEGORY_VECTOR, 20);
+    MemoryCounters counters = types_memory_get(MEMORY_CATEGORY_STRING);
+    assert_int_equal(counters.live_bytes, 10);
+    assert_int_equal(counters.peak_bytes, 10);
+    assert_int_equal(counters.allocations, 1);
+    assert_int_equal(counters.frees, 0);
+    counters = types_memory_total();
+    assert_int_equal(counters.live_bytes, 30);
+    assert_int_equal(counters.peak_bytes, 30);
+    assert_int_equal(counters.allocations, 2);
+
+    // Grow and shrink, the peak remains
+    types_memory_resize(MEMORY_CATEGORY_STRING, 10, 50);
+    types_memory_resize(MEMORY_CATEGORY_STRING, 50, 5);
+    counters = types_memory_get(MEMORY_CATEGORY_STRING);
+    assert_int_equal(counters.live_bytes, 5);
+    assert_int_equal(counters.peak_bytes, 50);
+    assert_int_equal(counters.allocations, 3);
+    counters = types_memory_total();
+    assert_int_equal(counters.live_bytes, 25);
+    assert_int_equal(counters.peak_bytes, 70);
+
+    // Release everything
+    types_memory_release(MEMORY_CATEGORY_STRING, 5);
+    types_memory_release(MEMORY_CATEGORY_VECTOR, 20);
+    counters = types_memory_total();
+    assert_int_equal(counters.live_bytes, 0);
+    assert_int_equal(counters.peak_bytes, 70);
+    assert_int_equal(counters.frees, 2);
+
+    // Releasing more than recorded does not wrap around
+    types_memory_release(MEMORY_CATEGORY_NODE, 100);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_NODE).live_bytes, 0);
+    assert_int_equal(types_memory_total().live_bytes, 0);
+
+    // Invalid category
+    types_memory_allocate(MEMORY_CATEGORY_TOTAL, 100);
+    assert_int_equal(types_memory_total().live_bytes, 0);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_TOTAL).allocations, 0);
+
+    // Reset
+    types_memory_reset();
+    counters = types_memory_total();
+    assert_int_equal(counters.peak_bytes, 0);
+    assert_int_equal(counters.allocations, 0);
+    assert_int_equal(counters.frees, 0);
+}
+
+static void test_types_memory_string(void **state)
+{
+    types_memory_reset();
+
+    // Creation records the buffer
+    String *string = types_string_create_from_literal("hello");
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_STRING).live_bytes, 6);
+
+    // Reserving and joining record the growth
+    assert_int_equal(types_string_reserve(string, 100), CODE_OK);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_STRING).live_bytes, 100);
+    String *other = types_string_create_from_literal(" world");
+    assert_int_equal(types_string_join_in_place(string, other), CODE_OK);
+    assert_int_equal(string->capacity, 100);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_STRING).live_bytes, 107);
+
+    // Freeing gives everything back
+    types_string_free(string);
+    types_string_free(other);
+    free(string);
+    free(other);
+    MemoryCounters counters = types_memory_get(MEMORY_CATEGORY_STRING);
+    assert_int_equal(counters.live_bytes, 0);
+    assert_int_equal(counters.peak_bytes, 107);
+    assert_int_equal(counters.frees, 2);
+}
+
+static void test_types_memory_vector(void **state)
+{
+    types_memory_reset();
+
+    Vector *vector = types_vector_create(sizeof(int), test_types_memory_int_free);
+    for (int i = 0; i < 10; i++)
+    {
+        assert_int_equal(types_vector_push(vector, &i), CODE_OK);
+    }
+    MemoryCounters counters = types_memory_get(MEMORY_CATEGORY_VECTOR);
+    assert_int_equal(counters.live_bytes, vector->capacity * sizeof(int));
+    assert_int_equal(counters.allocations, 5);
+    assert_int_equal(counters.reserved_bytes, (1 + 2 + 4 + 8 + 16) * sizeof(int));
+
+    assert_int_equal(types_vector_free(vector), CODE_OK);
+    free(vector);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_VECTOR).live_bytes, 0);
+}
+
+static void test_node_stats(void **state)
+{
+    types_memory_reset();
+
+    // Build an array with two strings
+    Node *root = node_create();
+    root->type = NODE_TYPE_ARRAY;
+    for (size_t i = 0; i < 2; i++)
+    {
+        Node *child = node_create();
+        child->type = NODE_TYPE_STRING;
+        child->data = types_string_create_from_literal("abc");
+        assert_int_equal(node_array_push(root, child), CODE_OK);
+        assert_ptr_equal(child->parent, root);
+    }
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_NODE).live_bytes, 3 * sizeof(Node));
+
+    // Walk the tree
+    NodeStats stats;
+    memset(&stats, '\0', sizeof(NodeStats));
+    assert_int_equal(node_stats(root, &stats), CODE_OK);
+    assert_int_equal(stats.nodes[NODE_TYPE_ARRAY], 1);
+    assert_int_equal(stats.nodes[NODE_TYPE_STRING], 2);
+    assert_int_equal(stats.string_bytes, 2 * (sizeof(String) + 4));
+    assert_int_equal(stats.node_bytes[NODE_TYPE_STRING], 2 * (sizeof(Node) + sizeof(String) + 4));
+    assert_int_equal(stats.container_bytes, sizeof(Vector) + 4 * sizeof(Node *));
+    assert_int_equal(stats.container_overhead_bytes, sizeof(Vector) + 2 * sizeof(Node *));
+    assert_int_equal(stats.total_bytes, 3 * sizeof(Node) + stats.string_bytes + stats.container_bytes);
+    assert_int_equal(node_stats(NULL, &stats), CODE_MEMORY_ERROR);
+
+    // Destroying the root gives back all the memory
+    assert_int_equal(node_destroy(root), CODE_OK);
+    assert_int_equal(types_memory_total().live_bytes, 0);
+    // Numbers record their value along with the node
+    types_memory_reset();
+    Node *number = node_create();
+    assert_int_equal(node_set_number(number, 1.5), CODE_OK);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_NODE).live_bytes, sizeof(Node) + sizeof(double));
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_NODE).allocations, 2);
+    Node *copy = node_copy(number);
+    assert_int_equal(*(double *)copy->data, 1.5);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_NODE).live_bytes, 2 * (sizeof(Node) + sizeof(double)));
+    assert_int_equal(node_destroy(number), CODE_OK);
+    assert_int_equal(node_destroy(copy), CODE_OK);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_NODE).live_bytes, 0);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_NODE).frees, 4);
+}
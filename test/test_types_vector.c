@@ -159,11 +159,11 @@ static void test_types_vector_clear(void **state)
     Vector *vector = create_integer_vector();
     assert_int_equal(types_vector_clear(vector), CODE_OK);
     assert_int_equal(vector->size, 0);
-    assert_int_equal(vector->capacity, 10);
+    assert_int_equal(vector->capacity, 16);
     assert_int_equal(vector->element_size, sizeof(int));
     assert_int_equal(types_vector_clear(vector), CODE_OK);
     assert_int_equal(vector->size, 0);
-    assert_int_equal(vector->capacity, 10);
+    assert_int_equal(vector->capacity, 16);
     assert_int_equal(vector->element_size, sizeof(int));
     assert_int_equal(types_vector_free(vector), CODE_OK);
     free(vector);
@@ -297,7 +297,7 @@ static void test_types_vector_erase(void **state)
     last = types_iterator_increase(first, 1);
     assert_int_equal(types_vector_erase(vector, first, last), CODE_OK);
     assert_int_equal(vector->size, 9);
-    assert_int_equal(vector->capacity, 10);
+    assert_int_equal(vector->capacity, 16);
     int expectedInt = 0;
     for (size_t i = 0; i < 9; i++)
     {
@@ -318,7 +318,7 @@ static void test_types_vector_erase(void **state)
     last = types_iterator_increase(first, 1);
     assert_int_equal(types_vector_erase(vector, first, last), CODE_OK);
     assert_int_equal(vector->size, 9);
-    assert_int_equal(vector->capacity, 10);
+    assert_int_equal(vector->capacity, 16);
     char expectedChar = '0';
     for (size_t i = 0; i < 9; i++)
     {
@@ -335,6 +335,39 @@ static void test_types_vector_erase(void **state)
 
 static void test_types_vector_insert(void **state)
 {
+    Vector *vector = NULL;
+    int values[] = {100, 101};
+    Iterator first = types_iterator_create(values, sizeof(int));
+    Iterator last = types_iterator_increase(first, 2);
+
+    // Vector of integers, inserting in the middle
+    vector = create_integer_vector();
+    assert_int_equal(types_vector_insert(vector, first, last, types_iterator_increase(types_vector_begin(vector), 1)), CODE_OK);
+    assert_int_equal(vector->size, 12);
+    const int expected[] = {0, 100, 101, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    for (size_t i = 0; i < 12; i++)
+    {
+        assert_int_equal(*(int *)types_vector_at(vector, i), expected[i]);
+    }
+
+    // At the end, while the buffer grows and moves
+    for (size_t i = 0; i < 100; i++)
+    {
+        assert_int_equal(types_vector_insert(vector, first, last, types_vector_end(vector)), CODE_OK);
+    }
+    assert_int_equal(vector->size, 212);
+    assert_int_equal(*(int *)types_vector_at(vector, 210), 100);
+    assert_int_equal(*(int *)types_vector_at(vector, 211), 101);
+    assert_int_equal(types_vector_free(vector), CODE_OK);
+    free(vector);
+
+    // Into an empty vector, which has no buffer yet
+    vector = types_vector_create(sizeof(int), test_types_vector_int_free);
+    assert_int_equal(types_vector_insert(vector, first, last, types_vector_end(vector)), CODE_OK);
+    assert_int_equal(vector->size, 2);
+    assert_int_equal(*(int *)types_vector_at(vector, 1), 101);
+    assert_int_equal(types_vector_free(vector), CODE_OK);
+    free(vector);
 }
 
 static void test_types_vector_empty(void **state)
@@ -0,0 +1,314 @@
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "write.h"
+#include "document.h"
+#include "read/read.h"
+#include "node.h"
+#include "types/types_memory.h"
+
+static Node *test_write_create_scalar(const NodeType type, const char *literal)
+{
+    Node *node = node_create();
+    node->type = type;
+    if (literal != NULL)
+    {
+        node->data = types_string_create_from_literal(literal);
+    }
+    return node;
+}
+
+static Node *test_write_create_number(const double value)
+{
+    Node *node = node_create();
+    assert_int_equal(node_set_number(node, value), CODE_OK);
+    return node;
+}
+
+static void test_write_check(const Node *node, const char *expected)
+{
+    String *string = write_to_string(node);
+    assert_ptr_not_equal(string, NULL);
+    assert_string_equal(types_string_c_str(string), expected);
+    assert_int_equal(types_string_length(string), strlen(expected));
+    types_string_free(string);
+    free(string);
+}
+
+static void test_write_to_string_scalars(void **state)
+{
+    Node *node = test_write_create_scalar(NODE_TYPE_NULL, NULL);
+    test_write_check(node, "null");
+    node_destroy(node);
+    node = test_write_create_scalar(NODE_TYPE_TRUE, NULL);
+    test_write_check(node, "true");
+    node_destroy(node);
+    node = test_write_create_scalar(NODE_TYPE_FALSE, NULL);
+    test_write_check(node, "false");
+    node_destroy(node);
+    node = test_write_create_number(-12.5e3);
+    test_write_check(node, "-12500");
+    node_destroy(node);
+    node = test_write_create_number(0.1);
+    test_write_check(node, "0.1");
+    node_destroy(node);
+    node = test_write_create_scalar(NODE_TYPE_STRING, "hello");
+    test_write_check(node, "\"hello\"");
+    node_destroy(node);
+
+    // Characters that need to be escaped
+    node = test_write_create_scalar(NODE_TYPE_STRING, "a\"b\\c\nd\te\x01");
+    test_write_check(node, "\"a\\\"b\\\\c\\nd\\te\\u0001\"");
+    node_destroy(node);
+
+    // Invalid node
+    assert_ptr_equal(write_to_string(NULL), NULL);
+}
+
+static void test_write_to_string_containers(void **state)
+{
+    // Empty containers
+    Node *array = test_write_create_scalar(NODE_TYPE_ARRAY, NULL);
+    test_write_check(array, "[]");
+    Node *object = test_write_create_scalar(NODE_TYPE_OBJECT, NULL);
+    test_write_check(object, "{}");
+
+    // Nested containers
+    node_array_push(array, test_write_create_number(1));
+    node_array_push(array, test_write_create_scalar(NODE_TYPE_STRING, "two"));
+    node_array_push(array, test_write_create_scalar(NODE_TYPE_NULL, NULL));
+    String *key = types_string_create_from_literal("list");
+    node_append(object, key, array);
+    types_string_free(key);
+    free(key);
+    key = types_string_create_from_literal("k\"ey");
+    node_append(object, key, test_write_create_scalar(NODE_TYPE_TRUE, NULL));
+    types_string_free(key);
+    free(key);
+    test_write_check(object, "{\"list\":[1,\"two\",null],\"k\\\"ey\":true}");
+    node_destroy(object);
+}
+
+static void test_write_to_string_allocations(void **state)
+{
+    // Build a large array
+    Node *array = test_write_create_scalar(NODE_TYPE_ARRAY, NULL);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        node_array_push(array, test_write_create_scalar(NODE_TYPE_STRING, "some text"));
+    }
+
+    // The output buffer is reserved once, whatever the size of the tree
+    types_memory_reset();
+    String *string = write_to_string(array);
+    assert_ptr_not_equal(string, NULL);
+    assert_int_equal(types_string_length(string), 2 + 999 + 1000 * 11);
+    assert_int_equal(string->capacity, types_string_length(string) + 1);
+    assert_int_equal(types_memory_get(MEMORY_CATEGORY_STRING).allocations, 2);
+    types_string_free(string);
+    free(string);
+    node_destroy(array);
+}
+
+static void test_write_to_fd(void **state)
+{
+    // Build an array with enough data to flush several times, including
+    // a string longer than the internal buffer
+    Node *array = test_write_create_scalar(NODE_TYPE_ARRAY, NULL);
+    for (size_t i = 0; i < 20000; i++)
+    {
+        node_array_push(array, test_write_create_scalar(NODE_TYPE_STRING, "some \"text\""));
+        node_array_push(array, test_write_create_number(i / 8.0));
+    }
+    char *long_text = malloc(200001);
+    memset(long_text, 'x', 200000);
+    long_text[200000] = '\0';
+    node_array_push(array, test_write_create_scalar(NODE_TYPE_STRING, long_text));
+    free(long_text);
+
+    // Stream to a temporary file and read it back
+    FILE *file = tmpfile();
+    assert_ptr_not_equal(file, NULL);
+    assert_int_equal(write_to_fd(array, fileno(file)), CODE_OK);
+    const off_t length = lseek(fileno(file), 0, SEEK_CUR);
+    String *expected = write_to_string(array);
+    assert_int_equal(length, types_string_length(expected));
+    char *contents = malloc(length);
+    rewind(file);
+    assert_int_equal(fread(contents, 1, length, file), length);
+    assert_memory_equal(contents, types_string_c_str(expected), length);
+    free(contents);
+    fclose(file);
+    types_string_free(expected);
+    free(expected);
+    node_destroy(array);
+
+    // Invalid parameters
+    assert_int_equal(write_to_fd(NULL, 1), CODE_MEMORY_ERROR);
+    Node *node = test_write_create_scalar(NODE_TYPE_NULL, NULL);
+    assert_int_equal(write_to_fd(node, -1), CODE_WRITE_ERROR);
+    node_destroy(node);
+}
+
+static void test_write_to_string_escape_blocks(void **state)
+{
+    // Move a character that needs escaping across the blocks checked at once
+    char text[80];
+    char expected[90];
+    for (size_t position = 0; position < 70; position++)
+    {
+        memset(text, 'a', 70);
+        text[70] = '\0';
+        text[position] = position % 2 == 0 ? '\"' : '\n';
+        expected[0] = '\"';
+        memset(expected + 1, 'a', 71);
+        expected[1 + position] = '\\';
+        expected[2 + position] = position % 2 == 0 ? '\"' : 'n';
+        expected[72] = '\"';
+        expected[73] = '\0';
+        Node *node = test_write_create_scalar(NODE_TYPE_STRING, text);
+        test_write_check(node, expected);
+        node_destroy(node);
+    }
+
+    // Bytes of multi-byte UTF-8 characters are copied untouched
+    const char *utf8 = "\xc3\xb1" "and\xc3\xba \xe2\x82\xac \xf0\x9f\x98\x80 \xc3\xb1" "and\xc3\xba \xe2\x82\xac \xf0\x9f\x98\x80\x1f";
+    Node *node = test_write_create_scalar(NODE_TYPE_STRING, utf8);
+    test_write_check(node, "\"\xc3\xb1" "and\xc3\xba \xe2\x82\xac \xf0\x9f\x98\x80 \xc3\xb1" "and\xc3\xba \xe2\x82\xac \xf0\x9f\x98\x80\\u001f\"");
+    node_destroy(node);
+}
+
+// Document read from a text, keeping the text as its source
+static Document *test_write_read_document(const char *text)
+{
+    String *source = types_string_create_from_literal(text);
+    Node *root = read_from_string(source);
+    assert_ptr_not_equal(root, NULL);
+    return document_create(root, source);
+}
+
+static void test_write_document_check(const Document *document, const char *expected)
+{
+    String *string = write_document_to_string(document);
+    assert_ptr_not_equal(string, NULL);
+    assert_string_equal(types_string_c_str(string), expected);
+    types_string_free(string);
+    free(string);
+}
+
+static void test_write_document_verbatim(void **state)
+{
+    // Unchanged documents are written back exactly as they were read
+    const char *text = "{ \"a\" : [1.50, 2e3],\n  \"b\": {\"c\": \"\\u0041\"}, \"d\": true }";
+    Document *document = test_write_read_document(text);
+    test_write_document_check(document, text);
+
+    // Changing a value formats it again, and copies everything else
+    Node *new = node_create();
+    new->type = NODE_TYPE_FALSE;
+    assert_int_equal(node_set_data(node_get(document->root, &(String){"d", 1, 2}), new), CODE_OK);
+    node_destroy(new);
+    test_write_document_check(document, "{ \"a\" : [1.50, 2e3],\n  \"b\": {\"c\": \"\\u0041\"}, \"d\": false }");
+    document_free(document);
+
+    // Erasing a child
+    document = test_write_read_document("[ {\"x\": 1}, {\"y\" : 2}, [ 3 ] ]");
+    assert_int_equal(node_erase(node_array_get(document->root, 0)), CODE_OK);
+    test_write_document_check(document, "[{\"y\" : 2}, [ 3 ] ]");
+    document_free(document);
+
+    // Appending to a nested object
+    document = test_write_read_document("{\"a\": {\"b\": [ 1 ]}, \"c\": [ 2 ]}");
+    Node *child = node_create();
+    child->type = NODE_TYPE_TRUE;
+    Node *a = node_get(document->root, &(String){"a", 1, 2});
+    assert_int_equal(node_append(a, &(String){"n", 1, 2}, child), CODE_OK);
+    test_write_document_check(document, "{\"a\": {\"b\": [ 1 ],\"n\":true}, \"c\": [ 2 ]}");
+    document_free(document);
+
+    // Renaming a key formats the key alone, and keeps the text around it and the value
+    document = test_write_read_document("{ \"name\": \"m\",  \"version\" :1}");
+    assert_int_equal(node_set_key(node_get(document->root, &(String){"name", 4, 5}), &(String){"title", 5, 6}), CODE_OK);
+    test_write_document_check(document, "{ \"title\": \"m\",  \"version\" :1}");
+    assert_int_equal(node_set_key(node_get(document->root, &(String){"version", 7, 8}), &(String){"v", 1, 2}), CODE_OK);
+    test_write_document_check(document, "{ \"title\": \"m\",  \"v\" :1}");
+    document_free(document);
+    document = test_write_read_document("{\"a\": [ 1 , 2 ]}");
+    assert_int_equal(node_set_key(node_get(document->root, &(String){"a", 1, 2}), &(String){"z", 1, 2}), CODE_OK);
+    test_write_document_check(document, "{\"z\": [ 1 , 2 ]}");
+
+    // Values read from another text are formatted, since their spans mean nothing here
+    String *value_text = types_string_create_from_literal("[ 10 , 20 ]");
+    new = read_from_string(value_text);
+    assert_int_equal(node_set_data(node_get(document->root, &(String){"z", 1, 2}), new), CODE_OK);
+    node_destroy(new);
+    types_string_free(value_text);
+    free(value_text);
+    test_write_document_check(document, "{\"z\": [10,20]}");
+    document_free(document);
+
+    // Keys and numbers keep their original spelling in a container that changed
+    document = test_write_read_document("{\"\\u0041\" : 1.50, \"b\": 2, \"c\\\"\":\t3E0}");
+    assert_int_equal(node_erase(node_get(document->root, &(String){"b", 1, 2})), CODE_OK);
+    test_write_document_check(document, "{\"\\u0041\" : 1.50,\"c\\\"\":\t3E0}");
+    assert_int_equal(node_set_key(node_get(document->root, &(String){"A", 1, 2}), &(String){"A", 1, 2}), CODE_OK);
+    test_write_document_check(document, "{\"A\" : 1.50,\"c\\\"\":\t3E0}");
+    document_free(document);
+}
+
+static void test_write_document_to_file(void **state)
+{
+    // A large document where a single value changes
+    String *text = types_string_create_from_literal("[");
+    types_string_reserve(text, 5000 * 32);
+    for (size_t i = 0; i < 5000; i++)
+    {
+        String *element = types_string_create_from_literal(i == 0 ? "{\"id\": 0, \"name\": \"first\"}" : ", {\"id\": 1, \"name\": \"other\"}");
+        types_string_join_in_place(text, element);
+        types_string_free(element);
+        free(element);
+    }
+    String *end = types_string_create_from_literal("]");
+    types_string_join_in_place(text, end);
+    types_string_free(end);
+    free(end);
+
+    char filename[] = "/tmp/test_write_document_XXXXXX";
+    int fd = mkstemp(filename);
+    assert_true(fd >= 0);
+    assert_int_equal(write(fd, types_string_c_str(text), types_string_length(text)), types_string_length(text));
+    close(fd);
+
+    String *name = types_string_create_from_literal(filename);
+    Document *document = read_document(name);
+    assert_ptr_not_equal(document, NULL);
+    Node *new = node_create();
+    new->type = NODE_TYPE_NULL;
+    assert_int_equal(node_set_data(node_get(node_array_get(document->root, 0), &(String){"name", 4, 5}), new), CODE_OK);
+    node_destroy(new);
+
+    // The file is replaced by a whole new one, which keeps its permissions
+    struct stat before, after;
+    assert_int_equal(stat(filename, &before), 0);
+    assert_int_equal(write_document_to_file(document, name), CODE_OK);
+    assert_int_equal(stat(filename, &after), 0);
+    assert_int_not_equal(before.st_ino, after.st_ino);
+    assert_int_equal(after.st_mode & 0777, 0600);
+    document_free(document);
+    document = read_document(name);
+    assert_ptr_not_equal(document, NULL);
+    String *output = write_document_to_string(document);
+    assert_int_equal(types_string_length(output), types_string_length(text) - strlen("\"first\"") + strlen("null"));
+    assert_memory_equal(types_string_c_str(output), "[{\"id\": 0, \"name\": null}", 24);
+    assert_memory_equal(types_string_c_str(output) + 24, types_string_c_str(text) + 27, types_string_length(text) - 27);
+
+    types_string_free(output);
+    free(output);
+    document_free(document);
+    unlink(filename);
+    types_string_free(name);
+    free(name);
+    types_string_free(text);
+    free(text);
+}
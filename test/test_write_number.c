@@ -0,0 +1,89 @@
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "write_number.h"
+
+static void test_write_number_check(const double value, const char *expected)
+{
+    char buffer[WRITE_NUMBER_MAX_LENGTH + 1];
+    const size_t length = write_number_double(buffer, value);
+    assert_true(length <= WRITE_NUMBER_MAX_LENGTH);
+    buffer[length] = '\0';
+    assert_string_equal(buffer, expected);
+}
+
+static void test_write_number_double(void **state)
+{
+    // Integers
+    test_write_number_check(0, "0");
+    test_write_number_check(-0.0, "-0");
+    test_write_number_check(100, "100");
+    test_write_number_check(-123456789, "-123456789");
+    test_write_number_check(1e15, "1000000000000000");
+
+    // Shortest representation of values that have no exact binary form
+    test_write_number_check(0.1, "0.1");
+    test_write_number_check(0.3, "0.3");
+    test_write_number_check(-0.5, "-0.5");
+    test_write_number_check(1234.5678, "1234.5678");
+    test_write_number_check(1.0 / 3, "0.3333333333333333");
+    test_write_number_check(0.001, "0.001");
+
+    // Scientific notation for large and small exponents
+    test_write_number_check(1e21, "1e21");
+    test_write_number_check(1e-5, "1e-5");
+    test_write_number_check(-1.5e-7, "-1.5e-7");
+    test_write_number_check(1.2345678901234568e17, "1.2345678901234568e17");
+    test_write_number_check(1.7976931348623157e308, "1.7976931348623157e308");
+    test_write_number_check(5e-324, "5e-324");
+    test_write_number_check(2.2250738585072014e-308, "2.2250738585072014e-308");
+
+    // Values JSON cannot represent
+    test_write_number_check(NAN, "null");
+    test_write_number_check(INFINITY, "null");
+    test_write_number_check(-INFINITY, "null");
+}
+
+static void test_write_number_round_trip(void **state)
+{
+    // Every output reads back as the same value
+    char buffer[WRITE_NUMBER_MAX_LENGTH + 1];
+    srand(1234);
+    for (size_t i = 0; i < 100000; i++)
+    {
+        uint64_t bits = ((uint64_t)rand() << 62) ^ ((uint64_t)rand() << 31) ^ (uint64_t)rand();
+        double value;
+        memcpy(&value, &bits, sizeof(double));
+        if (isnan(value) || isinf(value))
+        {
+            continue;
+        }
+        const size_t length = write_number_double(buffer, value);
+        buffer[length] = '\0';
+        assert_true(strtod(buffer, NULL) == value);
+    }
+}
+
+static void test_write_number_integer(void **state)
+{
+    char buffer[WRITE_NUMBER_MAX_LENGTH + 1];
+    size_t length = write_number_integer(buffer, 0);
+    buffer[length] = '\0';
+    assert_string_equal(buffer, "0");
+    length = write_number_integer(buffer, 7);
+    buffer[length] = '\0';
+    assert_string_equal(buffer, "7");
+    length = write_number_integer(buffer, 10);
+    buffer[length] = '\0';
+    assert_string_equal(buffer, "10");
+    length = write_number_integer(buffer, -100);
+    buffer[length] = '\0';
+    assert_string_equal(buffer, "-100");
+    length = write_number_integer(buffer, INT64_MAX);
+    buffer[length] = '\0';
+    assert_string_equal(buffer, "9223372036854775807");
+    length = write_number_integer(buffer, INT64_MIN);
+    buffer[length] = '\0';
+    assert_string_equal(buffer, "-9223372036854775808");
+}